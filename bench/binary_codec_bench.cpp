@@ -0,0 +1,82 @@
+#include <benchmark/benchmark.h>
+#include "lib/json.h"
+#include <string>
+
+using cpputil::json::JsonParam;
+
+namespace {
+
+// 服务间常见的载荷：对象数组，混合整数、浮点、短字符串和布尔值
+const JsonParam& corpus() {
+    static const JsonParam js = [] {
+        std::string json = R"({"items": [)";
+        for (int i = 0; i < 2000; ++i) {
+            if (i > 0) {
+                json += ",";
+            }
+            json += R"({"id": )" + std::to_string(i * 7919) + R"(, "score": )" + std::to_string(i * 0.37) +
+                    R"(, "name": "item-)" + std::to_string(i) + R"(", "active": )" + (i % 3 ? "true" : "false") +
+                    R"(, "tags": ["a", "bb", "ccc"], "delta": )" + std::to_string(-i) + "}";
+        }
+        json += "]}";
+        return JsonParam(json);
+    }();
+    return js;
+}
+
+// 编码结果复用同一个字符串，只测编码本身
+template <typename Encode>
+void runEncode(benchmark::State& state, Encode encode) {
+    const JsonParam& js = corpus();
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        encode(js, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(out.size()));
+    state.counters["encoded_bytes"] = static_cast<double>(out.size());
+}
+
+template <typename Decode>
+void runDecode(benchmark::State& state, const std::string& data, Decode decode) {
+    for (auto _ : state) {
+        JsonParam decoded = decode(data);
+        benchmark::DoNotOptimize(decoded.isValid());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(data.size()));
+    state.counters["encoded_bytes"] = static_cast<double>(data.size());
+}
+
+void BM_EncodeText(benchmark::State& state) {
+    runEncode(state, [](const JsonParam& js, std::string& out) { js.writeTo(out); });
+}
+
+void BM_EncodeCbor(benchmark::State& state) {
+    runEncode(state, [](const JsonParam& js, std::string& out) { js.toCbor(out); });
+}
+
+void BM_EncodeMsgPack(benchmark::State& state) {
+    runEncode(state, [](const JsonParam& js, std::string& out) { js.toMsgPack(out); });
+}
+
+void BM_DecodeText(benchmark::State& state) {
+    runDecode(state, corpus().toString(), [](const std::string& data) { return JsonParam(data); });
+}
+
+void BM_DecodeCbor(benchmark::State& state) {
+    runDecode(state, corpus().toCbor(), [](const std::string& data) { return JsonParam::fromCbor(data).value(); });
+}
+
+void BM_DecodeMsgPack(benchmark::State& state) {
+    runDecode(state, corpus().toMsgPack(), [](const std::string& data) { return JsonParam::fromMsgPack(data).value(); });
+}
+
+} // namespace
+
+BENCHMARK(BM_EncodeText);
+BENCHMARK(BM_EncodeCbor);
+BENCHMARK(BM_EncodeMsgPack);
+BENCHMARK(BM_DecodeText);
+BENCHMARK(BM_DecodeCbor);
+BENCHMARK(BM_DecodeMsgPack);
@@ -0,0 +1,83 @@
+#include <benchmark/benchmark.h>
+#include "lib/json.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using cpputil::json::JsonArrayView;
+using cpputil::json::JsonParam;
+
+namespace {
+
+// {"values": [...]}，doubles 为 false 时生成整数
+std::string makeArray(int size, bool doubles) {
+    std::string json = R"({"values": [)";
+    for (int i = 0; i < size; ++i) {
+        if (i > 0) {
+            json += ",";
+        }
+        json += doubles ? std::to_string(i * 0.5 + 0.25) : std::to_string(i - size / 2);
+    }
+    json += "]}";
+    return json;
+}
+
+// 逐元素转换，等价于批量路径之前的 parseVector
+template <typename T>
+void runPerElement(benchmark::State& state, bool doubles) {
+    int size = static_cast<int>(state.range(0));
+    JsonParam js(makeArray(size, doubles));
+    for (auto _ : state) {
+        auto view = js.get<JsonArrayView<T>>({"values"});
+        std::vector<T> result;
+        result.reserve(view.size());
+        for (T value : view) {
+            result.push_back(value);
+        }
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+template <typename T>
+void runGetVector(benchmark::State& state, bool doubles) {
+    int size = static_cast<int>(state.range(0));
+    JsonParam js(makeArray(size, doubles));
+    for (auto _ : state) {
+        std::vector<T> result = js.get({"values"}, std::vector<T>{});
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+template <typename T>
+void runGetNumbers(benchmark::State& state, bool doubles) {
+    int size = static_cast<int>(state.range(0));
+    JsonParam js(makeArray(size, doubles));
+    std::vector<T> buffer(size);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(js.getNumbers({"values"}, buffer.data(), buffer.size()));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+void BM_PerElementDouble(benchmark::State& state) { runPerElement<double>(state, true); }
+void BM_GetVectorDouble(benchmark::State& state) { runGetVector<double>(state, true); }
+void BM_GetNumbersDouble(benchmark::State& state) { runGetNumbers<double>(state, true); }
+void BM_GetNumbersFloat(benchmark::State& state) { runGetNumbers<float>(state, true); }
+void BM_PerElementInt(benchmark::State& state) { runPerElement<int>(state, false); }
+void BM_GetVectorInt(benchmark::State& state) { runGetVector<int>(state, false); }
+void BM_GetNumbersInt32(benchmark::State& state) { runGetNumbers<int32_t>(state, false); }
+void BM_GetNumbersInt64(benchmark::State& state) { runGetNumbers<int64_t>(state, false); }
+
+} // namespace
+
+BENCHMARK(BM_PerElementDouble)->RangeMultiplier(32)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_GetVectorDouble)->RangeMultiplier(32)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_GetNumbersDouble)->RangeMultiplier(32)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_GetNumbersFloat)->RangeMultiplier(32)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_PerElementInt)->RangeMultiplier(32)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_GetVectorInt)->RangeMultiplier(32)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_GetNumbersInt32)->RangeMultiplier(32)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_GetNumbersInt64)->RangeMultiplier(32)->Range(1 << 10, 1 << 20);
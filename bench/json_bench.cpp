@@ -0,0 +1,312 @@
+#include <benchmark/benchmark.h>
+#include "lib/json.h"
+#include "lib/json_path_cache.h"
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using cpputil::json::JsonParam;
+using cpputil::json::JsonParamPtr;
+using cpputil::json::JsonPath;
+using cpputil::json::JsonPathCache;
+
+namespace {
+
+// 一条记录约 150 字节
+std::string makeRecord(size_t i) {
+    std::string id = std::to_string(i);
+    return R"({"id": )" + id + R"(, "name": "user-)" + id + R"(", "score": )" + std::to_string(i * 0.25) +
+           R"(, "active": )" + (i % 2 ? "true" : "false") + R"(, "tags": ["alpha", "beta"],)" +
+           R"( "address": {"city": "city-)" + std::to_string(i % 97) + R"(", "zip": )" + std::to_string(10000 + i) +
+           "}}";
+}
+
+struct Document {
+    std::string text;
+    size_t records = 0;
+};
+
+// 约 bytes 字节的文档 {"records": [...]}，按大小缓存，100MB 的文档只生成一次
+const Document& document(size_t bytes) {
+    static std::map<size_t, Document> cache;
+    Document& doc = cache[bytes];
+    if (doc.text.empty()) {
+        doc.text = R"({"records": [)";
+        while (doc.text.size() < bytes) {
+            if (doc.records > 0) {
+                doc.text += ",";
+            }
+            doc.text += makeRecord(doc.records++);
+        }
+        doc.text += "]}";
+    }
+    return doc;
+}
+
+// 约 bytes 字节、以 id 为键的文档 {"u0": {...}, "u1": {...}}，以及为每条记录
+// 覆盖 score、active 和 address.zip 的 overlay。overlay 中没有数组，
+// update 时每个键都命中并覆盖，文档大小不变
+struct KeyedDocument {
+    std::string text;
+    std::string overlay;
+    size_t records = 0;
+};
+
+const KeyedDocument& keyedDocument(size_t bytes) {
+    static std::map<size_t, KeyedDocument> cache;
+    KeyedDocument& doc = cache[bytes];
+    if (doc.text.empty()) {
+        doc.text = "{";
+        doc.overlay = "{";
+        while (doc.text.size() < bytes) {
+            if (doc.records > 0) {
+                doc.text += ",";
+                doc.overlay += ",";
+            }
+            std::string key = "\"u" + std::to_string(doc.records) + "\": ";
+            doc.text += key + makeRecord(doc.records);
+            doc.overlay += key + R"({"score": -1, "active": true, "address": {"zip": 0}})";
+            ++doc.records;
+        }
+        doc.text += "}";
+        doc.overlay += "}";
+    }
+    return doc;
+}
+
+// 1KB 到 100MB
+void documentSizes(benchmark::internal::Benchmark* b) {
+    for (int64_t bytes : {int64_t(1) << 10, int64_t(64) << 10, int64_t(1) << 20, int64_t(16) << 20,
+                          int64_t(100) << 20}) {
+        b->Arg(bytes);
+    }
+    b->ArgName("bytes");
+}
+
+// {"k0": 0, "k1": 1, ...}
+std::string makeWideObject(size_t width) {
+    std::string json = "{";
+    for (size_t i = 0; i < width; ++i) {
+        if (i > 0) {
+            json += ",";
+        }
+        json += "\"k" + std::to_string(i) + "\": " + std::to_string(i);
+    }
+    json += "}";
+    return json;
+}
+
+// {"n": {"n": ... {"v": 1}}}，路径为 depth 个 "n" 加上 "v"
+std::string makeDeepObject(size_t depth) {
+    std::string json;
+    for (size_t i = 0; i < depth; ++i) {
+        json += R"({"n": )";
+    }
+    json += R"({"v": 1})";
+    json += std::string(depth, '}');
+    return json;
+}
+
+JsonPath deepPath(size_t depth) {
+    JsonPath path;
+    for (size_t i = 0; i < depth; ++i) {
+        path.add("n");
+    }
+    path.add("v");
+    return path;
+}
+
+// 打乱访问顺序，避免总是命中成员列表前部
+std::vector<std::string> shuffledKeys(size_t width) {
+    std::vector<std::string> keys;
+    keys.reserve(width);
+    for (size_t i = 0; i < width; ++i) {
+        keys.push_back("k" + std::to_string((i * 7919) % width));
+    }
+    return keys;
+}
+
+void BM_Parse(benchmark::State& state) {
+    const Document& doc = document(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        JsonParam js(doc.text);
+        benchmark::DoNotOptimize(js.isValid());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(doc.text.size()));
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(doc.records));
+}
+
+void BM_Serialize(benchmark::State& state) {
+    const Document& doc = document(static_cast<size_t>(state.range(0)));
+    JsonParam js(doc.text);
+    size_t bytes = 0;
+    for (auto _ : state) {
+        std::string out = js.toString();
+        bytes = out.size();
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(bytes));
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(doc.records));
+}
+
+// clone 与来源共享子树，只测复制本身
+void BM_Clone(benchmark::State& state) {
+    const Document& doc = document(static_cast<size_t>(state.range(0)));
+    JsonParam js(doc.text);
+    for (auto _ : state) {
+        JsonParamPtr copy = js.clone();
+        benchmark::DoNotOptimize(copy.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// clone 后写一条记录：只复制被写路径上的容器
+void BM_CloneThenSet(benchmark::State& state) {
+    const Document& doc = document(static_cast<size_t>(state.range(0)));
+    JsonParam js(doc.text);
+    size_t i = 0;
+    for (auto _ : state) {
+        JsonParamPtr copy = js.clone();
+        copy->set({"records", i % doc.records, "score"}, 1.0);
+        benchmark::DoNotOptimize(copy.get());
+        ++i;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// 以 id 为键的大对象上合并同样规模的 overlay，每个键都命中并覆盖。
+// 顶层对象的成员数与记录数相同，开启成员索引，clone 与来源共享索引
+void BM_Update(benchmark::State& state) {
+    const KeyedDocument& doc = keyedDocument(static_cast<size_t>(state.range(0)));
+    JsonParam base(doc.text);
+    base.enableMemberIndex();
+    JsonParam overlay(doc.overlay);
+    for (auto _ : state) {
+        JsonParamPtr target = base.clone();
+        target->update(overlay);
+        benchmark::DoNotOptimize(target.get());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(doc.overlay.size()));
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(doc.records));
+}
+
+// {"records": [...]} 合并同样的文档：数组被追加，结果是原来的两倍
+void BM_UpdateAppend(benchmark::State& state) {
+    const Document& doc = document(static_cast<size_t>(state.range(0)));
+    JsonParam base(doc.text);
+    JsonParam overlay(doc.text);
+    for (auto _ : state) {
+        JsonParamPtr target = base.clone();
+        target->update(overlay);
+        benchmark::DoNotOptimize(target.get());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(doc.text.size()));
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(doc.records));
+}
+
+void BM_GetByDepth(benchmark::State& state) {
+    size_t depth = static_cast<size_t>(state.range(0));
+    JsonParam js(makeDeepObject(depth));
+    JsonPath path = deepPath(depth);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(js.get(path, 0));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// 同样的路径以字符串给出，每次查找都经过缓存，与 BM_GetByDepth 对比
+void BM_GetByCachedPath(benchmark::State& state) {
+    size_t depth = static_cast<size_t>(state.range(0));
+    JsonParam js(makeDeepObject(depth));
+    std::string text;
+    for (size_t i = 0; i < depth; ++i) {
+        text += "n.";
+    }
+    text += "v";
+    JsonPathCache cache;
+    for (auto _ : state) {
+        JsonPathCache::PathPtr path = cache.get(text);
+        benchmark::DoNotOptimize(js.get(*path, 0));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_GetByWidth(benchmark::State& state) {
+    size_t width = static_cast<size_t>(state.range(0));
+    JsonParam js(makeWideObject(width));
+    std::vector<std::string> keys = shuffledKeys(width);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(js.get({keys[i]}, -1));
+        i = (i + 1) % keys.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// 路径不存在时的查找
+void BM_GetMiss(benchmark::State& state) {
+    size_t width = static_cast<size_t>(state.range(0));
+    JsonParam js(makeWideObject(width));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(js.get({"missing"}, -1));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// 覆盖已有成员的值
+void BM_SetExisting(benchmark::State& state) {
+    size_t width = static_cast<size_t>(state.range(0));
+    JsonParam js(makeWideObject(width));
+    std::vector<std::string> keys = shuffledKeys(width);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(js.set({keys[i]}, static_cast<int>(i)));
+        i = (i + 1) % keys.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// 每次 set 都在根下以不同的键开头，新建 depth 层对象；文档定期重建，使根保持较小
+void BM_SetCreate(benchmark::State& state) {
+    size_t depth = static_cast<size_t>(state.range(0));
+    constexpr size_t kPathsPerDocument = 64;
+    std::vector<JsonPath> paths;
+    for (const std::string& key : shuffledKeys(kPathsPerDocument)) {
+        JsonPath path;
+        path.add(key);
+        for (size_t d = 1; d < depth; ++d) {
+            path.add("n");
+        }
+        path.add("v");
+        paths.push_back(std::move(path));
+    }
+    JsonParam js("{}");
+    size_t i = 0;
+    for (auto _ : state) {
+        if (i == kPathsPerDocument) {
+            state.PauseTiming();
+            js = JsonParam("{}");
+            i = 0;
+            state.ResumeTiming();
+        }
+        benchmark::DoNotOptimize(js.set(paths[i], 1));
+        ++i;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK(BM_Parse)->Apply(documentSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Serialize)->Apply(documentSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Clone)->Apply(documentSizes);
+BENCHMARK(BM_CloneThenSet)->Apply(documentSizes);
+BENCHMARK(BM_Update)->Apply(documentSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_UpdateAppend)->Apply(documentSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_GetByDepth)->RangeMultiplier(4)->Range(1, 64)->ArgName("depth");
+BENCHMARK(BM_GetByCachedPath)->RangeMultiplier(4)->Range(1, 64)->ArgName("depth");
+BENCHMARK(BM_GetByWidth)->RangeMultiplier(8)->Range(8, 32768)->ArgName("width");
+BENCHMARK(BM_GetMiss)->RangeMultiplier(8)->Range(8, 32768)->ArgName("width");
+BENCHMARK(BM_SetExisting)->RangeMultiplier(8)->Range(8, 32768)->ArgName("width");
+BENCHMARK(BM_SetCreate)->RangeMultiplier(4)->Range(1, 16)->ArgName("depth");
@@ -0,0 +1,78 @@
+#include <benchmark/benchmark.h>
+#include "lib/json.h"
+#include <string>
+#include <vector>
+
+using cpputil::json::JsonParam;
+
+namespace {
+
+// {"tenants": {"k0": 0, "k1": 1, ...}}
+std::string makeWideObject(int width) {
+    std::string json = R"({"tenants": {)";
+    for (int i = 0; i < width; ++i) {
+        if (i > 0) {
+            json += ",";
+        }
+        json += "\"k" + std::to_string(i) + "\": " + std::to_string(i);
+    }
+    json += "}}";
+    return json;
+}
+
+std::vector<std::string> makeKeys(int width) {
+    std::vector<std::string> keys;
+    keys.reserve(width);
+    for (int i = 0; i < width; ++i) {
+        // 打乱访问顺序，避免总是命中成员列表前部
+        keys.push_back("k" + std::to_string((i * 7919) % width));
+    }
+    return keys;
+}
+
+void runLookup(benchmark::State& state, bool indexed) {
+    int width = static_cast<int>(state.range(0));
+    JsonParam js(makeWideObject(width));
+    if (indexed) {
+        js.enableMemberIndex();
+    }
+    std::vector<std::string> keys = makeKeys(width);
+    
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(js.get({"tenants", keys[i]}, -1));
+        i = (i + 1) % keys.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void runUpdate(benchmark::State& state, bool indexed) {
+    int width = static_cast<int>(state.range(0));
+    std::string base_json = makeWideObject(width);
+    // 覆盖 1/10 的已有 key
+    JsonParam overlay(makeWideObject(width / 10));
+    
+    for (auto _ : state) {
+        state.PauseTiming();
+        JsonParam base(base_json);
+        if (indexed) {
+            base.enableMemberIndex();
+        }
+        state.ResumeTiming();
+        base.update(overlay);
+        benchmark::DoNotOptimize(base);
+    }
+    state.SetItemsProcessed(state.iterations() * (width / 10));
+}
+
+void BM_MemberLookupLinear(benchmark::State& state) { runLookup(state, false); }
+void BM_MemberLookupIndexed(benchmark::State& state) { runLookup(state, true); }
+void BM_MemberUpdateLinear(benchmark::State& state) { runUpdate(state, false); }
+void BM_MemberUpdateIndexed(benchmark::State& state) { runUpdate(state, true); }
+
+} // namespace
+
+BENCHMARK(BM_MemberLookupLinear)->RangeMultiplier(8)->Range(8, 32768);
+BENCHMARK(BM_MemberLookupIndexed)->RangeMultiplier(8)->Range(8, 32768);
+BENCHMARK(BM_MemberUpdateLinear)->RangeMultiplier(8)->Range(64, 32768);
+BENCHMARK(BM_MemberUpdateIndexed)->RangeMultiplier(8)->Range(64, 32768);
@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+#include "lib/json.h"
+#include <string>
+
+using cpputil::json::JsonParam;
+using cpputil::json::ParseKernel;
+
+namespace {
+
+// 缩进很深的多行文本，大部分字节是空白
+std::string makeWhitespaceHeavy(int records) {
+    const std::string indent(48, ' ');
+    std::string json = "[\n";
+    for (int i = 0; i < records; ++i) {
+        json += indent + "{\n";
+        json += indent + indent + "\"id\" :\t" + std::to_string(i) + " ,\r\n";
+        json += indent + indent + "\"ok\" :\t" + (i % 2 ? "true" : "false") + "\n";
+        json += indent + "}" + (i + 1 < records ? "," : "") + "\n";
+    }
+    json += "]\n";
+    return json;
+}
+
+// 长字符串值，偶尔带转义
+std::string makeStringHeavy(int records) {
+    std::string json = "[";
+    for (int i = 0; i < records; ++i) {
+        if (i > 0) {
+            json += ",";
+        }
+        json += "{\"name\":\"" + std::string(200, static_cast<char>('a' + i % 26)) + "\",";
+        json += "\"note\":\"" + std::string(120, 'n') + (i % 8 == 0 ? "\\n\\\"quoted\\\"" : "") + "\"}";
+    }
+    json += "]";
+    return json;
+}
+
+// 固定内核解析同一份文本；内核不可用时跳过
+void runParse(benchmark::State& state, ParseKernel kernel, const std::string& json) {
+    ParseKernel original = cpputil::json::parseKernel();
+    if (!cpputil::json::setParseKernel(kernel)) {
+        state.SkipWithError("parse kernel not available (build with --config=simd on x86-64)");
+        return;
+    }
+    for (auto _ : state) {
+        JsonParam js(json);
+        benchmark::DoNotOptimize(js.isValid());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(json.size()));
+    cpputil::json::setParseKernel(original);
+}
+
+const std::string& whitespaceCorpus() {
+    static const std::string json = makeWhitespaceHeavy(4096);
+    return json;
+}
+
+const std::string& stringCorpus() {
+    static const std::string json = makeStringHeavy(4096);
+    return json;
+}
+
+void BM_WhitespaceScalar(benchmark::State& state) { runParse(state, ParseKernel::kScalar, whitespaceCorpus()); }
+void BM_WhitespaceSse2(benchmark::State& state) { runParse(state, ParseKernel::kSse2, whitespaceCorpus()); }
+void BM_WhitespaceSse42(benchmark::State& state) { runParse(state, ParseKernel::kSse42, whitespaceCorpus()); }
+void BM_StringsScalar(benchmark::State& state) { runParse(state, ParseKernel::kScalar, stringCorpus()); }
+void BM_StringsSse2(benchmark::State& state) { runParse(state, ParseKernel::kSse2, stringCorpus()); }
+void BM_StringsSse42(benchmark::State& state) { runParse(state, ParseKernel::kSse42, stringCorpus()); }
+
+} // namespace
+
+BENCHMARK(BM_WhitespaceScalar);
+BENCHMARK(BM_WhitespaceSse2);
+BENCHMARK(BM_WhitespaceSse42);
+BENCHMARK(BM_StringsScalar);
+BENCHMARK(BM_StringsSse2);
+BENCHMARK(BM_StringsSse42);
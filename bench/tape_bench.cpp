@@ -0,0 +1,123 @@
+#include <benchmark/benchmark.h>
+#include "lib/json.h"
+#include "lib/json_tape.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+using cpputil::json::JsonParam;
+using cpputil::json::JsonTapeView;
+
+namespace {
+
+// 启动时写出的参考数据：按 id 索引的大对象。文件放在独立的临时目录中（bazel run 时
+// 位于 TEST_TMPDIR 下），并发运行互不覆盖，进程退出时删除
+struct Files {
+    std::string dir;
+    std::string json;
+    std::string tape;
+    bool ok = false;
+
+    Files() {
+        const char* tmp = std::getenv("TEST_TMPDIR");
+        std::string pattern = std::string(tmp && *tmp ? tmp : "/tmp") + "/tape_bench.XXXXXX";
+        if (!mkdtemp(&pattern[0])) {
+            return;
+        }
+        dir = pattern;
+        json = dir + "/data.json";
+        tape = dir + "/data.tape";
+
+        std::string text = "{";
+        for (int i = 0; i < 200000; ++i) {
+            if (i > 0) {
+                text += ",";
+            }
+            text += "\"id" + std::to_string(i) + R"(": {"name": "entry-)" + std::to_string(i) +
+                    R"(", "weight": )" + std::to_string(i * 0.5) + R"(, "tags": ["x", "y"]})";
+        }
+        text += "}";
+        JsonParam js(text);
+        ok = js.toFile(json) && JsonTapeView::writeFile(js, tape);
+    }
+
+    ~Files() {
+        if (!dir.empty()) {
+            std::remove(json.c_str());
+            std::remove(tape.c_str());
+            rmdir(dir.c_str());
+        }
+    }
+
+    Files(const Files&) = delete;
+    Files& operator=(const Files&) = delete;
+};
+
+const Files& files() {
+    static const Files paths;
+    return paths;
+}
+
+// 数据写出失败时跳过，返回 nullptr
+const Files* filesOrSkip(benchmark::State& state) {
+    const Files& paths = files();
+    if (!paths.ok) {
+        state.SkipWithError("failed to write benchmark files");
+        return nullptr;
+    }
+    return &paths;
+}
+
+// 加载后读取一个字段，模拟启动后的首次查询
+void BM_LoadParse(benchmark::State& state) {
+    const Files* paths = filesOrSkip(state);
+    if (!paths) {
+        return;
+    }
+    for (auto _ : state) {
+        JsonParam js = JsonParam::fromFile(paths->json);
+        benchmark::DoNotOptimize(js.get({"id123456", "weight"}, 0.0));
+    }
+}
+
+void BM_LoadTape(benchmark::State& state) {
+    const Files* paths = filesOrSkip(state);
+    if (!paths) {
+        return;
+    }
+    for (auto _ : state) {
+        JsonTapeView tape = JsonTapeView::open(paths->tape);
+        benchmark::DoNotOptimize(tape.get({"id123456", "weight"}, 0.0));
+    }
+}
+
+// 已加载后的单次按键查找
+void BM_LookupParam(benchmark::State& state) {
+    const Files* paths = filesOrSkip(state);
+    if (!paths) {
+        return;
+    }
+    JsonParam js = JsonParam::fromFile(paths->json);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(js.get({"id123456", "name"}, std::string_view()));
+    }
+}
+
+void BM_LookupTape(benchmark::State& state) {
+    const Files* paths = filesOrSkip(state);
+    if (!paths) {
+        return;
+    }
+    JsonTapeView tape = JsonTapeView::open(paths->tape);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tape.get({"id123456", "name"}, std::string_view()));
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_LoadParse)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadTape)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_LookupParam);
+BENCHMARK(BM_LookupTape);
@@ -1,62 +1,442 @@
 #include "json.h"
+#include "json_arena.h"
+#include "json_member_index.h"
+#include "json_stats_recorder.h"
 #include <rapidjson/document.h>
 #include <rapidjson/error/en.h>
-#include <rapidjson/stringbuffer.h>
-#include <rapidjson/writer.h>
+#include <rapidjson/memorystream.h>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <variant>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <map>
 #include <unordered_map>
 
 namespace cpputil {
 namespace json {
 
-JsonParam::JsonParam(const std::string& json_str) : doc_(std::make_unique<rapidjson::Document>()) {
-    if (doc_->Parse(json_str.c_str()).HasParseError()) {
-        std::cerr << "JSON parse error: " << rapidjson::GetParseError_En(doc_->GetParseError()) 
-                  << " at offset " << doc_->GetErrorOffset() << std::endl;
+namespace {
+
+// 默认构造的 string_view 的 data() 为空指针，RapidJSON 不接受
+inline const char* keyData(std::string_view key) {
+    return key.data() ? key.data() : "";
+}
+
+// 以 string_view 构造不拷贝、不要求 '\0' 结尾的 key，供 FindMember 使用
+inline rapidjson::Value keyRef(std::string_view key) {
+    return rapidjson::Value(rapidjson::StringRef(keyData(key), key.size()));
+}
+
+// 容器子节点所在的存储，空容器可能为空指针
+inline const void* storageOf(const rapidjson::Value& value) {
+    if (value.IsObject()) {
+        return value.MemberBegin().operator->();
+    }
+    return value.IsArray() ? value.Begin() : nullptr;
+}
+
+// 数值数组批量转换，n 为数组长度，有元素无法转换时返回 false。
+// 先按最常见的表示（浮点输出对应 double 节点，整数输出对应 int 节点）跑每个元素
+// 只判断一次标志位的紧凑循环，遇到其他表示再转入逐元素分支的循环。
+// 数组是否同构没有单独的预检，转换失败前 out 中可能已写入一部分。
+// kAnyNumber 为 false 时浮点输出只接受 double 与 int 节点，与 get<double> 的规则一致
+template <typename T, bool kAnyNumber>
+bool convertNumbers(const rapidjson::Value& array, T* out) {
+    const rapidjson::Value* elements = array.Begin();
+    const rapidjson::SizeType n = array.Size();
+    rapidjson::SizeType i = 0;
+    if constexpr (std::is_floating_point_v<T>) {
+        for (; i < n && elements[i].IsDouble(); ++i) {
+            out[i] = static_cast<T>(elements[i].GetDouble());
+        }
+        for (; i < n; ++i) {
+            const rapidjson::Value& element = elements[i];
+            if (element.IsDouble()) {
+                out[i] = static_cast<T>(element.GetDouble());
+            } else if (element.IsInt()) {
+                out[i] = static_cast<T>(element.GetInt());
+            } else if (kAnyNumber && element.IsNumber()) {
+                out[i] = static_cast<T>(element.GetDouble());
+            } else {
+                return false;
+            }
+        }
+    } else if constexpr (std::is_same_v<T, int32_t>) {
+        for (; i < n && elements[i].IsInt(); ++i) {
+            out[i] = elements[i].GetInt();
+        }
+    } else {
+        static_assert(std::is_same_v<T, int64_t>, "unsupported numeric type");
+        for (; i < n && elements[i].IsInt64(); ++i) {
+            out[i] = elements[i].GetInt64();
+        }
+    }
+    return i == n;
+}
+
+} // namespace
+
+std::string JsonParseError::message() const {
+    if (ok()) {
+        return std::string();
+    }
+    return std::string(reason ? reason : rapidjson::GetParseError_En(code)) + " at offset " + std::to_string(offset);
+}
+
+JsonParam::JsonParam(const std::string& json_str) : doc_(std::make_shared<rapidjson::Document>()) {
+    // 非原地解析只读取 json，不会修改它
+    reportParseError(parseTerminated(const_cast<char*>(json_str.c_str()), false));
+}
+
+JsonParam::JsonParam(const char* json_str) : doc_(std::make_shared<rapidjson::Document>()) {
+    reportParseError(parseTerminated(const_cast<char*>(json_str ? json_str : ""), false));
+}
+
+JsonParam::JsonParam(std::string_view json) : JsonParam(json.data(), json.size()) {}
+
+JsonParam::JsonParam(const char* data, size_t length) : doc_(std::make_shared<rapidjson::Document>()) {
+    reportParseError(parseLength(data, length));
+}
+
+JsonParam::JsonParam(std::unique_ptr<char[]> buffer) : doc_(std::make_shared<rapidjson::Document>()) {
+    std::shared_ptr<char[]> owned(std::move(buffer));
+    char* data = owned.get();
+    reportParseError(parseAnchored(data, std::move(owned)));
+}
+
+JsonParseResult JsonParam::parse(const std::string& json) {
+    JsonParseResult result;
+    result.value_.doc_ = std::make_shared<rapidjson::Document>();
+    result.error_ = result.value_.parseTerminated(const_cast<char*>(json.c_str()), false);
+    return result;
+}
+
+JsonParseResult JsonParam::parse(const char* json) {
+    JsonParseResult result;
+    result.value_.doc_ = std::make_shared<rapidjson::Document>();
+    result.error_ = result.value_.parseTerminated(const_cast<char*>(json ? json : ""), false);
+    return result;
+}
+
+JsonParseResult JsonParam::parse(std::string_view json) {
+    JsonParseResult result;
+    result.value_.doc_ = std::make_shared<rapidjson::Document>();
+    result.error_ = result.value_.parseLength(json.data(), json.size());
+    return result;
+}
+
+JsonParseResult JsonParam::parseInsitu(std::string buffer) {
+    JsonParseResult result;
+    result.value_.doc_ = std::make_shared<rapidjson::Document>();
+    auto owned = std::make_shared<std::string>(std::move(buffer));
+    char* data = &(*owned)[0];
+    result.error_ = result.value_.parseAnchored(data, std::move(owned));
+    return result;
+}
+
+JsonParseError JsonParam::parseAnchored(char* buffer, std::shared_ptr<const void> anchor) {
+    if (!buffer) {
+        doc_.reset();
+        return JsonParseError{rapidjson::kParseErrorDocumentEmpty, 0};
+    }
+    JsonParseError error = parseTerminated(buffer, true);
+    if (isValid()) {
+        anchors_.push_back(std::move(anchor));
+    }
+    return error;
+}
+
+JsonParseError JsonParam::parseLength(const char* data, size_t length) {
+    stats::OpTimer timer(JsonOp::kParse);
+    // 带长度的 Parse 通过 MemoryStream 读取，不依赖 '\0' 结尾
+    doc_->Parse(data ? data : "", length);
+    JsonParseError error = takeParseError();
+    timer.fail(!error.ok());
+    return error;
+}
+
+JsonParseError JsonParam::takeParseError() {
+    JsonParseError error;
+    if (doc_ && doc_->HasParseError()) {
+        error.code = doc_->GetParseError();
+        error.offset = doc_->GetErrorOffset();
+        doc_.reset();
+    }
+    return error;
+}
+
+void JsonParam::reportParseError(const JsonParseError& error) {
+    if (!error.ok()) {
+        std::cerr << "JSON parse error: " << error.message() << std::endl;
+    }
+}
+
+void JsonParam::adoptAnchors(const JsonParam& other) {
+    for (const auto& anchor : other.anchors_) {
+        if (std::find(anchors_.begin(), anchors_.end(), anchor) == anchors_.end()) {
+            anchors_.push_back(anchor);
+        }
+    }
+}
+
+// MemoryPoolAllocator 从不逐个释放，同一存储被多个值引用是安全的
+void JsonParam::shallowCopy(const rapidjson::Value& src, rapidjson::Value& dst) {
+    std::memcpy(static_cast<void*>(&dst), static_cast<const void*>(&src), sizeof(rapidjson::Value));
+}
+
+bool JsonParam::usesArena() const {
+    return doc_ && arena_ && &doc_->GetAllocator() == &arena_->allocator();
+}
+
+void JsonParam::shareFrom(const JsonParam& other, const rapidjson::Value& value) {
+    doc_ = std::make_shared<rapidjson::Document>();
+    anchors_ = other.anchors_;
+    merge_allocators_.clear();
+    owned_.clear();
+    if (other.usesArena()) {
+        // arena 的内存会被来源的下一次 reset 回收，不能共享
+        doc_->CopyFrom(value, doc_->GetAllocator());
+        share_epoch_.store(0, std::memory_order_relaxed);
+        return;
+    }
+    // 共享后双方都不能再原地修改已有的容器
+    shallowCopy(value, *doc_);
+    anchors_.push_back(other.doc_);
+    other.share_epoch_.fetch_add(1, std::memory_order_relaxed);
+    share_epoch_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void JsonParam::inheritMemberIndex(const JsonParam& other) {
+    if (!other.member_index_) {
+        member_index_.reset();
+    } else if (other.usesArena()) {
+        // shareFrom 深拷贝了 arena 中的值。表以来源 arena 中的成员数组地址为键，
+        // 那块内存被来源复用后，本对象的新数组可能恰好落在同一地址，表不能沿用
+        member_index_ = std::make_unique<JsonMemberIndex>(other.member_index_->threshold());
+    } else {
+        member_index_ = std::make_unique<JsonMemberIndex>(*other.member_index_);
+    }
+}
+
+void JsonParam::adoptDocument(JsonParam& other) {
+    adoptAnchors(other);
+    if (other.share_epoch_.load(std::memory_order_relaxed) != 0) {
+        // other 的存储可能还被它的克隆引用，移入的值不能原地修改
+        share_epoch_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (other.arena_) {
+        anchors_.push_back(std::shared_ptr<const JsonArena>(std::move(other.arena_)));
+    }
+    anchors_.push_back(std::move(other.doc_));
+    other.anchors_.clear();
+    other.merge_allocators_.clear();
+    other.owned_.clear();
+    ++other.generation_;
+}
+
+void JsonParam::transferValue(const rapidjson::Value& src, rapidjson::Value& dst, bool steal) {
+    dropMemberIndex(dst);
+    if (steal) {
+        shallowCopy(src, dst);
+    } else {
+        dst.CopyFrom(src, doc_->GetAllocator());
+    }
+}
+
+void JsonParam::unshare(rapidjson::Value& value) {
+    uint64_t epoch = share_epoch_.load(std::memory_order_relaxed);
+    if (epoch == 0) {
+        return;
+    }
+    const void* storage = storageOf(value);
+    if (!storage) {
+        return;
+    }
+    if (owned_epoch_ != epoch) {
+        // 又被共享过一次，之前独有的存储也可能被引用了
+        owned_.clear();
+        owned_epoch_ = epoch;
+    }
+    if (owned_.count(storage)) {
+        return;
+    }
+    
+    // 只复制这一层：子节点的头部按位复制，它们的子树继续共享，索引仍然有效
+    auto& allocator = doc_->GetAllocator();
+    rapidjson::Value copy;
+    if (value.IsObject()) {
+        copy.SetObject();
+        for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+            rapidjson::Value name;
+            rapidjson::Value child;
+            shallowCopy(it->name, name);
+            shallowCopy(it->value, child);
+            copy.AddMember(name, child, allocator);
+        }
+    } else {
+        copy.SetArray();
+        copy.Reserve(value.Size(), allocator);
+        for (auto it = value.Begin(); it != value.End(); ++it) {
+            rapidjson::Value child;
+            shallowCopy(*it, child);
+            copy.PushBack(child, allocator);
+        }
+    }
+    value = copy;
+    if (member_index_ && value.IsObject()) {
+        member_index_->rebase(storage, value);
+    }
+    markOwned(value);
+}
+
+void JsonParam::markOwned(const rapidjson::Value& value) {
+    uint64_t epoch = share_epoch_.load(std::memory_order_relaxed);
+    if (epoch == 0) {
+        return;
+    }
+    if (owned_epoch_ != epoch) {
+        owned_.clear();
+        owned_epoch_ = epoch;
+    }
+    if (const void* storage = storageOf(value)) {
+        owned_.insert(storage);
+    }
+}
+
+JsonParseError JsonParam::reset(std::string_view json) {
+    stats::OpTimer timer(JsonOp::kParse);
+    ++generation_;
+    // 旧值即将失效，索引、外部存储和共享状态一并丢弃
+    if (member_index_) {
+        member_index_->clear();
+    }
+    anchors_.clear();
+    merge_allocators_.clear();
+    owned_.clear();
+    share_epoch_.store(0, std::memory_order_relaxed);
+    
+    // arena 中的文档从不与其他对象共享，可以直接复用
+    bool reuse_doc = usesArena();
+    if (reuse_doc) {
+        // MemoryPoolAllocator 不逐个释放，置空即丢弃旧值
+        doc_->SetNull();
+    }
+    if (!arena_) {
+        arena_ = std::make_unique<JsonArena>();
+    } else if (arena_->recycle()) {
+        reuse_doc = false;
+    }
+    if (!reuse_doc) {
+        doc_ = std::make_shared<rapidjson::Document>(&arena_->allocator());
+    }
+    
+    // 用常驻的 Reader 解析，保留它的字符串栈；Document::Parse 每次都会新建 Reader。
+    // DOM 在 Builder 中构建，它的构建栈也取自 arena，完成后把根值换入 doc_
+    rapidjson::MemoryStream stream(keyData(json), json.size());
+    rapidjson::ParseResult result;
+    auto generator = [&](JsonArena::Builder& handler) {
+        result = arena_->reader().Parse(stream, handler);
+        return !result.IsError();
+    };
+    JsonArena::Builder builder(&arena_->allocator(), JsonArena::kStackBytes, &arena_->stack());
+    builder.Populate(generator);
+    static_cast<rapidjson::Value&>(*doc_).Swap(builder);
+    if (result.IsError()) {
         doc_.reset();
+        timer.fail();
+        return JsonParseError{result.Code(), result.Offset()};
     }
+    if (member_index_) {
+        member_index_->build(*doc_);
+    }
+    return JsonParseError();
+}
+
+size_t JsonParam::retainedBytes() const {
+    return arena_ ? arena_->capacity() : 0;
 }
 
+JsonParam::JsonParam() = default;
+
+// 移动后 other 被清空，对 other 而言也是一次修改
+JsonParam::JsonParam(JsonParam&& other) noexcept
+    : arena_(std::move(other.arena_)),
+      doc_(std::move(other.doc_)),
+      member_index_(std::move(other.member_index_)),
+      anchors_(std::move(other.anchors_)),
+      merge_allocators_(std::move(other.merge_allocators_)),
+      share_epoch_(other.share_epoch_.load(std::memory_order_relaxed)),
+      owned_(std::move(other.owned_)),
+      owned_epoch_(other.owned_epoch_) {
+    ++other.generation_;
+}
+
+JsonParam& JsonParam::operator=(JsonParam&& other) noexcept {
+    if (this != &other) {
+        takeDocument(other);
+        member_index_ = std::move(other.member_index_);
+        ++generation_;
+    }
+    return *this;
+}
+
+void JsonParam::takeDocument(JsonParam& other) {
+    arena_ = std::move(other.arena_);
+    doc_ = std::move(other.doc_);
+    anchors_ = std::move(other.anchors_);
+    merge_allocators_ = std::move(other.merge_allocators_);
+    share_epoch_.store(other.share_epoch_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    owned_ = std::move(other.owned_);
+    owned_epoch_ = other.owned_epoch_;
+    ++other.generation_;
+}
+
+JsonParam::~JsonParam() = default;
+
 // 拷贝构造函数
-JsonParam::JsonParam(const JsonParam& other) {
+JsonParam::JsonParam(const JsonParam& other) : anchors_(other.anchors_) {
     if (other.isValid()) {
-        doc_ = std::make_unique<rapidjson::Document>();
-        doc_->CopyFrom(*other.doc_, doc_->GetAllocator());
+        shareFrom(other, *other.doc_);
     }
+    inheritMemberIndex(other);
 }
 
 // 拷贝赋值运算符
 JsonParam& JsonParam::operator=(const JsonParam& other) {
     if (this != &other) {
+        ++generation_;
         if (other.isValid()) {
-            if (!doc_) {
-                doc_ = std::make_unique<rapidjson::Document>();
-            }
-            doc_->CopyFrom(*other.doc_, doc_->GetAllocator());
+            // 旧值已不可达，只需持有 other 的外部存储
+            shareFrom(other, *other.doc_);
         } else {
             doc_.reset();
+            anchors_.clear();
+            merge_allocators_.clear();
+            owned_.clear();
+            share_epoch_.store(0, std::memory_order_relaxed);
         }
+        // 旧索引指向已被替换的成员数组，改用 other 的表
+        inheritMemberIndex(other);
     }
     return *this;
 }
 
+bool JsonParam::has(const JsonPathView& path) const {
+    stats::OpTimer timer(JsonOp::kHas);
+    bool found = getValueByPath(path) != nullptr;
+    timer.fail(!found);
+    return found;
+}
+
 bool JsonParam::has(const JsonPath& path) const {
-    return getValueByPath(path) != nullptr;
+    return has(JsonPathView(path));
 }
 
-std::string JsonParam::toString() const {
-    if (!isValid()) {
-        return "";
-    }
-    
-    rapidjson::StringBuffer buffer;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-    doc_->Accept(writer);
-    return buffer.GetString();
+bool JsonParam::has(std::initializer_list<JsonPathView::PathElement> path_elements) const {
+    return has(JsonPathView(path_elements));
 }
 
 bool JsonParam::isValid() const {
@@ -65,47 +445,91 @@ bool JsonParam::isValid() const {
 
 // 更新当前 JSON 对象
 bool JsonParam::update(const JsonParam& other) {
+    stats::OpTimer timer(JsonOp::kUpdate);
     if (!other.isValid()) {
+        timer.fail();
         return false;
     }
     
-    // 如果当前对象无效，直接复制
+    ++generation_;
+    
+    // 如果当前对象无效，直接与 other 共享；索引设置是本对象的，为新文档重建
     if (!isValid()) {
-        *this = other;
+        shareFrom(other, *other.doc_);
+        refreshMemberIndex();
         return true;
     }
     
-    // 深度合并两个 JSON 对象
-    deepMerge(*doc_, *other.doc_, doc_->GetAllocator());
+    // 深度合并两个 JSON 对象，合并进来的常量字符串仍指向 other 的缓冲区
+    deepMerge(*doc_, *other.doc_, doc_->GetAllocator(), false);
+    adoptAnchors(other);
+    return true;
+}
+
+bool JsonParam::update(JsonParam&& other) {
+    if (&other == this) {
+        return update(static_cast<const JsonParam&>(other));
+    }
+    stats::OpTimer timer(JsonOp::kUpdate);
+    if (!other.isValid()) {
+        timer.fail();
+        return false;
+    }
+    
+    ++generation_;
+    
+    if (!isValid()) {
+        takeDocument(other);
+        refreshMemberIndex();
+        return true;
+    }
+    
+    // 接管 other 的文档后，新增的成员和数组元素直接按位移入，不再复制
+    std::shared_ptr<rapidjson::Document> source = other.doc_;
+    adoptDocument(other);
+    deepMerge(*doc_, *source, doc_->GetAllocator(), true);
     return true;
 }
 
 // 深度合并两个 JSON 值
-void JsonParam::deepMerge(rapidjson::Value& target, const rapidjson::Value& source, rapidjson::Document::AllocatorType& allocator) {
+void JsonParam::deepMerge(rapidjson::Value& target, const rapidjson::Value& source, rapidjson::Document::AllocatorType& allocator,
+                          bool steal) {
     if (source.IsObject() && target.IsObject()) {
         // 合并对象
+        unshare(target);
         for (auto it = source.MemberBegin(); it != source.MemberEnd(); ++it) {
-            const char* key = it->name.GetString();
+            std::string_view key(it->name.GetString(), it->name.GetStringLength());
             
-            if (target.HasMember(key)) {
+            auto member = findMember(target, key);
+            if (member != target.MemberEnd()) {
                 // 如果目标也有这个键，递归合并
-                deepMerge(target[key], it->value, allocator);
-            } else {
+                deepMerge(member->value, it->value, allocator, steal);
+            } else if (steal) {
                 // 如果目标没有这个键，添加新成员
-                rapidjson::Value key_copy(key, allocator);
+                rapidjson::Value name;
+                rapidjson::Value value;
+                transferValue(it->name, name, true);
+                transferValue(it->value, value, true);
+                appendMember(target, name, value);
+            } else {
+                rapidjson::Value key_copy(key.data(), static_cast<rapidjson::SizeType>(key.size()), allocator);
                 rapidjson::Value value_copy = deepCopy(it->value, allocator);
-                target.AddMember(key_copy, value_copy, allocator);
+                appendMember(target, key_copy, value_copy);
             }
         }
+        markOwned(target);
     } else if (source.IsArray() && target.IsArray()) {
         // 对于数组，将源数组的元素追加到目标数组
+        unshare(target);
         for (rapidjson::SizeType i = 0; i < source.Size(); ++i) {
-            rapidjson::Value element_copy = deepCopy(source[i], allocator);
-            target.PushBack(element_copy, allocator);
+            rapidjson::Value element;
+            transferValue(source[i], element, steal);
+            target.PushBack(element, allocator);
         }
+        markOwned(target);
     } else {
         // 对于其他类型，直接覆盖
-        target.CopyFrom(source, allocator);
+        transferValue(source, target, steal);
     }
 }
 
@@ -118,160 +542,247 @@ rapidjson::Value JsonParam::deepCopy(const rapidjson::Value& source, rapidjson::
 
 // 克隆当前 JSON 对象
 JsonParamPtr JsonParam::clone() const {
+    stats::OpTimer timer(JsonOp::kClone);
     if (!isValid()) {
+        timer.fail();
         return std::make_shared<JsonParam>();
     }
     
-    // 创建新的 JsonParam 对象
+    // 创建新的 JsonParam 对象，与当前对象共享整棵树
     auto result = std::make_shared<JsonParam>();
-    result->doc_ = std::make_unique<rapidjson::Document>();
-    result->doc_->CopyFrom(*doc_, result->doc_->GetAllocator());
+    result->shareFrom(*this, *doc_);
+    result->inheritMemberIndex(*this);
     
     return result;
 }
 
 // 克隆指定路径的 JSON 子树
-JsonParamPtr JsonParam::clone(const JsonPath& path) const {
+JsonParamPtr JsonParam::clone(const JsonPathView& path) const {
+    stats::OpTimer timer(JsonOp::kClone);
     if (!isValid()) {
+        timer.fail();
         return std::make_shared<JsonParam>();
     }
     
     // 获取指定路径的值
     const rapidjson::Value* value = getValueByPath(path);
     if (!value||!value->IsObject()) {
+        timer.fail();
         return std::make_shared<JsonParam>();
     }
     
-    // 创建新的 JsonParam 对象，并复制指定路径的值
+    // 创建新的 JsonParam 对象，以指定路径的值为根共享子树
     auto result = std::make_shared<JsonParam>();
-    result->doc_ = std::make_unique<rapidjson::Document>();
-    result->doc_->CopyFrom(*value, result->doc_->GetAllocator());
+    result->shareFrom(*this, *value);
+    result->inheritMemberIndex(*this);
     
     return result;
 }
 
+JsonParamPtr JsonParam::clone(const JsonPath& path) const {
+    return clone(JsonPathView(path));
+}
+
 // 简化接口：直接接受列表初始化的路径
-JsonParamPtr JsonParam::clone(std::initializer_list<JsonPath::PathElement> path_elements) const {
-    JsonPath path(path_elements);
-    return clone(path);
+JsonParamPtr JsonParam::clone(std::initializer_list<JsonPathView::PathElement> path_elements) const {
+    return clone(JsonPathView(path_elements));
+}
+
+void JsonParam::enableMemberIndex(size_t threshold) {
+    member_index_ = std::make_unique<JsonMemberIndex>(threshold > 0 ? threshold : 1);
+    refreshMemberIndex();
+}
+
+void JsonParam::refreshMemberIndex() {
+    if (member_index_ && isValid()) {
+        member_index_->build(*doc_);
+    }
+}
+
+void JsonParam::dropMemberIndex(const rapidjson::Value& value) {
+    if (member_index_) {
+        member_index_->forget(value);
+    }
 }
 
-const rapidjson::Value* JsonParam::getValueByPath(const JsonPath& path) const {
-    if (!isValid() || path.empty()) {
+void JsonParam::disableMemberIndex() {
+    member_index_.reset();
+}
+
+rapidjson::Value::ConstMemberIterator JsonParam::findMember(const rapidjson::Value& object, std::string_view key) const {
+    if (member_index_ && member_index_->covers(object)) {
+        size_t pos = member_index_->find(object, key);
+        return pos == JsonMemberIndex::npos ? object.MemberEnd() : object.MemberBegin() + pos;
+    }
+    return object.FindMember(keyRef(key));
+}
+
+// 修改路径上的查找顺便建立或补齐索引
+rapidjson::Value::MemberIterator JsonParam::findMember(rapidjson::Value& object, std::string_view key) {
+    if (member_index_ && member_index_->covers(object)) {
+        size_t pos = member_index_->findOrBuild(object, key);
+        return pos == JsonMemberIndex::npos ? object.MemberEnd() : object.MemberBegin() + pos;
+    }
+    return object.FindMember(keyRef(key));
+}
+
+rapidjson::Value& JsonParam::appendMember(rapidjson::Value& object, rapidjson::Value& name, rapidjson::Value& value) {
+    const void* old_members = object.MemberCount() > 0 ? &*object.MemberBegin() : nullptr;
+    object.AddMember(name, value, doc_->GetAllocator());
+    if (member_index_ && member_index_->covers(object)) {
+        member_index_->rebase(old_members, object);
+    }
+    return (object.MemberEnd() - 1)->value;
+}
+
+const rapidjson::Value* JsonParam::getValueByPath(const JsonPathView& path) const {
+    if (!isValid() || (path.empty() && !path.isRoot())) {
         return nullptr;
     }
     
     const rapidjson::Value* current = doc_.get();
     
-    for (const auto& element : path.elements()) {
-        if (!current) {
-            return nullptr;
-        }
-        
-        if (std::holds_alternative<std::string>(element)) {
-            const std::string& key = std::get<std::string>(element);
-            if (!current->IsObject() || !current->HasMember(key.c_str())) {
+    for (const auto& element : path) {
+        std::string_view key;
+        size_t index = 0;
+        if (JsonPathView::keyOf(element, current->IsObject(), key, index)) {
+            if (!current->IsObject()) {
                 return nullptr;
             }
-            current = &(*current)[key.c_str()];
-        } else if (std::holds_alternative<size_t>(element)) {
-            size_t index = std::get<size_t>(element);
+            // 只查找一次成员
+            auto member = findMember(*current, key);
+            if (member == current->MemberEnd()) {
+                return nullptr;
+            }
+            current = &member->value;
+        } else {
             if (!current->IsArray() || index >= current->Size()) {
                 return nullptr;
             }
-            current = &(*current)[index];
+            current = &(*current)[static_cast<rapidjson::SizeType>(index)];
         }
     }
     
     return current;
 }
 
-rapidjson::Value* JsonParam::getOrCreateValueByPath(const JsonPath& path) {
-    if (!isValid() || path.empty()) {
+rapidjson::Value* JsonParam::getOrCreateValueByPath(const JsonPathView& path) {
+    if (!isValid() || (path.empty() && !path.isRoot())) {
         return nullptr;
     }
     
     rapidjson::Value* current = doc_.get();
     
-    for (size_t i = 0; i < path.elements().size(); ++i) {
-        const auto& element = path.elements()[i];
-        
-        if (!current) {
-            return nullptr;
-        }
-        
-        if (std::holds_alternative<std::string>(element)) {
-            const std::string& key = std::get<std::string>(element);
-            
+    for (const auto& element : path) {
+        // JSON Pointer 的数字段只在已有对象上按 key 写入，其他值上按下标建成数组
+        std::string_view key;
+        size_t index = 0;
+        if (JsonPathView::keyOf(element, current->IsObject(), key, index)) {
             // 确保当前值是对象
             if (!current->IsObject()) {
+                dropMemberIndex(*current);
                 current->SetObject();
             }
+            unshare(*current);
             
-            // 检查成员是否存在，如果不存在则添加
-            if (!current->HasMember(key.c_str())) {
-                current->AddMember(
-                    rapidjson::Value(key.c_str(), doc_->GetAllocator()),
-                    rapidjson::Value(),
-                    doc_->GetAllocator()
-                );
+            // 检查成员是否存在，如果不存在则添加到末尾
+            auto member = findMember(*current, key);
+            if (member != current->MemberEnd()) {
+                current = &member->value;
+            } else {
+                rapidjson::Value name(keyData(key), static_cast<rapidjson::SizeType>(key.size()), doc_->GetAllocator());
+                rapidjson::Value value;
+                rapidjson::Value& object = *current;
+                current = &appendMember(object, name, value);
+                markOwned(object);
+                stats::createdPath();
             }
-            
-            // 安全地访问成员
-            auto member = current->FindMember(key.c_str());
-            current = &member->value;
-        } else if (std::holds_alternative<size_t>(element)) {
-            size_t index = std::get<size_t>(element);
-            
+        } else {
             // 确保当前值是数组
             if (!current->IsArray()) {
+                dropMemberIndex(*current);
                 current->SetArray();
             }
+            unshare(*current);
             
             // 确保数组大小足够
-            while (current->Size() <= index) {
-                current->PushBack(rapidjson::Value(), doc_->GetAllocator());
+            if (current->Size() <= index) {
+                while (current->Size() <= index) {
+                    current->PushBack(rapidjson::Value(), doc_->GetAllocator());
+                }
+                markOwned(*current);
+                stats::createdPath();
             }
             
-            current = &(*current)[index];
+            current = &(*current)[static_cast<rapidjson::SizeType>(index)];
         }
     }
     
     return current;
 }
 
+// 通用的递归类型获取函数
+template<typename T>
+T JsonParam::get(const JsonPathView& path, const T& default_value) const {
+    stats::OpTimer timer(JsonOp::kGet);
+    const rapidjson::Value* value = getValueByPath(path);
+    if (!value) {
+        timer.fail();
+        return default_value;
+    }
+    return parseValue(value, default_value);
+}
+
+template<typename T>
+size_t JsonParam::getNumbers(const JsonPathView& path, T* out, size_t capacity) const {
+    const rapidjson::Value* value = getValueByPath(path);
+    if (!value || !value->IsArray()) {
+        return npos;
+    }
+    size_t size = value->Size();
+    if (size > capacity) {
+        return size;
+    }
+    return convertNumbers<T, true>(*value, out) ? size : npos;
+}
+
+template<typename T>
+bool JsonParam::getNumbers(const JsonPathView& path, std::vector<T>& out) const {
+    const rapidjson::Value* value = getValueByPath(path);
+    if (!value || !value->IsArray()) {
+        return false;
+    }
+    out.resize(value->Size());
+    return convertNumbers<T, true>(*value, out.data());
+}
+
+template<typename T>
+T JsonPathResults::get(size_t index, const T& default_value) const {
+    if (!has(index)) {
+        return default_value;
+    }
+    return owner_->parseValue(values_[index], default_value);
+}
+
 // 通用的递归类型解析函数
 template<typename T>
 T JsonParam::parseValue(const rapidjson::Value* value, const T& default_value) const {
     if (!value) return default_value;
     
     // 基本类型处理
-    if constexpr (std::is_same_v<T, std::string>) {
-        if (value->IsString()) {
-            return value->GetString();
-        }
-    } else if constexpr (std::is_same_v<T, int>) {
-        if (value->IsInt()) {
-            return value->GetInt();
-        } else if (value->IsInt64()) {
-            return static_cast<int>(value->GetInt64());
-        }
-    } else if constexpr (std::is_same_v<T, double>) {
-        if (value->IsDouble()) {
-            return value->GetDouble();
-        } else if (value->IsInt()) {
-            return static_cast<double>(value->GetInt());
-        }
-    } else if constexpr (std::is_same_v<T, bool>) {
-        if (value->IsBool()) {
-            return value->GetBool();
-        }
+    if constexpr (detail::is_scalar_v<T>) {
+        return detail::readScalar(*value, default_value);
     } else if constexpr (is_vector<T>::value) {
         // vector 类型处理
         return parseVector(value, default_value);
     } else if constexpr (is_map<T>::value) {
         // map 类型处理
         return parseMap(value, default_value);
+    } else if constexpr (is_array_view<T>::value) {
+        // 数组视图，借用文档中的数组
+        if (value->IsArray()) {
+            return T(value, &generation_);
+        }
     }
     
     return default_value;
@@ -285,6 +796,14 @@ std::vector<V> JsonParam::parseVector(const rapidjson::Value* value, const std::
     }
     
     std::vector<V> result;
+    // 同构的数值数组走批量转换，混合类型清空后复用同一块存储走逐元素的通用路径
+    if constexpr (std::is_same_v<V, double> || std::is_same_v<V, int>) {
+        result.resize(value->Size());
+        if (convertNumbers<V, false>(*value, result.data())) {
+            return result;
+        }
+        result.clear();
+    }
     result.reserve(value->Size());
     
     for (rapidjson::SizeType i = 0; i < value->Size(); ++i) {
@@ -316,12 +835,17 @@ MapType JsonParam::parseMap(const rapidjson::Value* value, const MapType& defaul
 
 // 通用的递归类型设置函数
 template<typename T>
-bool JsonParam::set(const JsonPath& path, const T& value) {
+bool JsonParam::set(const JsonPathView& path, const T& value) {
+    stats::OpTimer timer(JsonOp::kSet);
+    ++generation_;
     rapidjson::Value* target = getOrCreateValueByPath(path);
-    if (!target) {
-        return false;
+    if (target) {
+        // 旧值被覆盖，其中对象的索引随之作废
+        dropMemberIndex(*target);
     }
-    return setValue(target, value);
+    bool ok = target && setValue(target, value);
+    timer.fail(!ok);
+    return ok;
 }
 
 template<typename T>
@@ -388,57 +912,95 @@ bool JsonParam::setMap(rapidjson::Value* value, const MapType& new_value) {
 }
 
 // 显式实例化常用类型
-template std::string JsonParam::get(const JsonPath& path, const std::string& default_value) const;
-template int JsonParam::get(const JsonPath& path, const int& default_value) const;
-template double JsonParam::get(const JsonPath& path, const double& default_value) const;
-template bool JsonParam::get(const JsonPath& path, const bool& default_value) const;
+template std::string JsonParam::get(const JsonPathView& path, const std::string& default_value) const;
+template int JsonParam::get(const JsonPathView& path, const int& default_value) const;
+template double JsonParam::get(const JsonPathView& path, const double& default_value) const;
+template bool JsonParam::get(const JsonPathView& path, const bool& default_value) const;
+template std::string_view JsonParam::get(const JsonPathView& path, const std::string_view& default_value) const;
+template const char* JsonParam::get(const JsonPathView& path, const char* const& default_value) const;
+
+// 提取结果取值
+template std::string JsonPathResults::get(size_t index, const std::string& default_value) const;
+template int JsonPathResults::get(size_t index, const int& default_value) const;
+template double JsonPathResults::get(size_t index, const double& default_value) const;
+template bool JsonPathResults::get(size_t index, const bool& default_value) const;
+template std::string_view JsonPathResults::get(size_t index, const std::string_view& default_value) const;
+template const char* JsonPathResults::get(size_t index, const char* const& default_value) const;
+template std::vector<std::string> JsonPathResults::get(size_t index, const std::vector<std::string>& default_value) const;
+template std::vector<int> JsonPathResults::get(size_t index, const std::vector<int>& default_value) const;
+template std::vector<double> JsonPathResults::get(size_t index, const std::vector<double>& default_value) const;
+template std::vector<bool> JsonPathResults::get(size_t index, const std::vector<bool>& default_value) const;
+template std::map<std::string, std::string> JsonPathResults::get(size_t index, const std::map<std::string, std::string>& default_value) const;
+template std::map<std::string, int> JsonPathResults::get(size_t index, const std::map<std::string, int>& default_value) const;
+template std::map<std::string, double> JsonPathResults::get(size_t index, const std::map<std::string, double>& default_value) const;
+template JsonArrayView<int> JsonPathResults::get(size_t index, const JsonArrayView<int>& default_value) const;
+template JsonArrayView<double> JsonPathResults::get(size_t index, const JsonArrayView<double>& default_value) const;
+template JsonArrayView<std::string_view> JsonPathResults::get(size_t index, const JsonArrayView<std::string_view>& default_value) const;
+
+// 数值数组批量读取
+template size_t JsonParam::getNumbers(const JsonPathView& path, double* out, size_t capacity) const;
+template size_t JsonParam::getNumbers(const JsonPathView& path, float* out, size_t capacity) const;
+template size_t JsonParam::getNumbers(const JsonPathView& path, int32_t* out, size_t capacity) const;
+template size_t JsonParam::getNumbers(const JsonPathView& path, int64_t* out, size_t capacity) const;
+template bool JsonParam::getNumbers(const JsonPathView& path, std::vector<double>& out) const;
+template bool JsonParam::getNumbers(const JsonPathView& path, std::vector<float>& out) const;
+template bool JsonParam::getNumbers(const JsonPathView& path, std::vector<int32_t>& out) const;
+template bool JsonParam::getNumbers(const JsonPathView& path, std::vector<int64_t>& out) const;
+
+// 数组视图
+template JsonArrayView<int> JsonParam::get(const JsonPathView& path, const JsonArrayView<int>& default_value) const;
+template JsonArrayView<double> JsonParam::get(const JsonPathView& path, const JsonArrayView<double>& default_value) const;
+template JsonArrayView<bool> JsonParam::get(const JsonPathView& path, const JsonArrayView<bool>& default_value) const;
+template JsonArrayView<std::string> JsonParam::get(const JsonPathView& path, const JsonArrayView<std::string>& default_value) const;
+template JsonArrayView<std::string_view> JsonParam::get(const JsonPathView& path, const JsonArrayView<std::string_view>& default_value) const;
+template JsonArrayView<const char*> JsonParam::get(const JsonPathView& path, const JsonArrayView<const char*>& default_value) const;
 
 // 显式实例化 vector 类型
-template std::vector<std::string> JsonParam::get(const JsonPath& path, const std::vector<std::string>& default_value) const;
-template std::vector<int> JsonParam::get(const JsonPath& path, const std::vector<int>& default_value) const;
-template std::vector<double> JsonParam::get(const JsonPath& path, const std::vector<double>& default_value) const;
-template std::vector<bool> JsonParam::get(const JsonPath& path, const std::vector<bool>& default_value) const;
+template std::vector<std::string> JsonParam::get(const JsonPathView& path, const std::vector<std::string>& default_value) const;
+template std::vector<int> JsonParam::get(const JsonPathView& path, const std::vector<int>& default_value) const;
+template std::vector<double> JsonParam::get(const JsonPathView& path, const std::vector<double>& default_value) const;
+template std::vector<bool> JsonParam::get(const JsonPathView& path, const std::vector<bool>& default_value) const;
 
 // 显式实例化 map 类型
-template std::map<std::string, std::string> JsonParam::get(const JsonPath& path, const std::map<std::string, std::string>& default_value) const;
-template std::unordered_map<std::string, std::string> JsonParam::get(const JsonPath& path, const std::unordered_map<std::string, std::string>& default_value) const;
-template std::map<std::string, int> JsonParam::get(const JsonPath& path, const std::map<std::string, int>& default_value) const;
-template std::unordered_map<std::string, int> JsonParam::get(const JsonPath& path, const std::unordered_map<std::string, int>& default_value) const;
-template std::map<std::string, double> JsonParam::get(const JsonPath& path, const std::map<std::string, double>& default_value) const;
-template std::unordered_map<std::string, double> JsonParam::get(const JsonPath& path, const std::unordered_map<std::string, double>& default_value) const;
+template std::map<std::string, std::string> JsonParam::get(const JsonPathView& path, const std::map<std::string, std::string>& default_value) const;
+template std::unordered_map<std::string, std::string> JsonParam::get(const JsonPathView& path, const std::unordered_map<std::string, std::string>& default_value) const;
+template std::map<std::string, int> JsonParam::get(const JsonPathView& path, const std::map<std::string, int>& default_value) const;
+template std::unordered_map<std::string, int> JsonParam::get(const JsonPathView& path, const std::unordered_map<std::string, int>& default_value) const;
+template std::map<std::string, double> JsonParam::get(const JsonPathView& path, const std::map<std::string, double>& default_value) const;
+template std::unordered_map<std::string, double> JsonParam::get(const JsonPathView& path, const std::unordered_map<std::string, double>& default_value) const;
 
 // 递归 map 类型实例化
-template std::map<std::string, std::map<std::string, std::string>> JsonParam::get(const JsonPath& path, const std::map<std::string, std::map<std::string, std::string>>& default_value) const;
-template std::map<std::string, std::vector<std::string>> JsonParam::get(const JsonPath& path, const std::map<std::string, std::vector<std::string>>& default_value) const;
-template std::vector<std::map<std::string, std::string>> JsonParam::get(const JsonPath& path, const std::vector<std::map<std::string, std::string>>& default_value) const;
+template std::map<std::string, std::map<std::string, std::string>> JsonParam::get(const JsonPathView& path, const std::map<std::string, std::map<std::string, std::string>>& default_value) const;
+template std::map<std::string, std::vector<std::string>> JsonParam::get(const JsonPathView& path, const std::map<std::string, std::vector<std::string>>& default_value) const;
+template std::vector<std::map<std::string, std::string>> JsonParam::get(const JsonPathView& path, const std::vector<std::map<std::string, std::string>>& default_value) const;
 
 // 新增测试用例需要的实例化
-template std::map<std::string, std::vector<int>> JsonParam::get(const JsonPath& path, const std::map<std::string, std::vector<int>>& default_value) const;
-template std::vector<std::map<std::string, int>> JsonParam::get(const JsonPath& path, const std::vector<std::map<std::string, int>>& default_value) const;
+template std::map<std::string, std::vector<int>> JsonParam::get(const JsonPathView& path, const std::map<std::string, std::vector<int>>& default_value) const;
+template std::vector<std::map<std::string, int>> JsonParam::get(const JsonPathView& path, const std::vector<std::map<std::string, int>>& default_value) const;
 
 // set 方法的显式实例化
-template bool JsonParam::set(const JsonPath& path, const std::string& value);
-template bool JsonParam::set(const JsonPath& path, const int& value);
-template bool JsonParam::set(const JsonPath& path, const double& value);
-template bool JsonParam::set(const JsonPath& path, const bool& value);
+template bool JsonParam::set(const JsonPathView& path, const std::string& value);
+template bool JsonParam::set(const JsonPathView& path, const int& value);
+template bool JsonParam::set(const JsonPathView& path, const double& value);
+template bool JsonParam::set(const JsonPathView& path, const bool& value);
 
 // set vector 类型实例化
-template bool JsonParam::set(const JsonPath& path, const std::vector<std::string>& value);
-template bool JsonParam::set(const JsonPath& path, const std::vector<int>& value);
-template bool JsonParam::set(const JsonPath& path, const std::vector<double>& value);
-template bool JsonParam::set(const JsonPath& path, const std::vector<bool>& value);
+template bool JsonParam::set(const JsonPathView& path, const std::vector<std::string>& value);
+template bool JsonParam::set(const JsonPathView& path, const std::vector<int>& value);
+template bool JsonParam::set(const JsonPathView& path, const std::vector<double>& value);
+template bool JsonParam::set(const JsonPathView& path, const std::vector<bool>& value);
 
 // set map 类型实例化
-template bool JsonParam::set(const JsonPath& path, const std::map<std::string, std::string>& value);
-template bool JsonParam::set(const JsonPath& path, const std::unordered_map<std::string, std::string>& value);
-template bool JsonParam::set(const JsonPath& path, const std::map<std::string, int>& value);
-template bool JsonParam::set(const JsonPath& path, const std::unordered_map<std::string, int>& value);
-template bool JsonParam::set(const JsonPath& path, const std::map<std::string, double>& value);
-template bool JsonParam::set(const JsonPath& path, const std::unordered_map<std::string, double>& value);
+template bool JsonParam::set(const JsonPathView& path, const std::map<std::string, std::string>& value);
+template bool JsonParam::set(const JsonPathView& path, const std::unordered_map<std::string, std::string>& value);
+template bool JsonParam::set(const JsonPathView& path, const std::map<std::string, int>& value);
+template bool JsonParam::set(const JsonPathView& path, const std::unordered_map<std::string, int>& value);
+template bool JsonParam::set(const JsonPathView& path, const std::map<std::string, double>& value);
+template bool JsonParam::set(const JsonPathView& path, const std::unordered_map<std::string, double>& value);
 
 // 递归 set 类型实例化
-template bool JsonParam::set(const JsonPath& path, const std::map<std::string, std::vector<int>>& value);
-template bool JsonParam::set(const JsonPath& path, const std::vector<std::map<std::string, int>>& value);
+template bool JsonParam::set(const JsonPathView& path, const std::map<std::string, std::vector<int>>& value);
+template bool JsonParam::set(const JsonPathView& path, const std::vector<std::map<std::string, int>>& value);
 
 } // namespace json
 } // namespace cpputil 
\ No newline at end of file
@@ -1,12 +1,22 @@
 #pragma once
 
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
 #include <initializer_list>
+#include <iterator>
 #include <map>
 #include <memory>
+#include <optional>
 #include <rapidjson/document.h>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
 #include <variant>
 #include <vector>
 
@@ -15,12 +25,31 @@ namespace json {
 
 // 前向声明和类型定义
 class JsonParam;
+class JsonMemberIndex;
+class JsonArena;
+class JsonTapeView;
+class JsonParseResult;
 using JsonParamPtr = std::shared_ptr<JsonParam>;
 
 // JSON 路径类，支持列表初始化
 class JsonPath {
 public:
-  using PathElement = std::variant<std::string, size_t>;
+  // JSON Pointer 中十进制形式的段，如 "/ports/8080" 的 8080：作用于数组时按下标
+  // index 取元素，作用于对象时按原文 text 查找成员。只由 parse 产生，
+  // 手工构造的 size_t 段始终是下标
+  struct NumericToken {
+    std::string text;
+    size_t index = 0;
+
+    bool operator==(const NumericToken &other) const {
+      return text == other.text && index == other.index;
+    }
+  };
+
+  using PathElement = std::variant<std::string, size_t, NumericToken>;
+
+  // 通配段：匹配任意数组元素或对象成员，目前只用于投影解析
+  static constexpr size_t kWildcard = static_cast<size_t>(-1);
 
   // 默认构造函数
   JsonPath() = default;
@@ -28,82 +57,600 @@ public:
   // 列表初始化构造函数
   JsonPath(std::initializer_list<PathElement> elements) : path_(elements) {}
 
+  // 指向整个文档的路径。空路径在 get/has/set 中不选中任何值，根要显式写成 root()
+  static JsonPath root() {
+    JsonPath path;
+    path.root_ = true;
+    return path;
+  }
+
   // 添加路径元素
   void add(const std::string &key) { path_.emplace_back(key); }
   void add(size_t index) { path_.emplace_back(index); }
+  void add(const NumericToken &token) { path_.emplace_back(token); }
 
   // 获取路径元素
   const std::vector<PathElement> &elements() const { return path_; }
 
   // 清空路径
-  void clear() { path_.clear(); }
+  void clear() {
+    path_.clear();
+    root_ = false;
+  }
 
   // 路径是否为空
   bool empty() const { return path_.empty(); }
 
+  // 是否为 root()：没有任何段，但选中整个文档
+  bool isRoot() const { return root_ && path_.empty(); }
+
   // 路径大小
   size_t size() const { return path_.size(); }
 
+  // 解析字符串形式的路径，格式不合法时返回 std::nullopt。
+  // 以 '/' 开头或为 "" 时按 JSON Pointer（RFC 6901）解析："" 即 root()，
+  // "~1" 还原为 '/'，"~0" 还原为 '~'，十进制、无前导零的段解析为 NumericToken，
+  // 在数组上是下标、在对象上是 key，"/user/scores/0" 与 "/ports/8080" 都按原意查找。
+  // 否则按点号与方括号解析：点号分隔 key，方括号内为下标、"*"（kWildcard）
+  // 或带引号的 key（单引号或双引号，反斜杠转义引号和自身），
+  // 如 "user.scores[0]"、"items[*].price"、a["x.y"]
+  static std::optional<JsonPath> parse(std::string_view text);
+
 private:
   std::vector<PathElement> path_;
+  bool root_ = false;
+};
+
+// 轻量 JSON 路径视图：key 以 std::string_view 引用调用方的字符串，
+// 不超过 kInlineCapacity 段的路径存放在对象内部，构造和查找都不做堆分配。
+// 视图不拥有 key，被引用的字符串必须比视图活得久
+class JsonPathView {
+public:
+  // 引用 JsonPath::NumericToken 的原文
+  struct NumericToken {
+    std::string_view text;
+    size_t index = 0;
+  };
+
+  using PathElement = std::variant<std::string_view, size_t, NumericToken>;
+
+  static constexpr size_t kInlineCapacity = 8;
+
+  // 默认构造函数
+  JsonPathView() = default;
+
+  // 列表初始化构造函数
+  JsonPathView(std::initializer_list<PathElement> elements) {
+    for (const auto &element : elements) {
+      push(element);
+    }
+  }
+
+  // 引用 JsonPath 中的 key
+  JsonPathView(const JsonPath &path) : root_(path.isRoot()) {
+    for (const auto &element : path.elements()) {
+      if (const auto *key = std::get_if<std::string>(&element)) {
+        add(std::string_view(*key));
+      } else if (const auto *token = std::get_if<JsonPath::NumericToken>(&element)) {
+        push(PathElement(NumericToken{token->text, token->index}));
+      } else {
+        add(std::get<size_t>(element));
+      }
+    }
+  }
+
+  // 添加路径元素
+  void add(std::string_view key) { push(PathElement(key)); }
+  void add(size_t index) { push(PathElement(index)); }
+
+  // 段作用于容器时的含义：返回 true 时按 key 查找成员，否则按 index 取元素。
+  // on_object 为容器是否对象；字符串段始终是 key，size_t 段始终是下标，
+  // NumericToken 在对象上是 key、在其他值上是下标
+  static bool keyOf(const PathElement &element, bool on_object,
+                    std::string_view &key, size_t &index) {
+    if (const auto *text = std::get_if<std::string_view>(&element)) {
+      key = *text;
+      return true;
+    }
+    if (const auto *token = std::get_if<NumericToken>(&element)) {
+      if (on_object) {
+        key = token->text;
+        return true;
+      }
+      index = token->index;
+      return false;
+    }
+    index = std::get<size_t>(element);
+    return false;
+  }
+
+  // 遍历路径元素
+  const PathElement *begin() const { return data(); }
+  const PathElement *end() const { return data() + size_; }
+  const PathElement &operator[](size_t i) const { return data()[i]; }
+
+  // 清空路径
+  void clear() {
+    size_ = 0;
+    heap_.clear();
+    root_ = false;
+  }
+
+  // 路径是否为空
+  bool empty() const { return size_ == 0; }
+
+  // 是否引用 JsonPath::root()：没有任何段，但选中整个文档
+  bool isRoot() const { return root_ && size_ == 0; }
+
+  // 路径大小
+  size_t size() const { return size_; }
+
+  // 与 JsonPath::root() 相同，选中整个文档
+  static JsonPathView root() {
+    JsonPathView view;
+    view.root_ = true;
+    return view;
+  }
+
+private:
+  const PathElement *data() const {
+    return size_ <= kInlineCapacity ? inline_ : heap_.data();
+  }
+
+  // 超出内联容量时整体搬到堆上，之后始终从 heap_ 读取
+  void push(const PathElement &element) {
+    if (size_ < kInlineCapacity) {
+      inline_[size_++] = element;
+      return;
+    }
+    if (size_ == kInlineCapacity) {
+      heap_.assign(inline_, inline_ + kInlineCapacity);
+    }
+    heap_.push_back(element);
+    ++size_;
+  }
+
+  PathElement inline_[kInlineCapacity];
+  std::vector<PathElement> heap_;
+  size_t size_ = 0;
+  bool root_ = false;
+};
+
+namespace detail {
+
+// 标量读取规则，get<T> 与 JsonArrayView<T> 共用。类型不符时返回 default_value。
+// std::string_view 与 const char* 借用文档中的字符串，不拷贝
+template <typename T>
+T readScalar(const rapidjson::Value &value, const T &default_value) {
+  if constexpr (std::is_same_v<T, std::string>) {
+    if (value.IsString()) {
+      return value.GetString();
+    }
+  } else if constexpr (std::is_same_v<T, std::string_view>) {
+    if (value.IsString()) {
+      return std::string_view(value.GetString(), value.GetStringLength());
+    }
+  } else if constexpr (std::is_same_v<T, const char *>) {
+    if (value.IsString()) {
+      return value.GetString();
+    }
+  } else if constexpr (std::is_same_v<T, int>) {
+    if (value.IsInt()) {
+      return value.GetInt();
+    } else if (value.IsInt64()) {
+      return static_cast<int>(value.GetInt64());
+    }
+  } else if constexpr (std::is_same_v<T, double>) {
+    if (value.IsDouble()) {
+      return value.GetDouble();
+    } else if (value.IsInt()) {
+      return static_cast<double>(value.GetInt());
+    }
+  } else if constexpr (std::is_same_v<T, bool>) {
+    if (value.IsBool()) {
+      return value.GetBool();
+    }
+  }
+  return default_value;
+}
+
+template <typename T>
+inline constexpr bool is_scalar_v =
+    std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> ||
+    std::is_same_v<T, const char *> || std::is_same_v<T, int> ||
+    std::is_same_v<T, double> || std::is_same_v<T, bool>;
+
+// 结构体解码访问 JsonParam 的成员查找，定义在 json_struct.h
+struct StructAccess;
+
+} // namespace detail
+
+// 数组视图：按元素类型 T 直接读取文档中的数组，不构造容器。
+// T 支持 int、double、bool、std::string、std::string_view、const char*，
+// 元素类型不符时返回 T{}（或 at 的默认值）。通过 get<JsonArrayView<T>>(path) 获取，
+// 路径不存在或不是数组时得到空视图，valid() 为 false。
+// 视图借用创建它的 JsonParam，只能在该对象存活且未被修改期间使用；
+// 未定义 NDEBUG 时，每次访问都会断言对象在创建视图之后没有被修改
+template <typename T> class JsonArrayView {
+  static_assert(detail::is_scalar_v<T>, "unsupported JsonArrayView element type");
+
+public:
+  class iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = T;
+
+    iterator() = default;
+
+    T operator*() const { return view_->at(index_); }
+    iterator &operator++() {
+      ++index_;
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator old = *this;
+      ++index_;
+      return old;
+    }
+    bool operator==(const iterator &other) const { return index_ == other.index_; }
+    bool operator!=(const iterator &other) const { return index_ != other.index_; }
+
+  private:
+    friend class JsonArrayView;
+    iterator(const JsonArrayView *view, size_t index) : view_(view), index_(index) {}
+
+    const JsonArrayView *view_ = nullptr;
+    size_t index_ = 0;
+  };
+
+  JsonArrayView() = default;
+
+  // 路径上的值是否为数组
+  bool valid() const { return array_ != nullptr; }
+
+  size_t size() const {
+    checkUnmodified();
+    return array_ ? array_->Size() : 0;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  // 越界或类型不符时返回 default_value
+  T at(size_t index, const T &default_value = T{}) const {
+    if (index >= size()) {
+      return default_value;
+    }
+    return detail::readScalar((*array_)[static_cast<rapidjson::SizeType>(index)],
+                              default_value);
+  }
+
+  T operator[](size_t index) const { return at(index); }
+
+  iterator begin() const { return iterator(this, 0); }
+  iterator end() const { return iterator(this, size()); }
+
+private:
+  friend class JsonParam;
+
+  JsonArrayView(const rapidjson::Value *array, const uint64_t *generation)
+      : array_(array), generation_(generation), expected_(*generation) {}
+
+  void checkUnmodified() const {
+    assert((!generation_ || *generation_ == expected_) &&
+           "JsonArrayView used after its JsonParam was modified");
+  }
+
+  const rapidjson::Value *array_ = nullptr;
+  const uint64_t *generation_ = nullptr;
+  uint64_t expected_ = 0;
+};
+
+// 多路径提取计划：把一组路径编译成前缀树，JsonParam::extract 一次遍历文档
+// 取出所有路径上的值，公共前缀只查找一次。与 get 一样，空路径不选中任何值，
+// 结果中对应的路径不存在。计划构建后只读，可在线程间共享
+class JsonPathPlan {
+public:
+  explicit JsonPathPlan(const std::vector<JsonPath> &paths);
+  JsonPathPlan(std::initializer_list<JsonPath> paths)
+      : JsonPathPlan(std::vector<JsonPath>(paths)) {}
+
+  // 成员查找表引用节点中的 key，禁止拷贝
+  JsonPathPlan(const JsonPathPlan &) = delete;
+  JsonPathPlan &operator=(const JsonPathPlan &) = delete;
+  JsonPathPlan(JsonPathPlan &&) = default;
+  JsonPathPlan &operator=(JsonPathPlan &&) = default;
+
+  // 路径数
+  size_t size() const { return size_; }
+
+private:
+  friend class JsonParam;
+
+  struct Node {
+    std::vector<size_t> targets; // 在此结束的路径序号
+    std::vector<std::pair<std::string, uint32_t>> members; // key -> 子节点
+    std::vector<std::pair<size_t, uint32_t>> elements;     // 下标 -> 子节点
+    // JSON Pointer 数字段 -> 子节点，对象上按原文、数组上按下标匹配
+    std::vector<std::pair<JsonPath::NumericToken, uint32_t>> tokens;
+    std::unordered_map<std::string_view, uint32_t> lookup; // key -> members 下标
+  };
+
+  std::vector<Node> nodes_; // nodes_[0] 为根
+  size_t size_ = 0;
+};
+
+// 提取结果：按计划中的路径顺序保存各路径上的节点，取值规则与 JsonParam::get 相同。
+// 结果引用文档中的节点，JsonParam 被修改或析构后失效
+class JsonPathResults {
+public:
+  size_t size() const { return values_.size(); }
+
+  // 第 index 条路径是否存在
+  bool has(size_t index) const {
+    return index < values_.size() && values_[index] != nullptr;
+  }
+
+  template <typename T> T get(size_t index, const T &default_value = T{}) const;
+
+private:
+  friend class JsonParam;
+
+  const JsonParam *owner_ = nullptr;
+  std::vector<const rapidjson::Value *> values_;
+};
+
+// 解析 '\0' 结尾的文本（std::string、const char*、原地解析）时使用的扫描内核。
+// 带长度的解析经 MemoryStream 逐字节读取，不使用 SIMD
+enum class ParseKernel { kScalar, kSse2, kSse42 };
+
+// 当前使用的内核。以 CPPUTIL_JSON_SIMD 构建（bazel build --config=simd）时，
+// 首次调用前按 CPUID 选出本机支持的最快内核；否则恒为 kScalar
+ParseKernel parseKernel();
+
+// 切换内核，供基准测试和排查问题时对比；内核未编译进来或 CPU 不支持时返回 false
+bool setParseKernel(ParseKernel kernel);
+
+// 解析错误：错误码与出错位置（字节偏移）
+struct JsonParseError {
+  rapidjson::ParseErrorCode code = rapidjson::kParseErrorNone;
+  size_t offset = 0;
+  // CBOR / MessagePack 解码失败时的静态描述，如 "unexpected end of data"；文本解析时为空
+  const char *reason = nullptr;
+
+  bool ok() const { return code == rapidjson::kParseErrorNone; }
+
+  // 格式化为 "Invalid value. at offset 9"，有 reason 时以它代替错误码的描述；成功时为空串
+  std::string message() const;
 };
 
 // JSON 类，基于 RapidJSON 封装
 class JsonParam {
 public:
-  // 构造函数，接受 JSON 字符串
+  // 构造函数，接受 JSON 字符串。解析失败时向 std::cerr 输出错误，对象无效；
+  // 不希望有任何输出时使用 parse
   explicit JsonParam(const std::string &json_str);
+  explicit JsonParam(const char *json_str);
+
+  // 解析 [data, data + length) 范围内的 JSON，不要求 '\0' 结尾
+  explicit JsonParam(std::string_view json);
+  JsonParam(const char *data, size_t length);
+
+  // 原地解析：接管 '\0' 结尾的缓冲区并用 ParseInsitu 就地解码，字符串值直接指向缓冲区，
+  // 不再拷贝到 document 的分配器中。缓冲区随 JsonParam（及其拷贝）一起释放
+  explicit JsonParam(std::unique_ptr<char[]> buffer);
+
+  // 与对应的构造函数相同，但不做任何输出：失败时在结果中返回错误码和偏移，
+  // 是否格式化、记录由调用方决定
+  static JsonParseResult parse(const std::string &json);
+  static JsonParseResult parse(const char *json);
+  static JsonParseResult parse(std::string_view json);
+
+  // 原地解析 buffer，不做输出。整个缓冲区随文档及其克隆保留，只在确实要省去
+  // 字符串拷贝时显式调用；临时字符串传给构造函数或 parse 时仍按常规方式拷贝
+  static JsonParseResult parseInsitu(std::string buffer);
 
   // 默认构造函数
-  JsonParam() = default;
+  JsonParam();
 
   // 移动构造函数
-  JsonParam(JsonParam &&other) noexcept = default;
+  JsonParam(JsonParam &&other) noexcept;
 
   // 移动赋值运算符
-  JsonParam &operator=(JsonParam &&other) noexcept = default;
+  JsonParam &operator=(JsonParam &&other) noexcept;
 
-  // 拷贝构造函数和赋值运算符（用于update方法）
+  // 拷贝构造函数和赋值运算符（用于update方法）。
+  // 与 clone 一样写时复制：拷贝只复制根节点，未修改的子树与 other 共享
   JsonParam(const JsonParam &other);
   JsonParam &operator=(const JsonParam &other);
 
   // 析构函数
-  ~JsonParam() = default;
+  ~JsonParam();
+
+  // 获取值的模板方法 - 支持递归类型解析。
+  // T 为 std::string_view、const char* 或 JsonArrayView<E> 时借用文档中的数据而不拷贝，
+  // 在本对象被修改或析构之后失效
+  template <typename T>
+  T get(const JsonPathView &path, const T &default_value = T{}) const;
 
-  // 获取值的模板方法 - 支持递归类型解析
   template <typename T>
   T get(const JsonPath &path, const T &default_value = T{}) const {
-    const rapidjson::Value *value = getValueByPath(path);
-    if (!value) {
-      return default_value;
-    }
-    return parseValue(value, default_value);
+    return get(JsonPathView(path), default_value);
   }
 
-  // 简化接口：直接接受列表初始化
+  // 简化接口：直接接受列表初始化，key 以 string_view 引用，不做堆分配
   template <typename T>
-  T get(std::initializer_list<JsonPath::PathElement> path_elements,
+  T get(std::initializer_list<JsonPathView::PathElement> path_elements,
         const T &default_value = T{}) const {
-    JsonPath path(path_elements);
-    return get(path, default_value);
+    return get(JsonPathView(path_elements), default_value);
+  }
+
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  // 执行提取计划，一次遍历取出计划中所有路径上的值
+  JsonPathResults extract(const JsonPathPlan &plan) const;
+
+  // 同上，复用 results 的存储
+  void extract(const JsonPathPlan &plan, JsonPathResults &results) const;
+
+  // 按路径顺序把结果写入调用方的变量，不存在或类型不符的路径保持变量原值。
+  // 变量个数不能超过计划的路径数，返回存在的路径数
+  template <typename... Ts>
+  size_t extractTo(const JsonPathPlan &plan, Ts &...slots) const {
+    // 每个线程复用一份结果存储，避免每次调用分配
+    static thread_local JsonPathResults results;
+    extract(plan, results);
+    size_t index = 0;
+    size_t found = 0;
+    ((found += results.has(index) ? 1 : 0,
+      slots = results.get(index, static_cast<const Ts &>(slots)), ++index),
+     ...);
+    return found;
   }
 
+  // 按 CPPUTIL_JSON_FIELDS 声明的字段映射，从 path 处的对象一次遍历填充 out，
+  // 整个文档用 JsonPath::root()，其他空路径什么也不选。缺失的字段保持原值；
+  // 路径不存在或有字段类型不符时返回 false。
+  // 定义在 json_struct.h
+  template <typename T> bool decode(const JsonPathView &path, T &out) const;
+
+  // 批量读取数值数组，T 为 double、float、int32_t、int64_t。
+  // double/float 接受任意数值元素，整数类型要求元素能无损表示为 T。
+  // 成功时返回数组长度 n：n <= capacity 时写入 out[0, n)，否则不写入，调用方可按 n
+  // 扩容后重试；路径不存在、不是数组或含不可转换的元素时返回 npos，out 内容未定义
+  template <typename T>
+  size_t getNumbers(const JsonPathView &path, T *out, size_t capacity) const;
+
+  // 同上，out 按数组长度调整大小并复用已有容量，失败时返回 false
+  template <typename T>
+  bool getNumbers(const JsonPathView &path, std::vector<T> &out) const;
+
   // 设置值的模板方法 - 支持递归类型设置
-  template <typename T> bool set(const JsonPath &path, const T &value);
+  template <typename T> bool set(const JsonPathView &path, const T &value);
+
+  template <typename T> bool set(const JsonPath &path, const T &value) {
+    return set(JsonPathView(path), value);
+  }
 
   // 简化接口：直接接受列表初始化
   template <typename T>
-  bool set(std::initializer_list<JsonPath::PathElement> path_elements,
+  bool set(std::initializer_list<JsonPathView::PathElement> path_elements,
            const T &value) {
-    JsonPath path(path_elements);
-    return set(path, value);
+    return set(JsonPathView(path_elements), value);
   }
 
   // 检查路径是否存在
+  bool has(const JsonPathView &path) const;
   bool has(const JsonPath &path) const;
-
-  // 转换为字符串
-  std::string toString() const;
+  bool has(std::initializer_list<JsonPathView::PathElement> path_elements) const;
+
+  // 转换为字符串。indent 大于 0 时输出多行格式，每层缩进 indent 个空格
+  std::string toString(unsigned indent = 0) const;
+
+  // 只序列化 path 处的子树；与 get 一样，整个文档用 JsonPath::root()，
+  // 其他空路径什么也不选。路径不存在时返回空串
+  std::string toString(const JsonPathView &path, unsigned indent = 0) const;
+  std::string toString(const JsonPath &path, unsigned indent = 0) const;
+  std::string toString(std::initializer_list<JsonPathView::PathElement> path_elements,
+                       unsigned indent = 0) const;
+
+  // 从文件加载：mmap 后直接从映射区解析，不经过中间的 std::string。
+  // keep_mapping 为 true 时以私有可写映射原地解析，字符串值直接指向映射区，
+  // 映射随 JsonParam（及其拷贝）一起释放；否则解析完成后立即解除映射。
+  // 不做任何输出：打开或解析失败时返回无效的 JsonParam，error 非空时写入错误，
+  // 文件错误的 reason 为 "cannot open file" 或 "cannot map file"
+  static JsonParam fromFile(const std::string &path, bool keep_mapping = false,
+                            JsonParseError *error = nullptr);
+
+  // 序列化到文件（覆盖写），经固定大小的缓冲区流式写出，不构造完整字符串
+  bool toFile(const std::string &path) const;
+
+  // 以下 writeTo 均直接写入目标，不构造中间字符串；indent 含义同 toString。
+  // 经 fd、FILE* 和 sink 输出时先攒满固定大小（64KB）的块再整块交出。
+  // 文档含 NaN、Inf 等无法表示为 JSON 的数值时输出中途停止，返回 false（或 0），
+  // 此时 fd、FILE* 和 sink 可能已收到不完整的片段
+
+  // 序列化到已打开的文件描述符，不关闭 fd
+  bool writeTo(int fd, unsigned indent = 0) const;
+
+  // 序列化到 FILE*，不关闭也不 fflush；fwrite 出错时返回 false
+  bool writeTo(std::FILE *file, unsigned indent = 0) const;
+
+  // 追加到 out 末尾，失败时 out 保持不变。清空后反复复用同一个 out 可以省去每次的内存分配
+  bool writeTo(std::string &out, unsigned indent = 0) const;
+  // 只写 path 处的子树，路径规则同 toString(path)，路径不存在时返回 false
+  bool writeTo(std::string &out, const JsonPathView &path, unsigned indent = 0) const;
+
+  // 写入 [buffer, buffer + capacity)，不追加 '\0'。返回完整输出的字节数，
+  // 大于 capacity 时说明输出被截断，可按返回值分配后重写；文档无效或无法序列化时返回 0
+  size_t writeTo(char *buffer, size_t capacity, unsigned indent = 0) const;
+
+  // 按块依次交给 sink，sink 返回 false 时停止输出并返回 false
+  using ChunkSink = std::function<bool(std::string_view chunk)>;
+  bool writeTo(const ChunkSink &sink, unsigned indent = 0) const;
+
+  // 二进制编码：直接遍历 DOM 编码为 CBOR（RFC 8949）或 MessagePack，不经过文本。
+  // 整数取最短形式，能无损表示为单精度的浮点数只占 4 字节。
+  // 文档无效时返回空串；追加到 out 的版本返回 false
+  std::string toCbor() const;
+  bool toCbor(std::string &out) const;
+  std::string toMsgPack() const;
+  bool toMsgPack(std::string &out) const;
+
+  // 从 CBOR / MessagePack 直接构建 DOM，得到的文档与解析等价的 JSON 文本相同。
+  // 对象的键必须是字符串；字节串、扩展类型、NaN/无穷大等没有 JSON 对应物的数据，
+  // 以及数据不完整、有多余字节或嵌套超过 512 层时解码失败，不做任何输出，
+  // 结果带 reason 和偏移，value() 无效。CBOR 的标签被忽略，不定长的串、数组和映射均可解码
+  static JsonParseResult fromCbor(std::string_view data);
+  static JsonParseResult fromMsgPack(std::string_view data);
+
+  // 投影解析：以 SAX 方式扫描 json，只为 paths 命中的子树构建 DOM，其余内容
+  // 扫描后即丢弃。路径段可以是 JsonPath::kWildcard，如 {"items", kWildcard, "price"}。
+  // 命中的值保留在原文档中的位置，数组里位于命中元素之前的未命中元素以 null 占位，
+  // 因此结果可以用同样的路径直接 get。不做任何输出：解析失败时返回无效的
+  // JsonParam，error 非空时写入错误
+  static JsonParam parseProjected(std::string_view json,
+                                  const std::vector<JsonPath> &paths,
+                                  JsonParseError *error = nullptr);
+
+  // 原地重新解析 json，复用本对象上次 reset 留下的分配器内存块、Reader 的字符串栈
+  // 和 DOM 构建栈。首次调用时建立可复用的内存区，此后按历史峰值增长并一直保留到
+  // 对象析构，规模相近的反复解析不再向系统申请内存。不做任何输出：
+  // 解析失败时返回错误，对象变为无效
+  JsonParseError reset(std::string_view json);
+
+  // reset 保留的可复用内存字节数
+  size_t retainedBytes() const;
+
+  // 内存占用。RapidJSON 的分配器只增不减，set 覆盖或删除的旧值仍占着内存，
+  // wasted 即这部分的估计
+  struct MemoryUsage {
+    size_t capacity = 0; // 分配器向系统申请的字节数，含 reset 保留的内存区
+    size_t used = 0;     // 其中已分出的字节数
+    size_t live = 0;     // 当前树中成员数组、元素数组和字符串的字节数，含借用的存储
+    std::optional<size_t> wasted; // used 超出 live 的部分：被覆盖的旧值、扩容前的旧数组等
+    size_t anchors = 0;  // 随文档保留的输入缓冲区和来源文档个数，其内存不计入 capacity/used
+  };
+
+  // 遍历一次当前树。live 不区分存储归属：原地解析的字符串、与克隆来源共享的子树、
+  // update/applyPatch 右值版本接管的子树都计入 live，却不在本对象的分配器中。
+  // 这些存储都由 anchors_ 保持存活，anchors 不为 0 时 live 与 used 不可比，wasted 为空
+  MemoryUsage memoryUsage() const;
+
+  // 子树的占用，path 为 JSON Pointer（RFC 6901）
+  struct MemoryEntry {
+    std::string path;
+    size_t bytes = 0;  // 子树的字节数，含它在父容器中的槽位和键
+    size_t values = 0; // 子树中值的个数，含它自身
+  };
+
+  // 类似 du：列出 path 处的子树及其下 depth 层以内每个节点的占用，按 bytes 降序。
+  // 默认从根开始；路径不存在、为 root() 以外的空路径或对象无效时返回空
+  std::vector<MemoryEntry>
+  memoryBreakdown(size_t depth = 1,
+                  const JsonPathView &path = JsonPathView::root()) const;
 
   // 检查 JSON 是否有效
   bool isValid() const;
@@ -112,17 +659,74 @@ public:
   // 对于相同的键，other 的值会覆盖当前值
   bool update(const JsonParam &other);
 
-  // 克隆当前 JSON 对象
+  // 同上，但接管 other 的文档：新增的成员和数组元素按位移入而不复制，
+  // 代价只与 other 中的键数有关。other 随后无效，其内存随当前文档释放。
+  // 两个版本在当前对象无效时都直接采用 other 的内容，成员索引设置保持不变
+  bool update(JsonParam &&other);
+
+  // 依次把 sources 合并到当前对象，结果与逐个调用 update 相同，但每个键在所有
+  // 来源中只解析一次，只复制最终生效的值，被后续来源覆盖的值不会被复制。
+  // threads 大于 1 时顶层成员分给多个线程并行构建，为 0 时使用硬件线程数；
+  // 各线程的分配器随文档保留并在之后的并行合并中复用。
+  // sources 中的空指针和无效对象被跳过并返回 false，其余来源照常合并
+  bool mergeAll(const std::vector<const JsonParam *> &sources,
+                size_t threads = 1);
+
+  // 应用 JSON Patch（RFC 6902）：patch 是由 add/remove/replace/move/copy/test
+  // 操作组成的数组，路径为 JSON Pointer（RFC 6901）。每个操作只修改路径上的节点，
+  // 全部成功才生效；任一操作失败或 patch 格式错误时文档保持不变并返回 false。
+  // 右值与文本版本接管 patch 的文档，把值按位移入当前文档而不复制，
+  // 被接管的内存随当前文档释放。只有成功时才接管，失败时右值 patch 保持有效；
+  // patch 与克隆共享存储时按常量版本复制，不接管
+  bool applyPatch(const JsonParam &patch);
+  bool applyPatch(JsonParam &&patch);
+  bool applyPatch(std::string_view patch);
+
+  // 应用 JSON Merge Patch（RFC 7396）：对象逐成员递归合并，null 删除成员，
+  // 其余值（包括数组）整体替换。值的接管规则同 applyPatch
+  bool applyMergePatch(const JsonParam &patch);
+  bool applyMergePatch(JsonParam &&patch);
+  bool applyMergePatch(std::string_view patch);
+
+  // 克隆当前 JSON 对象。克隆与来源共享未修改的子树，代价与文档大小无关；
+  // 之后任一方 set/update 时只复制被写路径上的容器，双方互不可见。
+  // 来源由 reset 复用解析内存（如来自 JsonParamPool）时退化为深拷贝。
+  // 多个线程可以同时从同一来源 clone，但不能与来源的修改并发
   JsonParamPtr clone() const;
 
-  // 克隆指定路径的 JSON 子树
+  // 克隆指定路径的 JSON 子树，共享规则同上
+  JsonParamPtr clone(const JsonPathView &path) const;
   JsonParamPtr clone(const JsonPath &path) const;
 
   // 简化接口：直接接受列表初始化的路径
   JsonParamPtr
-  clone(std::initializer_list<JsonPath::PathElement> path_elements) const;
+  clone(std::initializer_list<JsonPathView::PathElement> path_elements) const;
+
+  // 默认的成员索引阈值
+  static constexpr size_t kMemberIndexThreshold = 64;
+
+  // 启用成员哈希索引：立即为当前文档中成员数不少于 threshold 的对象建立索引，
+  // 之后 get/set/has/update 对这些对象的 key 查找为 O(1)。只读查找不加锁，
+  // 并发的只读访问是安全的。修改路径上经过的大对象会顺便建立或补齐索引；
+  // update、applyPatch 整体移入的子树要到 refreshMemberIndex 之后才走索引，
+  // 在此之前只读查找退回线性扫描
+  void enableMemberIndex(size_t threshold = kMemberIndexThreshold);
+
+  // 为启用索引之后新出现的大对象补建索引，未启用时无效果。
+  // AtomicJsonParam::store(JsonParam&&) 发布前会自动调用
+  void refreshMemberIndex();
+
+  // 关闭并释放成员索引
+  void disableMemberIndex();
+
+  // 是否启用了成员索引
+  bool memberIndexEnabled() const { return member_index_ != nullptr; }
 
 private:
+  friend class JsonPathResults;
+  friend class JsonTapeView;
+  friend struct detail::StructAccess;
+
   // 类型特征检测
   template <typename T> struct is_vector : std::false_type {};
 
@@ -136,6 +740,11 @@ private:
   template <typename K, typename V>
   struct is_map<std::unordered_map<K, V>> : std::true_type {};
 
+  template <typename T> struct is_array_view : std::false_type {};
+
+  template <typename E>
+  struct is_array_view<JsonArrayView<E>> : std::true_type {};
+
   // 递归解析辅助函数
   template <typename T>
   T parseValue(const rapidjson::Value *value, const T &default_value) const;
@@ -159,25 +768,171 @@ private:
   bool setMap(rapidjson::Value *value, const MapType &new_value);
 
 private:
-  std::unique_ptr<rapidjson::Document> doc_;
+  // reset 复用的解析内存，doc_ 可能以其中的分配器构造，因此声明在 doc_ 之前
+  std::unique_ptr<JsonArena> arena_;
+
+  // 写时复制时被克隆共享，克隆通过 anchors_ 持有来源的 doc_
+  std::shared_ptr<rapidjson::Document> doc_;
+
+  // 成员哈希索引，未启用时为空
+  std::unique_ptr<JsonMemberIndex> member_index_;
+
+  // doc_ 中常量字符串引用的外部存储（原地解析的缓冲区等）。
+  // RapidJSON 拷贝值时共享常量字符串而不复制，因此拷贝、clone、update
+  // 都要把来源的 anchors_ 一并带上
+  std::vector<std::shared_ptr<const void>> anchors_;
+
+  // 并行 mergeAll 各线程的分配器，已登记在 anchors_ 中。之后的并行合并继续从中
+  // 分配，个数不超过用过的最大线程数；anchors_ 被替换或清空时一并清空
+  std::vector<std::shared_ptr<rapidjson::Document::AllocatorType>> merge_allocators_;
+
+  // 修改计数，每次修改文档时递增，供 JsonArrayView 在调试模式下检查
+  uint64_t generation_ = 0;
+
+  // 写时复制的共享纪元。为 0 时 doc_ 中的容器都归本对象独有；每次被 clone 或
+  // 拷贝时递增，此后只有 owned_ 中登记于当前纪元的容器存储可以原地修改，
+  // 其余存储可能被其他 JsonParam 引用，修改前要先复制。clone 是 const 操作，
+  // 可能在多个线程上同时进行，因此用原子变量
+  mutable std::atomic<uint64_t> share_epoch_{0};
+
+  // 当前纪元内本对象新分配的容器存储（成员数组或元素数组的地址）
+  std::unordered_set<const void *> owned_;
+  uint64_t owned_epoch_ = 0;
+
+  // 以下解析函数都不做输出，失败时置为无效并返回错误
+
+  // 原地解析 buffer，buffer 由 anchor 持有
+  JsonParseError parseAnchored(char *buffer, std::shared_ptr<const void> anchor);
+
+  // 用当前的扫描内核解析 '\0' 结尾的 json 到 doc_，insitu 时就地解码
+  JsonParseError parseTerminated(char *json, bool insitu);
+
+  // 解析 [data, data + length)，不要求 '\0' 结尾
+  JsonParseError parseLength(const char *data, size_t length);
+
+  // 取出 doc_ 的解析错误，失败时置为无效
+  JsonParseError takeParseError();
+
+  // 构造函数等旧接口的错误输出
+  static void reportParseError(const JsonParseError &error);
+
+  // 合并另一个文档的 anchors_
+  void adoptAnchors(const JsonParam &other);
+
+  // doc_ 是否使用 arena_ 的分配器
+  bool usesArena() const;
+
+  // 按位复制值的头部到 dst，子节点与字符串仍与 src 共享
+  static void shallowCopy(const rapidjson::Value &src, rapidjson::Value &dst);
+
+  // 以 other 中的 value 为根，与 other 共享子树；other 使用 arena 时深拷贝
+  void shareFrom(const JsonParam &other, const rapidjson::Value &value);
+
+  // shareFrom 之后沿用 other 的索引设置：共享存储时共享它的表，深拷贝时从空表开始
+  void inheritMemberIndex(const JsonParam &other);
+
+  // 写时复制：确保 value 的子节点存储归本对象独有，必要时复制一层。
+  // 取得子节点的可写引用之前必须先对其父容器调用
+  void unshare(rapidjson::Value &value);
+
+  // 追加可能使存储搬迁，追加后把 value 的新存储登记为独有
+  void markOwned(const rapidjson::Value &value);
+
+  // 接管 other 的文档及其外部存储，other 随后无效
+  void adoptDocument(JsonParam &other);
+
+  // 当前文档无效时直接换成 other 的文档（含 arena 与共享状态），
+  // 不涉及成员索引，other 随后无效
+  void takeDocument(JsonParam &other);
+
+  // 把来自 patch 的 src 放到 dst：steal 时按位移入（patch 的文档已被接管），
+  // 否则深拷贝到当前文档的分配器
+  void transferValue(const rapidjson::Value &src, rapidjson::Value &dst,
+                     bool steal);
+
+  // mergeAll 的实现，见 json_merge.cpp。mergeLayers 原地合并到 target；
+  // buildMerged 在 allocator 中构建 base 依次合并 layers 的结果，
+  // share_base 时 base 中未被覆盖的子树按位共享而不复制
+  void mergeLayers(rapidjson::Value &target,
+                   const rapidjson::Value *const *layers, size_t count);
+  static void buildMerged(const rapidjson::Value *base, bool share_base,
+                          const rapidjson::Value *const *layers, size_t count,
+                          rapidjson::Value &out,
+                          rapidjson::Document::AllocatorType &allocator);
+
+  // JSON Patch / Merge Patch 的实现，见 json_patch.cpp。
+  // PatchUndo 记录每次修改的撤销信息，patch 失败时倒序回放
+  class PatchUndo;
+  bool applyPatchOps(const rapidjson::Value &ops, bool steal);
+  bool applyPatchOp(const rapidjson::Value &op, bool steal, PatchUndo &undo);
+  void mergePatch(rapidjson::Value &target, const rapidjson::Value &patch,
+                  bool steal);
+  rapidjson::Value *resolvePointer(const std::vector<std::string> &tokens,
+                                   size_t count, PatchUndo &undo);
+  const rapidjson::Value *
+  resolvePointer(const std::vector<std::string> &tokens) const;
+  bool addAt(const std::vector<std::string> &tokens, rapidjson::Value &value,
+             PatchUndo &undo);
+  bool removeAt(const std::vector<std::string> &tokens,
+                rapidjson::Value *removed, PatchUndo &undo);
+
+  // 查找对象成员，成员数达到索引阈值时走哈希索引
+  rapidjson::Value::ConstMemberIterator
+  findMember(const rapidjson::Value &object, std::string_view key) const;
+  rapidjson::Value::MemberIterator findMember(rapidjson::Value &object,
+                                              std::string_view key);
+
+  // value 即将被覆盖或丢弃，释放其子树中对象的成员索引
+  void dropMemberIndex(const rapidjson::Value &value);
+
+  // 在对象末尾追加成员并同步索引，返回新成员的值
+  rapidjson::Value &appendMember(rapidjson::Value &object,
+                                 rapidjson::Value &name,
+                                 rapidjson::Value &value);
 
   // 根据路径获取 RapidJSON 值
-  const rapidjson::Value *getValueByPath(const JsonPath &path) const;
+  const rapidjson::Value *getValueByPath(const JsonPathView &path) const;
+
+  // 从 value 起执行计划中的 node 节点，结果写入 out
+  void extractNode(const JsonPathPlan &plan, uint32_t node,
+                   const rapidjson::Value &value,
+                   std::vector<const rapidjson::Value *> &out) const;
 
   // 根据路径获取可修改的 RapidJSON 值，如果路径不存在则创建
-  rapidjson::Value *getOrCreateValueByPath(const JsonPath &path);
+  rapidjson::Value *getOrCreateValueByPath(const JsonPathView &path);
 
   // 从 RapidJSON 值转换为目标类型
   template <typename T>
   T convertValue(const rapidjson::Value *value, const T &default_value) const;
 
   // update 方法的辅助函数
+  // steal 为 true 时 source 所在的文档已被接管，值按位移入而不复制
   void deepMerge(rapidjson::Value &target, const rapidjson::Value &source,
-                 rapidjson::Document::AllocatorType &allocator);
+                 rapidjson::Document::AllocatorType &allocator, bool steal);
   rapidjson::Value deepCopy(const rapidjson::Value &source,
                             rapidjson::Document::AllocatorType &allocator);
 };
 
+// JsonParam::parse / fromCbor / fromMsgPack 的结果
+class JsonParseResult {
+public:
+  bool ok() const { return error_.ok(); }
+  explicit operator bool() const { return ok(); }
+
+  const JsonParseError &error() const { return error_; }
+
+  // 解析得到的文档，失败时无效
+  JsonParam &value() & { return value_; }
+  const JsonParam &value() const & { return value_; }
+  JsonParam &&value() && { return std::move(value_); }
+
+private:
+  friend class JsonParam;
+
+  JsonParam value_;
+  JsonParseError error_;
+};
+
 // 移除 make_path 函数，使用简化的 get 接口
 
 } // namespace json
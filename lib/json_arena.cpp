@@ -0,0 +1,50 @@
+#include "json_arena.h"
+#include <cstring>
+
+namespace cpputil {
+namespace json {
+
+void* JsonArena::StackAllocator::Realloc(void* original, size_t original_size, size_t new_size) {
+    if (new_size <= capacity_) {
+        // 栈只会是这块缓冲区或空（上次解析结束时被"释放"）
+        return buffer_.get();
+    }
+    std::unique_ptr<char[]> grown(new char[new_size]);
+    if (original && original_size > 0) {
+        std::memcpy(grown.get(), original, original_size);
+    }
+    buffer_ = std::move(grown);
+    capacity_ = new_size;
+    return buffer_.get();
+}
+
+JsonArena::JsonArena() {
+    rebuild(kInitialBytes);
+}
+
+bool JsonArena::recycle() {
+    size_t used = allocator_->Capacity();
+    if (used <= buffer_capacity_) {
+        allocator_->Clear();
+        return false;
+    }
+    
+    // 容量按 2 的幂增长，避免规模小幅波动时反复重建
+    size_t bytes = capacity_;
+    while (bytes - (capacity_ - buffer_capacity_) < used) {
+        bytes *= 2;
+    }
+    rebuild(bytes);
+    return true;
+}
+
+void JsonArena::rebuild(size_t bytes) {
+    allocator_.reset();
+    buffer_.reset(new char[bytes]);
+    capacity_ = bytes;
+    allocator_ = std::make_unique<rapidjson::MemoryPoolAllocator<>>(buffer_.get(), bytes);
+    buffer_capacity_ = allocator_->Capacity();
+}
+
+} // namespace json
+} // namespace cpputil
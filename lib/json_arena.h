@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <rapidjson/document.h>
+
+namespace cpputil {
+namespace json {
+
+// JsonParam::reset 反复使用的解析内存：以用户缓冲区构造的 MemoryPoolAllocator、
+// 常驻的 Reader（保留其字符串栈）和 DOM 构建栈。MemoryPoolAllocator::Clear 只释放
+// 缓冲区之外追加的内存块，所以回收时若上次解析溢出了缓冲区，就按当时的总容量扩大
+// 缓冲区，之后同等规模的解析全部落在缓冲区内，不再向系统申请内存
+class JsonArena {
+public:
+  static constexpr size_t kInitialBytes = 4 * 1024;
+  // 构建栈的初始容量，与 RapidJSON 的默认值相同
+  static constexpr size_t kStackBytes = 1024;
+
+  // DOM 构建栈的分配器。Document 每次解析结束都会清空并释放构建栈
+  // （ClearStack 调用 ShrinkToFit），CrtAllocator 下每次解析都要重新 malloc。
+  // 这里始终交回同一块缓冲区，只在容量不足时扩大；Free 是静态函数，
+  // 不知道缓冲区属于哪个对象，因此什么也不做，缓冲区随 arena 释放
+  class StackAllocator {
+  public:
+    static const bool kNeedFree = true;
+
+    void *Malloc(size_t size) { return Realloc(nullptr, 0, size); }
+    void *Realloc(void *original, size_t original_size, size_t new_size);
+    static void Free(void *) {}
+
+  private:
+    std::unique_ptr<char[]> buffer_;
+    size_t capacity_ = 0;
+  };
+
+  // 以 arena 的分配器和构建栈解析的 Document，结果移入 JsonParam 的 doc_
+  using Builder = rapidjson::GenericDocument<rapidjson::UTF8<>, rapidjson::MemoryPoolAllocator<>,
+                                             StackAllocator>;
+
+  JsonArena();
+
+  JsonArena(const JsonArena &) = delete;
+  JsonArena &operator=(const JsonArena &) = delete;
+
+  rapidjson::MemoryPoolAllocator<> &allocator() { return *allocator_; }
+  rapidjson::Reader &reader() { return reader_; }
+  StackAllocator &stack() { return stack_; }
+
+  // 准备下一次解析，之前分配出去的内存全部失效。
+  // 返回 true 表示分配器被重建，引用旧分配器的 Document 需要重新创建
+  bool recycle();
+
+  // 缓冲区字节数
+  size_t capacity() const { return capacity_; }
+
+private:
+  void rebuild(size_t bytes);
+
+  std::unique_ptr<char[]> buffer_;
+  size_t capacity_ = 0;
+  // 分配器刚建立时的 Capacity()，超过它说明追加过内存块
+  size_t buffer_capacity_ = 0;
+  std::unique_ptr<rapidjson::MemoryPoolAllocator<>> allocator_;
+  rapidjson::Reader reader_;
+  StackAllocator stack_;
+};
+
+} // namespace json
+} // namespace cpputil
@@ -0,0 +1,731 @@
+#include "json.h"
+#include <rapidjson/document.h>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace cpputil {
+namespace json {
+
+namespace {
+
+// 解码时允许的最大嵌套层数，防止恶意输入耗尽栈
+constexpr size_t kMaxDepth = 512;
+
+// 能无损表示为单精度时返回 true
+bool fitsFloat(double d, float& f) {
+    if (!std::isfinite(d) || std::fabs(d) > FLT_MAX) {
+        return false;
+    }
+    f = static_cast<float>(d);
+    return static_cast<double>(f) == d;
+}
+
+// 按大端序追加 bytes 字节
+void putBigEndian(std::string& out, uint64_t v, size_t bytes) {
+    for (size_t i = bytes; i > 0; --i) {
+        out.push_back(static_cast<char>((v >> ((i - 1) * 8)) & 0xff));
+    }
+}
+
+// ==================== 编码 ====================
+
+class CborEncoder {
+public:
+    explicit CborEncoder(std::string& out) : out_(out) {}
+
+    void encode(const rapidjson::Value& value) {
+        switch (value.GetType()) {
+        case rapidjson::kNullType:
+            out_.push_back(static_cast<char>(0xf6));
+            break;
+        case rapidjson::kFalseType:
+            out_.push_back(static_cast<char>(0xf4));
+            break;
+        case rapidjson::kTrueType:
+            out_.push_back(static_cast<char>(0xf5));
+            break;
+        case rapidjson::kStringType:
+            head(3, value.GetStringLength());
+            out_.append(value.GetString(), value.GetStringLength());
+            break;
+        case rapidjson::kArrayType:
+            head(4, value.Size());
+            for (auto it = value.Begin(); it != value.End(); ++it) {
+                encode(*it);
+            }
+            break;
+        case rapidjson::kObjectType:
+            head(5, value.MemberCount());
+            for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+                head(3, it->name.GetStringLength());
+                out_.append(it->name.GetString(), it->name.GetStringLength());
+                encode(it->value);
+            }
+            break;
+        case rapidjson::kNumberType:
+            number(value);
+            break;
+        }
+    }
+
+private:
+    // 主类型 major 与参数 v，按最短形式编码
+    void head(uint8_t major, uint64_t v) {
+        uint8_t type = static_cast<uint8_t>(major << 5);
+        if (v < 24) {
+            out_.push_back(static_cast<char>(type | v));
+        } else if (v <= 0xff) {
+            out_.push_back(static_cast<char>(type | 24));
+            putBigEndian(out_, v, 1);
+        } else if (v <= 0xffff) {
+            out_.push_back(static_cast<char>(type | 25));
+            putBigEndian(out_, v, 2);
+        } else if (v <= 0xffffffff) {
+            out_.push_back(static_cast<char>(type | 26));
+            putBigEndian(out_, v, 4);
+        } else {
+            out_.push_back(static_cast<char>(type | 27));
+            putBigEndian(out_, v, 8);
+        }
+    }
+
+    void number(const rapidjson::Value& value) {
+        if (value.IsUint64()) {
+            head(0, value.GetUint64());
+        } else if (value.IsInt64()) {
+            // 负整数 n 编码为 -1 - n
+            head(1, static_cast<uint64_t>(-(value.GetInt64() + 1)));
+        } else {
+            double d = value.GetDouble();
+            float f = 0;
+            if (fitsFloat(d, f)) {
+                uint32_t bits;
+                std::memcpy(&bits, &f, sizeof(bits));
+                out_.push_back(static_cast<char>(0xfa));
+                putBigEndian(out_, bits, 4);
+            } else {
+                uint64_t bits;
+                std::memcpy(&bits, &d, sizeof(bits));
+                out_.push_back(static_cast<char>(0xfb));
+                putBigEndian(out_, bits, 8);
+            }
+        }
+    }
+
+    std::string& out_;
+};
+
+class MsgPackEncoder {
+public:
+    explicit MsgPackEncoder(std::string& out) : out_(out) {}
+
+    void encode(const rapidjson::Value& value) {
+        switch (value.GetType()) {
+        case rapidjson::kNullType:
+            out_.push_back(static_cast<char>(0xc0));
+            break;
+        case rapidjson::kFalseType:
+            out_.push_back(static_cast<char>(0xc2));
+            break;
+        case rapidjson::kTrueType:
+            out_.push_back(static_cast<char>(0xc3));
+            break;
+        case rapidjson::kStringType:
+            string(value.GetString(), value.GetStringLength());
+            break;
+        case rapidjson::kArrayType:
+            container(value.Size(), 0x90, 0xdc);
+            for (auto it = value.Begin(); it != value.End(); ++it) {
+                encode(*it);
+            }
+            break;
+        case rapidjson::kObjectType:
+            container(value.MemberCount(), 0x80, 0xde);
+            for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+                string(it->name.GetString(), it->name.GetStringLength());
+                encode(it->value);
+            }
+            break;
+        case rapidjson::kNumberType:
+            number(value);
+            break;
+        }
+    }
+
+private:
+    void tagged(uint8_t tag, uint64_t v, size_t bytes) {
+        out_.push_back(static_cast<char>(tag));
+        putBigEndian(out_, v, bytes);
+    }
+
+    void string(const char* str, size_t length) {
+        if (length < 32) {
+            out_.push_back(static_cast<char>(0xa0 | length));
+        } else if (length <= 0xff) {
+            tagged(0xd9, length, 1);
+        } else if (length <= 0xffff) {
+            tagged(0xda, length, 2);
+        } else {
+            tagged(0xdb, length, 4);
+        }
+        out_.append(str, length);
+    }
+
+    // fix 为 fixarray/fixmap 的前缀，tag16 之后紧跟 32 位长度的标记 tag16 + 1
+    void container(size_t count, uint8_t fix, uint8_t tag16) {
+        if (count < 16) {
+            out_.push_back(static_cast<char>(fix | count));
+        } else if (count <= 0xffff) {
+            tagged(tag16, count, 2);
+        } else {
+            tagged(static_cast<uint8_t>(tag16 + 1), count, 4);
+        }
+    }
+
+    void number(const rapidjson::Value& value) {
+        if (value.IsUint64()) {
+            uint64_t u = value.GetUint64();
+            if (u <= 0x7f) {
+                out_.push_back(static_cast<char>(u));
+            } else if (u <= 0xff) {
+                tagged(0xcc, u, 1);
+            } else if (u <= 0xffff) {
+                tagged(0xcd, u, 2);
+            } else if (u <= 0xffffffff) {
+                tagged(0xce, u, 4);
+            } else {
+                tagged(0xcf, u, 8);
+            }
+        } else if (value.IsInt64()) {
+            int64_t i = value.GetInt64();
+            uint64_t bits = static_cast<uint64_t>(i);
+            if (i >= -32) {
+                out_.push_back(static_cast<char>(bits & 0xff));
+            } else if (i >= std::numeric_limits<int8_t>::min()) {
+                tagged(0xd0, bits, 1);
+            } else if (i >= std::numeric_limits<int16_t>::min()) {
+                tagged(0xd1, bits, 2);
+            } else if (i >= std::numeric_limits<int32_t>::min()) {
+                tagged(0xd2, bits, 4);
+            } else {
+                tagged(0xd3, bits, 8);
+            }
+        } else {
+            double d = value.GetDouble();
+            float f = 0;
+            if (fitsFloat(d, f)) {
+                uint32_t bits;
+                std::memcpy(&bits, &f, sizeof(bits));
+                tagged(0xca, bits, 4);
+            } else {
+                uint64_t bits;
+                std::memcpy(&bits, &d, sizeof(bits));
+                tagged(0xcb, bits, 8);
+            }
+        }
+    }
+
+    std::string& out_;
+};
+
+// ==================== 解码 ====================
+
+// 解码器公共部分：按字节读取输入并记录第一个错误。
+// 解码结果以 SAX 事件交给 handler（rapidjson::Document），整数按文本解析时的规则
+// 选择 Int/Uint/Int64/Uint64，得到的 DOM 与解析等价的 JSON 文本完全相同
+class Decoder {
+public:
+    explicit Decoder(std::string_view data) : data_(data) {}
+
+    size_t offset() const { return pos_; }
+    const char* error() const { return error_; }
+
+    bool finish() {
+        return pos_ == data_.size() || fail("trailing bytes after value");
+    }
+
+protected:
+    bool fail(const char* message) {
+        if (!error_) {
+            error_ = message;
+        }
+        return false;
+    }
+
+    bool byte(uint8_t& b) {
+        if (pos_ >= data_.size()) {
+            return fail("unexpected end of data");
+        }
+        b = static_cast<uint8_t>(data_[pos_++]);
+        return true;
+    }
+
+    bool bigEndian(size_t bytes, uint64_t& v) {
+        if (data_.size() - pos_ < bytes) {
+            return fail("unexpected end of data");
+        }
+        v = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            v = (v << 8) | static_cast<uint8_t>(data_[pos_++]);
+        }
+        return true;
+    }
+
+    bool bytes(uint64_t length, const char*& out) {
+        if (data_.size() - pos_ < length) {
+            return fail("unexpected end of data");
+        }
+        out = data_.data() + pos_;
+        pos_ += static_cast<size_t>(length);
+        return true;
+    }
+
+    bool checkLength(uint64_t length) {
+        return length <= std::numeric_limits<rapidjson::SizeType>::max() || fail("length too large");
+    }
+
+    template <typename Handler>
+    static bool emitUnsigned(Handler& handler, uint64_t u) {
+        return u <= std::numeric_limits<uint32_t>::max() ? handler.Uint(static_cast<unsigned>(u))
+                                                         : handler.Uint64(u);
+    }
+
+    template <typename Handler>
+    static bool emitSigned(Handler& handler, int64_t i) {
+        if (i >= 0) {
+            return emitUnsigned(handler, static_cast<uint64_t>(i));
+        }
+        return i >= std::numeric_limits<int32_t>::min() ? handler.Int(static_cast<int>(i)) : handler.Int64(i);
+    }
+
+    // JSON 不能表示 NaN 和无穷大
+    template <typename Handler>
+    bool emitDouble(Handler& handler, double d) {
+        return std::isfinite(d) ? handler.Double(d) : fail("non-finite numbers are not supported");
+    }
+
+    static double floatFromBits(uint64_t bits) {
+        uint32_t b = static_cast<uint32_t>(bits);
+        float f;
+        std::memcpy(&f, &b, sizeof(f));
+        return f;
+    }
+
+    static double doubleFromBits(uint64_t bits) {
+        double d;
+        std::memcpy(&d, &bits, sizeof(d));
+        return d;
+    }
+
+    std::string_view data_;
+    size_t pos_ = 0;
+    const char* error_ = nullptr;
+};
+
+class CborDecoder : public Decoder {
+public:
+    using Decoder::Decoder;
+
+    template <typename Handler>
+    bool value(Handler& handler, size_t depth) {
+        if (depth > kMaxDepth) {
+            return fail("nesting too deep");
+        }
+        uint8_t initial = 0;
+        if (!byte(initial)) {
+            return false;
+        }
+        uint8_t major = initial >> 5;
+        uint8_t info = initial & 0x1f;
+
+        if (major == 7) {
+            return simple(handler, info);
+        }
+        if (major == 6) {
+            // 标签只是语义注解，跳过后解码被标注的值
+            uint64_t tag = 0;
+            return argument(info, tag) && value(handler, depth + 1);
+        }
+        if (info == 31) {
+            return indefinite(handler, major, depth);
+        }
+
+        uint64_t arg = 0;
+        if (!argument(info, arg)) {
+            return false;
+        }
+        switch (major) {
+        case 0:
+            return emitUnsigned(handler, arg);
+        case 1:
+            if (arg <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+                return emitSigned(handler, -1 - static_cast<int64_t>(arg));
+            }
+            return handler.Double(-1.0 - static_cast<double>(arg));
+        case 2:
+            return fail("byte strings are not supported");
+        case 3: {
+            const char* str = nullptr;
+            return checkLength(arg) && bytes(arg, str) &&
+                   handler.String(str, static_cast<rapidjson::SizeType>(arg), true);
+        }
+        case 4:
+            if (!checkLength(arg) || !handler.StartArray()) {
+                return false;
+            }
+            for (uint64_t i = 0; i < arg; ++i) {
+                if (!value(handler, depth + 1)) {
+                    return false;
+                }
+            }
+            return handler.EndArray(static_cast<rapidjson::SizeType>(arg));
+        default:
+            if (!checkLength(arg) || !handler.StartObject()) {
+                return false;
+            }
+            for (uint64_t i = 0; i < arg; ++i) {
+                if (!key(handler) || !value(handler, depth + 1)) {
+                    return false;
+                }
+            }
+            return handler.EndObject(static_cast<rapidjson::SizeType>(arg));
+        }
+    }
+
+private:
+    // info 为 24～27 时参数跟在后面，31 表示不定长，28～30 保留
+    bool argument(uint8_t info, uint64_t& arg) {
+        if (info < 24) {
+            arg = info;
+            return true;
+        }
+        if (info <= 27) {
+            return bigEndian(size_t(1) << (info - 24), arg);
+        }
+        return fail("invalid additional information");
+    }
+
+    bool peekBreak() {
+        if (pos_ < data_.size() && static_cast<uint8_t>(data_[pos_]) == 0xff) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    template <typename Handler>
+    bool simple(Handler& handler, uint8_t info) {
+        uint64_t bits = 0;
+        switch (info) {
+        case 20:
+            return handler.Bool(false);
+        case 21:
+            return handler.Bool(true);
+        case 22:
+        case 23:  // undefined 没有 JSON 对应物，按 null 处理
+            return handler.Null();
+        case 25:
+            return bigEndian(2, bits) && emitDouble(handler, halfToDouble(static_cast<uint16_t>(bits)));
+        case 26:
+            return bigEndian(4, bits) && emitDouble(handler, floatFromBits(bits));
+        case 27:
+            return bigEndian(8, bits) && emitDouble(handler, doubleFromBits(bits));
+        default:
+            return fail("unsupported simple value");
+        }
+    }
+
+    static double halfToDouble(uint16_t half) {
+        int exponent = (half >> 10) & 0x1f;
+        int mantissa = half & 0x3ff;
+        double value;
+        if (exponent == 0) {
+            value = std::ldexp(mantissa, -24);
+        } else if (exponent != 31) {
+            value = std::ldexp(mantissa + 1024, exponent - 25);
+        } else {
+            value = mantissa == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+        }
+        return (half & 0x8000) ? -value : value;
+    }
+
+    // 对象的键必须是文本串
+    template <typename Handler>
+    bool key(Handler& handler) {
+        uint8_t initial = 0;
+        if (!byte(initial)) {
+            return false;
+        }
+        if ((initial >> 5) != 3) {
+            return fail("map keys must be text strings");
+        }
+        std::string chunked;
+        const char* str = nullptr;
+        uint64_t length = 0;
+        if ((initial & 0x1f) == 31) {
+            if (!textChunks(chunked)) {
+                return false;
+            }
+            str = chunked.data();
+            length = chunked.size();
+        } else if (!argument(initial & 0x1f, length) || !checkLength(length) || !bytes(length, str)) {
+            return false;
+        }
+        return handler.Key(str, static_cast<rapidjson::SizeType>(length), true);
+    }
+
+    // 不定长文本串：若干定长文本串分片，以 0xff 结束
+    bool textChunks(std::string& out) {
+        while (!peekBreak()) {
+            uint8_t initial = 0;
+            uint64_t length = 0;
+            const char* str = nullptr;
+            if (!byte(initial)) {
+                return false;
+            }
+            if ((initial >> 5) != 3 || (initial & 0x1f) == 31) {
+                return fail("invalid text string chunk");
+            }
+            if (!argument(initial & 0x1f, length) || !bytes(length, str)) {
+                return false;
+            }
+            out.append(str, static_cast<size_t>(length));
+        }
+        return checkLength(out.size());
+    }
+
+    template <typename Handler>
+    bool indefinite(Handler& handler, uint8_t major, size_t depth) {
+        rapidjson::SizeType count = 0;
+        switch (major) {
+        case 3: {
+            std::string text;
+            return textChunks(text) &&
+                   handler.String(text.data(), static_cast<rapidjson::SizeType>(text.size()), true);
+        }
+        case 4:
+            if (!handler.StartArray()) {
+                return false;
+            }
+            for (; !peekBreak(); ++count) {
+                if (!value(handler, depth + 1)) {
+                    return false;
+                }
+            }
+            return handler.EndArray(count);
+        case 5:
+            if (!handler.StartObject()) {
+                return false;
+            }
+            for (; !peekBreak(); ++count) {
+                if (!key(handler) || !value(handler, depth + 1)) {
+                    return false;
+                }
+            }
+            return handler.EndObject(count);
+        default:
+            return fail("invalid indefinite-length item");
+        }
+    }
+};
+
+class MsgPackDecoder : public Decoder {
+public:
+    using Decoder::Decoder;
+
+    template <typename Handler>
+    bool value(Handler& handler, size_t depth) {
+        if (depth > kMaxDepth) {
+            return fail("nesting too deep");
+        }
+        uint8_t tag = 0;
+        if (!byte(tag)) {
+            return false;
+        }
+        if (tag <= 0x7f) {
+            return handler.Uint(tag);
+        }
+        if (tag >= 0xe0) {
+            return handler.Int(static_cast<int8_t>(tag));
+        }
+        if ((tag & 0xe0) == 0xa0) {
+            return string(handler, tag & 0x1f, false);
+        }
+        if ((tag & 0xf0) == 0x90) {
+            return array(handler, tag & 0x0f, depth);
+        }
+        if ((tag & 0xf0) == 0x80) {
+            return map(handler, tag & 0x0f, depth);
+        }
+
+        uint64_t v = 0;
+        switch (tag) {
+        case 0xc0:
+            return handler.Null();
+        case 0xc2:
+            return handler.Bool(false);
+        case 0xc3:
+            return handler.Bool(true);
+        case 0xca:
+            return bigEndian(4, v) && emitDouble(handler, floatFromBits(v));
+        case 0xcb:
+            return bigEndian(8, v) && emitDouble(handler, doubleFromBits(v));
+        case 0xcc:
+        case 0xcd:
+        case 0xce:
+        case 0xcf:
+            return bigEndian(size_t(1) << (tag - 0xcc), v) && emitUnsigned(handler, v);
+        case 0xd0:
+            return bigEndian(1, v) && emitSigned(handler, static_cast<int8_t>(v));
+        case 0xd1:
+            return bigEndian(2, v) && emitSigned(handler, static_cast<int16_t>(v));
+        case 0xd2:
+            return bigEndian(4, v) && emitSigned(handler, static_cast<int32_t>(v));
+        case 0xd3:
+            return bigEndian(8, v) && emitSigned(handler, static_cast<int64_t>(v));
+        case 0xd9:
+        case 0xda:
+        case 0xdb:
+            return bigEndian(size_t(1) << (tag - 0xd9), v) && string(handler, v, false);
+        case 0xdc:
+        case 0xdd:
+            return bigEndian(tag == 0xdc ? 2 : 4, v) && array(handler, v, depth);
+        case 0xde:
+        case 0xdf:
+            return bigEndian(tag == 0xde ? 2 : 4, v) && map(handler, v, depth);
+        default:
+            // bin、ext 等没有 JSON 对应物
+            return fail("unsupported type");
+        }
+    }
+
+private:
+    template <typename Handler>
+    bool string(Handler& handler, uint64_t length, bool is_key) {
+        const char* str = nullptr;
+        if (!checkLength(length) || !bytes(length, str)) {
+            return false;
+        }
+        auto size = static_cast<rapidjson::SizeType>(length);
+        return is_key ? handler.Key(str, size, true) : handler.String(str, size, true);
+    }
+
+    template <typename Handler>
+    bool key(Handler& handler) {
+        uint8_t tag = 0;
+        uint64_t length = 0;
+        if (!byte(tag)) {
+            return false;
+        }
+        if ((tag & 0xe0) == 0xa0) {
+            length = tag & 0x1f;
+        } else if (tag >= 0xd9 && tag <= 0xdb) {
+            if (!bigEndian(size_t(1) << (tag - 0xd9), length)) {
+                return false;
+            }
+        } else {
+            return fail("map keys must be strings");
+        }
+        return string(handler, length, true);
+    }
+
+    template <typename Handler>
+    bool array(Handler& handler, uint64_t count, size_t depth) {
+        if (!checkLength(count) || !handler.StartArray()) {
+            return false;
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            if (!value(handler, depth + 1)) {
+                return false;
+            }
+        }
+        return handler.EndArray(static_cast<rapidjson::SizeType>(count));
+    }
+
+    template <typename Handler>
+    bool map(Handler& handler, uint64_t count, size_t depth) {
+        if (!checkLength(count) || !handler.StartObject()) {
+            return false;
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            if (!key(handler) || !value(handler, depth + 1)) {
+                return false;
+            }
+        }
+        return handler.EndObject(static_cast<rapidjson::SizeType>(count));
+    }
+};
+
+// 解码整个输入为一个值，失败时返回出错的位置和原因
+template <typename DecoderType>
+JsonParseError decodeInto(rapidjson::Document& doc, std::string_view data) {
+    DecoderType decoder(data);
+    bool ok = false;
+    auto generator = [&](rapidjson::Document& handler) {
+        ok = decoder.value(handler, 0) && decoder.finish();
+        return ok;
+    };
+    doc.Populate(generator);
+    JsonParseError error;
+    if (!ok) {
+        error.code = rapidjson::kParseErrorValueInvalid;
+        error.offset = decoder.offset();
+        error.reason = decoder.error() ? decoder.error() : "invalid data";
+    }
+    return error;
+}
+
+} // namespace
+
+std::string JsonParam::toCbor() const {
+    std::string out;
+    toCbor(out);
+    return out;
+}
+
+bool JsonParam::toCbor(std::string& out) const {
+    if (!isValid()) {
+        return false;
+    }
+    CborEncoder(out).encode(*doc_);
+    return true;
+}
+
+std::string JsonParam::toMsgPack() const {
+    std::string out;
+    toMsgPack(out);
+    return out;
+}
+
+bool JsonParam::toMsgPack(std::string& out) const {
+    if (!isValid()) {
+        return false;
+    }
+    MsgPackEncoder(out).encode(*doc_);
+    return true;
+}
+
+JsonParseResult JsonParam::fromCbor(std::string_view data) {
+    JsonParseResult result;
+    result.value_.doc_ = std::make_shared<rapidjson::Document>();
+    result.error_ = decodeInto<CborDecoder>(*result.value_.doc_, data);
+    if (!result.ok()) {
+        result.value_.doc_.reset();
+    }
+    return result;
+}
+
+JsonParseResult JsonParam::fromMsgPack(std::string_view data) {
+    JsonParseResult result;
+    result.value_.doc_ = std::make_shared<rapidjson::Document>();
+    result.error_ = decodeInto<MsgPackDecoder>(*result.value_.doc_, data);
+    if (!result.ok()) {
+        result.value_.doc_.reset();
+    }
+    return result;
+}
+
+} // namespace json
+} // namespace cpputil
@@ -0,0 +1,134 @@
+#include "json.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cpputil {
+namespace json {
+
+namespace {
+
+// 只读打开的文件描述符，析构时关闭
+class ScopedFd {
+public:
+    explicit ScopedFd(int fd) : fd_(fd) {}
+    ~ScopedFd() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+    ScopedFd(const ScopedFd&) = delete;
+    ScopedFd& operator=(const ScopedFd&) = delete;
+
+    int get() const { return fd_; }
+
+private:
+    int fd_;
+};
+
+// 文件映射，析构时解除映射
+class FileMapping {
+public:
+    FileMapping(void* addr, size_t length) : addr_(addr), length_(length) {}
+    ~FileMapping() {
+        if (addr_ != MAP_FAILED) {
+            ::munmap(addr_, length_);
+        }
+    }
+    FileMapping(const FileMapping&) = delete;
+    FileMapping& operator=(const FileMapping&) = delete;
+
+    char* data() const { return static_cast<char*>(addr_); }
+
+private:
+    void* addr_;
+    size_t length_;
+};
+
+// 映射 size 字节的文件。writable_nul 为 true 时映射为私有可写，并保证
+// data()[size] 为 '\\0'：先保留一段多出一字节的匿名映射，再把文件覆盖映射到其开头，
+// 文件恰好是页大小整数倍时，结尾的 '\\0' 落在匿名页上
+std::unique_ptr<FileMapping> mapFile(int fd, size_t size, bool writable_nul) {
+    if (!writable_nul) {
+        void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        return addr == MAP_FAILED ? nullptr : std::make_unique<FileMapping>(addr, size);
+    }
+    
+    size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t length = (size + 1 + page - 1) / page * page;
+    void* base = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        return nullptr;
+    }
+    auto mapping = std::make_unique<FileMapping>(base, length);
+    if (::mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        return nullptr;
+    }
+    return mapping;
+}
+
+// 文件本身的错误，reason 为静态描述
+JsonParam fileError(JsonParseError* error, const char* reason) {
+    if (error) {
+        *error = JsonParseError{rapidjson::kParseErrorValueInvalid, 0, reason};
+    }
+    return JsonParam();
+}
+
+JsonParam takeResult(JsonParseResult&& result, JsonParseError* error) {
+    if (error) {
+        *error = result.error();
+    }
+    return std::move(result).value();
+}
+
+} // namespace
+
+JsonParam JsonParam::fromFile(const std::string& path, bool keep_mapping, JsonParseError* error) {
+    ScopedFd fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    struct stat st;
+    if (fd.get() < 0 || ::fstat(fd.get(), &st) != 0) {
+        return fileError(error, "cannot open file");
+    }
+    
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+        // 空文件不能映射，按空文本解析以得到一致的错误
+        return takeResult(parse(std::string_view()), error);
+    }
+    
+    std::unique_ptr<FileMapping> mapping = mapFile(fd.get(), size, keep_mapping);
+    if (!mapping) {
+        return fileError(error, "cannot map file");
+    }
+    
+    if (!keep_mapping) {
+        // 从只读映射解析，字符串拷贝进 document，返回时解除映射
+        return takeResult(parse(std::string_view(mapping->data(), size)), error);
+    }
+    
+    JsonParam result;
+    result.doc_ = std::make_shared<rapidjson::Document>();
+    char* data = mapping->data();
+    JsonParseError parsed = result.parseAnchored(data, std::shared_ptr<FileMapping>(std::move(mapping)));
+    if (error) {
+        *error = parsed;
+    }
+    return result;
+}
+
+bool JsonParam::toFile(const std::string& path) const {
+    if (!isValid()) {
+        return false;
+    }
+    
+    ScopedFd fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+    if (fd.get() < 0) {
+        return false;
+    }
+    return writeTo(fd.get());
+}
+
+} // namespace json
+} // namespace cpputil
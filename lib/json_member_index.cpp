@@ -0,0 +1,187 @@
+#include "json_member_index.h"
+
+namespace cpputil {
+namespace json {
+
+namespace {
+
+inline size_t hashKey(std::string_view key) {
+    return std::hash<std::string_view>{}(key);
+}
+
+} // namespace
+
+const void* JsonMemberIndex::membersOf(const rapidjson::Value& object) {
+    return object.MemberCount() > 0 ? static_cast<const void*>(&*object.MemberBegin()) : nullptr;
+}
+
+std::string_view JsonMemberIndex::nameAt(const rapidjson::Value& object, rapidjson::SizeType pos) {
+    const rapidjson::Value& name = object.MemberBegin()[pos].name;
+    return std::string_view(name.GetString(), name.GetStringLength());
+}
+
+size_t JsonMemberIndex::probe(const Table& table, const rapidjson::Value& object, std::string_view key) {
+    size_t hash = hashKey(key);
+    size_t mask = table.slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const Slot& slot = table.slots[i];
+        if (slot.pos == 0) {
+            return npos;
+        }
+        if (slot.hash == hash && nameAt(object, slot.pos - 1) == key) {
+            return slot.pos - 1;
+        }
+    }
+}
+
+size_t JsonMemberIndex::find(const rapidjson::Value& object, std::string_view key) const {
+    auto it = tables_->find(membersOf(object));
+    if (it != tables_->end() && it->second->count == object.MemberCount()) {
+        return probe(*it->second, object, key);
+    }
+    // 没有表或表不完整：只读路径不能建表，线性查找
+    for (rapidjson::SizeType pos = 0; pos < object.MemberCount(); ++pos) {
+        if (nameAt(object, pos) == key) {
+            return pos;
+        }
+    }
+    return npos;
+}
+
+size_t JsonMemberIndex::findOrBuild(const rapidjson::Value& object, std::string_view key) {
+    return probe(tableFor(object), object, key);
+}
+
+void JsonMemberIndex::build(const rapidjson::Value& value) {
+    if (value.IsObject()) {
+        if (covers(value)) {
+            tableFor(value);
+        }
+        for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+            build(it->value);
+        }
+    } else if (value.IsArray()) {
+        for (auto it = value.Begin(); it != value.End(); ++it) {
+            build(*it);
+        }
+    }
+}
+
+void JsonMemberIndex::rebase(const void* old_members, const rapidjson::Value& object) {
+    const void* members = membersOf(object);
+    if (!tables_->count(old_members)) {
+        // 还没有建立索引，等下一次修改路径上的查找或 build 时再建
+        return;
+    }
+    if (old_members != members) {
+        // 成员数组搬迁，索引中的下标仍然有效
+        TableMap& tables = mutableTables();
+        auto it = tables.find(old_members);
+        std::shared_ptr<Table> table = std::move(it->second);
+        tables.erase(it);
+        tables[members] = std::move(table);
+    }
+    if (covers(object)) {
+        tableFor(object);
+    }
+}
+
+void JsonMemberIndex::invalidate(const rapidjson::Value& object) {
+    if (tables_->count(membersOf(object))) {
+        mutableTables().erase(membersOf(object));
+    }
+}
+
+void JsonMemberIndex::forget(const rapidjson::Value& value) {
+    if (tables_->empty()) {
+        return;
+    }
+    if (value.IsObject()) {
+        invalidate(value);
+        for (auto it = value.MemberBegin(); it != value.MemberEnd() && !tables_->empty(); ++it) {
+            forget(it->value);
+        }
+    } else if (value.IsArray()) {
+        for (auto it = value.Begin(); it != value.End() && !tables_->empty(); ++it) {
+            forget(*it);
+        }
+    }
+}
+
+void JsonMemberIndex::clear() {
+    tables_ = std::make_shared<TableMap>();
+}
+
+JsonMemberIndex::TableMap& JsonMemberIndex::mutableTables() {
+    if (tables_.use_count() > 1) {
+        tables_ = std::make_shared<TableMap>(*tables_);
+    }
+    return *tables_;
+}
+
+const JsonMemberIndex::Table& JsonMemberIndex::tableFor(const rapidjson::Value& object) {
+    auto found = tables_->find(membersOf(object));
+    if (found != tables_->end() && found->second->count == object.MemberCount()) {
+        return *found->second;
+    }
+    std::shared_ptr<Table>& table = mutableTables()[membersOf(object)];
+    if (!table) {
+        table = std::make_shared<Table>();
+    } else if (table.use_count() > 1) {
+        // 与克隆共享的表，修改前复制
+        table = std::make_shared<Table>(*table);
+    }
+    if (table->count > object.MemberCount()) {
+        // 成员被删除但没有通知，重建
+        *table = Table();
+    }
+    while (table->count < object.MemberCount()) {
+        insert(*table, object, table->count);
+    }
+    return *table;
+}
+
+void JsonMemberIndex::insert(Table& table, const rapidjson::Value& object, rapidjson::SizeType pos) {
+    // 负载因子保持在 1/2 以下
+    if ((table.count + 1) * 2 > table.slots.size()) {
+        grow(table);
+    }
+    ++table.count;
+
+    std::string_view key = nameAt(object, pos);
+    size_t hash = hashKey(key);
+    size_t mask = table.slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        Slot& slot = table.slots[i];
+        if (slot.pos == 0) {
+            slot.hash = hash;
+            slot.pos = pos + 1;
+            return;
+        }
+        if (slot.hash == hash && nameAt(object, slot.pos - 1) == key) {
+            // 重复的 key 与线性查找保持一致，只索引第一次出现的位置
+            return;
+        }
+    }
+}
+
+void JsonMemberIndex::grow(Table& table) {
+    size_t capacity = table.slots.empty() ? 16 : table.slots.size() * 2;
+    std::vector<Slot> old_slots(capacity, Slot{0, 0});
+    old_slots.swap(table.slots);
+
+    size_t mask = capacity - 1;
+    for (const Slot& slot : old_slots) {
+        if (slot.pos == 0) {
+            continue;
+        }
+        size_t i = slot.hash & mask;
+        while (table.slots[i].pos != 0) {
+            i = (i + 1) & mask;
+        }
+        table.slots[i] = slot;
+    }
+}
+
+} // namespace json
+} // namespace cpputil
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <rapidjson/document.h>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace cpputil {
+namespace json {
+
+// 大对象成员哈希索引。
+// 以对象成员数组的地址为键，为每个成员数不少于阈值的对象维护一张
+// key -> 成员下标 的开放寻址表；表内只保存哈希和下标，比较时回到成员名本身，
+// 因此不拷贝 key，也不受 RapidJSON 短字符串随成员数组搬迁的影响。
+//
+// 只读查找不修改索引、不加锁，可以在多个线程上并发；对象还没有完整的表时
+// 退回线性查找。表只在修改路径（findOrBuild、build 及各个通知）上建立和维护，
+// 这些调用与只读查找不能并发，与文档本身的规则一致。
+// 成员数组搬迁时由 rebase 迁移索引；成员被删除时调用 invalidate；
+// 值被覆盖或丢弃时调用 forget，否则旧表会一直留在索引中
+class JsonMemberIndex {
+public:
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  explicit JsonMemberIndex(size_t threshold)
+      : threshold_(threshold), tables_(std::make_shared<TableMap>()) {}
+
+  // 与来源共享全部表（写时复制），供共享存储的 clone 与拷贝使用：共享的成员数组
+  // 地址相同，表对两边都有效。拷贝的代价是常数，任一方第一次修改索引时才复制表的集合
+  JsonMemberIndex(const JsonMemberIndex &other) = default;
+  JsonMemberIndex &operator=(const JsonMemberIndex &) = delete;
+
+  size_t threshold() const { return threshold_; }
+
+  // 对象是否应该走索引
+  bool covers(const rapidjson::Value &object) const {
+    return object.MemberCount() >= threshold_;
+  }
+
+  // 返回 key 在 object 中第一次出现的下标，不存在返回 npos。只读，没有完整的表时线性查找
+  size_t find(const rapidjson::Value &object, std::string_view key) const;
+
+  // 同上，按需建立或补齐 object 的表
+  size_t findOrBuild(const rapidjson::Value &object, std::string_view key);
+
+  // 为 value 子树中所有达到阈值的对象建立或补齐表
+  void build(const rapidjson::Value &value);
+
+  // object 的成员数组从 old_members 搬迁（追加扩容、写时复制），把表迁到新地址并补齐
+  void rebase(const void *old_members, const rapidjson::Value &object);
+
+  // object 的成员被删除或重排，丢弃它的索引
+  void invalidate(const rapidjson::Value &object);
+
+  // value 即将被覆盖或丢弃，丢弃其子树中所有对象的索引
+  void forget(const rapidjson::Value &value);
+
+  // 丢弃全部索引
+  void clear();
+
+  // 当前的表数
+  size_t tables() const { return tables_->size(); }
+
+private:
+  struct Slot {
+    size_t hash;
+    rapidjson::SizeType pos;  // 成员下标 + 1，0 表示空槽
+  };
+
+  struct Table {
+    rapidjson::SizeType count = 0;  // 已建立索引的成员数
+    std::vector<Slot> slots;
+  };
+
+  using TableMap = std::unordered_map<const void *, std::shared_ptr<Table>>;
+
+  static const void *membersOf(const rapidjson::Value &object);
+  static std::string_view nameAt(const rapidjson::Value &object, rapidjson::SizeType pos);
+  static size_t probe(const Table &table, const rapidjson::Value &object, std::string_view key);
+
+  // object 的完整表，与其他索引共享时先复制
+  const Table &tableFor(const rapidjson::Value &object);
+  void insert(Table &table, const rapidjson::Value &object, rapidjson::SizeType pos);
+  void grow(Table &table);
+
+  // 修改表的集合之前调用，与其他索引共享时先复制（只复制指针，各表仍共享）
+  TableMap &mutableTables();
+
+  size_t threshold_;
+  std::shared_ptr<TableMap> tables_;
+};
+
+} // namespace json
+} // namespace cpputil
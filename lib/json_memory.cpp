@@ -0,0 +1,156 @@
+#include "json.h"
+#include <rapidjson/document.h>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cpputil {
+namespace json {
+
+namespace {
+
+// 字符串在值之外占用的字节数；短字符串存放在值内部，不额外占用
+size_t stringBytes(const rapidjson::Value& value) {
+    auto self = reinterpret_cast<uintptr_t>(&value);
+    auto str = reinterpret_cast<uintptr_t>(value.GetString());
+    if (str >= self && str < self + sizeof(rapidjson::Value)) {
+        return 0;
+    }
+    return static_cast<size_t>(value.GetStringLength()) + 1;
+}
+
+// 追加一段 JSON Pointer，'~' 与 '/' 转义为 "~0" 和 "~1"
+void appendToken(std::string& pointer, std::string_view token) {
+    pointer += '/';
+    for (char c : token) {
+        if (c == '~') {
+            pointer += "~0";
+        } else if (c == '/') {
+            pointer += "~1";
+        } else {
+            pointer += c;
+        }
+    }
+}
+
+struct Usage {
+    size_t bytes = 0;
+    size_t values = 0;
+};
+
+// 自底向上累计子树占用；entries 非空时记录相对起点 depth 层以内的节点
+class MemoryWalker {
+public:
+    MemoryWalker(size_t depth, std::string path, std::vector<JsonParam::MemoryEntry>* entries)
+        : depth_(depth), path_(std::move(path)), entries_(entries) {}
+
+    // value 在其槽位之外的占用
+    Usage walk(const rapidjson::Value& value, size_t level) {
+        Usage usage;
+        usage.values = 1;
+        bool record = entries_ && level < depth_;
+        if (value.IsString()) {
+            usage.bytes = stringBytes(value);
+        } else if (value.IsArray()) {
+            usage.bytes = static_cast<size_t>(value.Capacity()) * sizeof(rapidjson::Value);
+            for (rapidjson::SizeType i = 0; i < value.Size(); ++i) {
+                size_t mark = path_.size();
+                if (record) {
+                    path_ += '/';
+                    path_ += std::to_string(i);
+                }
+                Usage child = walk(value[i], level + 1);
+                if (record) {
+                    add(child.bytes + sizeof(rapidjson::Value), child.values);
+                    path_.resize(mark);
+                }
+                usage.bytes += child.bytes;
+                usage.values += child.values;
+            }
+        } else if (value.IsObject()) {
+            usage.bytes = static_cast<size_t>(value.MemberCount()) * sizeof(rapidjson::Value::Member);
+            for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+                size_t mark = path_.size();
+                if (record) {
+                    appendToken(path_, std::string_view(it->name.GetString(), it->name.GetStringLength()));
+                }
+                size_t key = stringBytes(it->name);
+                Usage child = walk(it->value, level + 1);
+                if (record) {
+                    add(child.bytes + key + sizeof(rapidjson::Value::Member), child.values);
+                    path_.resize(mark);
+                }
+                usage.bytes += key + child.bytes;
+                usage.values += child.values;
+            }
+        }
+        return usage;
+    }
+
+    // 起点自身的条目
+    void addRoot(const Usage& usage) {
+        add(usage.bytes + sizeof(rapidjson::Value), usage.values);
+    }
+
+private:
+    void add(size_t bytes, size_t values) {
+        JsonParam::MemoryEntry entry;
+        entry.path = path_;
+        entry.bytes = bytes;
+        entry.values = values;
+        entries_->push_back(std::move(entry));
+    }
+
+    size_t depth_;
+    std::string path_;
+    std::vector<JsonParam::MemoryEntry>* entries_;
+};
+
+} // namespace
+
+JsonParam::MemoryUsage JsonParam::memoryUsage() const {
+    MemoryUsage usage;
+    if (!isValid()) {
+        return usage;
+    }
+    const auto& allocator = doc_->GetAllocator();
+    usage.capacity = allocator.Capacity();
+    usage.used = allocator.Size();
+    usage.live = MemoryWalker(0, std::string(), nullptr).walk(*doc_, 0).bytes;
+    usage.anchors = anchors_.size();
+    if (anchors_.empty()) {
+        usage.wasted = usage.used > usage.live ? usage.used - usage.live : 0;
+    }
+    return usage;
+}
+
+std::vector<JsonParam::MemoryEntry> JsonParam::memoryBreakdown(size_t depth, const JsonPathView& path) const {
+    std::vector<MemoryEntry> entries;
+    const rapidjson::Value* start = getValueByPath(path);
+    if (!start) {
+        return entries;
+    }
+
+    std::string pointer;
+    for (const auto& element : path) {
+        std::string_view key;
+        size_t index = 0;
+        if (JsonPathView::keyOf(element, true, key, index)) {
+            appendToken(pointer, key);
+        } else {
+            pointer += '/';
+            pointer += std::to_string(index);
+        }
+    }
+
+    MemoryWalker walker(depth, std::move(pointer), &entries);
+    walker.addRoot(walker.walk(*start, 0));
+    std::sort(entries.begin(), entries.end(), [](const MemoryEntry& a, const MemoryEntry& b) {
+        return a.bytes != b.bytes ? a.bytes > b.bytes : a.path < b.path;
+    });
+    return entries;
+}
+
+} // namespace json
+} // namespace cpputil
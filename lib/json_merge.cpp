@@ -0,0 +1,293 @@
+#include "json.h"
+#include "json_stats_recorder.h"
+#include <rapidjson/document.h>
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace cpputil {
+namespace json {
+
+namespace {
+
+// 同一个键在各来源中的值，按来源顺序排列
+struct KeyLayers {
+    const rapidjson::Value* name;
+    std::vector<const rapidjson::Value*> values;
+};
+
+// 与 deepMerge 一致：两侧同为对象或同为数组时合并，否则后者覆盖前者
+inline bool mergesWith(const rapidjson::Value& acc, const rapidjson::Value& layer) {
+    return (acc.IsObject() && layer.IsObject()) || (acc.IsArray() && layer.IsArray());
+}
+
+// 依次合并时，每一层之后的结果与该层同类型，因此第 i 层是否覆盖只取决于第 i-1 层。
+// 返回最后一个覆盖前值的层，没有时返回 count；base 为空视为缺失，第一层必然覆盖
+size_t lastOverwrite(const rapidjson::Value* base, const rapidjson::Value* const* layers, size_t count) {
+    size_t last = count;
+    const rapidjson::Value* prev = base;
+    for (size_t i = 0; i < count; ++i) {
+        if (!prev || !mergesWith(*prev, *layers[i])) {
+            last = i;
+        }
+        prev = layers[i];
+    }
+    return last;
+}
+
+// 按首次出现的顺序收集各对象层的键，slots 为 key -> keys 中的下标
+void collectKeys(const rapidjson::Value* const* layers, size_t count, std::vector<KeyLayers>& keys,
+                 std::unordered_map<std::string_view, size_t>& slots) {
+    for (size_t i = 0; i < count; ++i) {
+        for (auto it = layers[i]->MemberBegin(); it != layers[i]->MemberEnd(); ++it) {
+            std::string_view key(it->name.GetString(), it->name.GetStringLength());
+            auto slot = slots.emplace(key, keys.size());
+            if (slot.second) {
+                keys.push_back(KeyLayers{&it->name, {}});
+            }
+            keys[slot.first->second].values.push_back(&it->value);
+        }
+    }
+}
+
+size_t resolveThreads(size_t threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    return std::max<size_t>(threads, 1);
+}
+
+} // namespace
+
+bool JsonParam::mergeAll(const std::vector<const JsonParam*>& sources, size_t threads) {
+    stats::OpTimer timer(JsonOp::kUpdate);
+    // 自身出现在来源中时先取一份写时复制的快照，合并过程中它保持不变
+    std::optional<JsonParam> self;
+    std::vector<const rapidjson::Value*> layers;
+    bool all_valid = true;
+    for (const JsonParam* source : sources) {
+        if (!source || !source->isValid()) {
+            all_valid = false;
+            continue;
+        }
+        if (source == this) {
+            if (!self) {
+                self.emplace(*this);
+            }
+            source = &*self;
+        }
+        layers.push_back(source->doc_.get());
+    }
+    timer.fail(!all_valid);
+    if (layers.empty()) {
+        return all_valid;
+    }
+
+    ++generation_;
+    if (!isValid()) {
+        doc_ = std::make_shared<rapidjson::Document>();
+    }
+
+    threads = resolveThreads(threads);
+    bool parallel = threads > 1 && doc_->IsObject() &&
+                    lastOverwrite(doc_.get(), layers.data(), layers.size()) == layers.size();
+    if (!parallel) {
+        mergeLayers(*doc_, layers.data(), layers.size());
+    } else {
+        // 顶层成员互不相交：每个线程用自己的分配器构建若干成员的合并结果，
+        // 目标中未被覆盖的子树按位共享，最后在调用线程上挂回根对象。
+        // 线程的分配器随文档保留，下次并行合并时复用，anchors_ 不随调用次数增长
+        std::vector<KeyLayers> keys;
+        std::unordered_map<std::string_view, size_t> slots;
+        collectKeys(layers.data(), layers.size(), keys, slots);
+
+        unshare(*doc_);
+        std::vector<rapidjson::Value*> targets(keys.size(), nullptr);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            std::string_view key(keys[i].name->GetString(), keys[i].name->GetStringLength());
+            auto member = findMember(*doc_, key);
+            if (member != doc_->MemberEnd()) {
+                targets[i] = &member->value;
+            }
+        }
+
+        size_t workers = std::min(threads, keys.size());
+        while (merge_allocators_.size() < workers) {
+            merge_allocators_.push_back(std::make_shared<rapidjson::Document::AllocatorType>());
+            anchors_.push_back(merge_allocators_.back());
+        }
+        std::vector<rapidjson::Value> results(keys.size());
+        std::atomic<size_t> next(0);
+        auto worker = [&](size_t w) {
+            auto& allocator = *merge_allocators_[w];
+            for (size_t i = next.fetch_add(1); i < keys.size(); i = next.fetch_add(1)) {
+                const KeyLayers& entry = keys[i];
+                buildMerged(targets[i], true, entry.values.data(), entry.values.size(), results[i], allocator);
+            }
+        };
+        std::vector<std::thread> pool;
+        pool.reserve(workers > 0 ? workers - 1 : 0);
+        for (size_t w = 1; w < workers; ++w) {
+            pool.emplace_back(worker, w);
+        }
+        if (workers > 0) {
+            worker(0);
+        }
+        for (auto& thread : pool) {
+            thread.join();
+        }
+
+        // 先替换已有成员（指针仍然有效），再追加新成员
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (targets[i]) {
+                dropMemberIndex(*targets[i]);
+                *targets[i] = results[i];
+            }
+        }
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (!targets[i]) {
+                rapidjson::Value name(keys[i].name->GetString(), keys[i].name->GetStringLength(), doc_->GetAllocator());
+                appendMember(*doc_, name, results[i]);
+            }
+        }
+        markOwned(*doc_);
+    }
+
+    // 复制时常量字符串仍指向来源的缓冲区
+    for (const JsonParam* source : sources) {
+        if (source && source->isValid() && source != this) {
+            adoptAnchors(*source);
+        }
+    }
+    return all_valid;
+}
+
+void JsonParam::mergeLayers(rapidjson::Value& target, const rapidjson::Value* const* layers, size_t count) {
+    size_t last = lastOverwrite(&target, layers, count);
+    if (last < count) {
+        // target 被整体覆盖，从覆盖它的那一层起构建
+        rapidjson::Value merged;
+        buildMerged(nullptr, false, layers + last, count - last, merged, doc_->GetAllocator());
+        dropMemberIndex(target);
+        target = merged;
+        return;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    auto& allocator = doc_->GetAllocator();
+    unshare(target);
+    if (target.IsArray()) {
+        rapidjson::SizeType total = target.Size();
+        for (size_t i = 0; i < count; ++i) {
+            total += layers[i]->Size();
+        }
+        target.Reserve(total, allocator);
+        for (size_t i = 0; i < count; ++i) {
+            for (auto it = layers[i]->Begin(); it != layers[i]->End(); ++it) {
+                rapidjson::Value element(*it, allocator);
+                target.PushBack(element, allocator);
+            }
+        }
+    } else {
+        std::vector<KeyLayers> keys;
+        std::unordered_map<std::string_view, size_t> slots;
+        collectKeys(layers, count, keys, slots);
+        for (const auto& entry : keys) {
+            std::string_view key(entry.name->GetString(), entry.name->GetStringLength());
+            auto member = findMember(target, key);
+            if (member != target.MemberEnd()) {
+                mergeLayers(member->value, entry.values.data(), entry.values.size());
+            } else {
+                rapidjson::Value name(key.data(), static_cast<rapidjson::SizeType>(key.size()), allocator);
+                rapidjson::Value value;
+                buildMerged(nullptr, false, entry.values.data(), entry.values.size(), value, allocator);
+                appendMember(target, name, value);
+            }
+        }
+    }
+    markOwned(target);
+}
+
+void JsonParam::buildMerged(const rapidjson::Value* base, bool share_base, const rapidjson::Value* const* layers,
+                            size_t count, rapidjson::Value& out, rapidjson::Document::AllocatorType& allocator) {
+    size_t last = lastOverwrite(base, layers, count);
+    if (last < count) {
+        base = layers[last];
+        share_base = false;
+        layers += last + 1;
+        count -= last + 1;
+    }
+    if (!base) {
+        out.SetNull();
+        return;
+    }
+    auto place = [&](const rapidjson::Value& src, rapidjson::Value& dst) {
+        if (share_base) {
+            shallowCopy(src, dst);
+        } else {
+            dst.CopyFrom(src, allocator);
+        }
+    };
+    if (count == 0) {
+        place(*base, out);
+        return;
+    }
+
+    if (base->IsArray()) {
+        rapidjson::SizeType total = base->Size();
+        for (size_t i = 0; i < count; ++i) {
+            total += layers[i]->Size();
+        }
+        out.SetArray();
+        out.Reserve(total, allocator);
+        for (auto it = base->Begin(); it != base->End(); ++it) {
+            rapidjson::Value element;
+            place(*it, element);
+            out.PushBack(element, allocator);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            for (auto it = layers[i]->Begin(); it != layers[i]->End(); ++it) {
+                rapidjson::Value element(*it, allocator);
+                out.PushBack(element, allocator);
+            }
+        }
+        return;
+    }
+
+    std::vector<KeyLayers> keys;
+    std::unordered_map<std::string_view, size_t> slots;
+    collectKeys(layers, count, keys, slots);
+    std::vector<bool> merged(keys.size(), false);
+    out.SetObject();
+    for (auto it = base->MemberBegin(); it != base->MemberEnd(); ++it) {
+        rapidjson::Value name;
+        rapidjson::Value value;
+        place(it->name, name);
+        auto slot = slots.find(std::string_view(it->name.GetString(), it->name.GetStringLength()));
+        if (slot == slots.end()) {
+            place(it->value, value);
+        } else {
+            const KeyLayers& entry = keys[slot->second];
+            merged[slot->second] = true;
+            buildMerged(&it->value, share_base, entry.values.data(), entry.values.size(), value, allocator);
+        }
+        out.AddMember(name, value, allocator);
+    }
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (!merged[i]) {
+            rapidjson::Value name(*keys[i].name, allocator);
+            rapidjson::Value value;
+            buildMerged(nullptr, false, keys[i].values.data(), keys[i].values.size(), value, allocator);
+            out.AddMember(name, value, allocator);
+        }
+    }
+}
+
+} // namespace json
+} // namespace cpputil
@@ -0,0 +1,573 @@
+#include "json.h"
+#include "json_member_index.h"
+#include <rapidjson/document.h>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cpputil {
+namespace json {
+
+namespace {
+
+// 解析 JSON Pointer（RFC 6901），"" 表示根；每段中的 "~1" 还原为 '/'，"~0" 还原为 '~'
+bool parsePointer(std::string_view pointer, std::vector<std::string>& tokens) {
+    tokens.clear();
+    if (pointer.empty()) {
+        return true;
+    }
+    if (pointer.front() != '/') {
+        return false;
+    }
+    size_t pos = 1;
+    while (true) {
+        size_t end = pointer.find('/', pos);
+        std::string_view raw = pointer.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos);
+        std::string token;
+        token.reserve(raw.size());
+        for (size_t i = 0; i < raw.size(); ++i) {
+            if (raw[i] != '~') {
+                token += raw[i];
+            } else if (i + 1 < raw.size() && (raw[i + 1] == '0' || raw[i + 1] == '1')) {
+                token += raw[++i] == '0' ? '~' : '/';
+            } else {
+                return false;
+            }
+        }
+        tokens.push_back(std::move(token));
+        if (end == std::string_view::npos) {
+            return true;
+        }
+        pos = end + 1;
+    }
+}
+
+// 解析数组下标：十进制且无前导零；allow_end 时 "-" 表示末尾之后的位置。
+// 下标可以等于 size 当且仅当 allow_end
+bool parseIndex(const std::string& token, size_t size, bool allow_end, size_t& index) {
+    if (token == "-") {
+        index = size;
+        return allow_end;
+    }
+    if (token.empty() || token.size() > 10 || (token.size() > 1 && token[0] == '0')) {
+        return false;
+    }
+    index = 0;
+    for (char c : token) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        index = index * 10 + static_cast<size_t>(c - '0');
+    }
+    return allow_end ? index <= size : index < size;
+}
+
+// 读取操作对象中的字符串成员
+bool stringMember(const rapidjson::Value& op, const char* name, std::string_view& out) {
+    auto it = op.FindMember(name);
+    if (it == op.MemberEnd() || !it->value.IsString()) {
+        return false;
+    }
+    out = std::string_view(it->value.GetString(), it->value.GetStringLength());
+    return true;
+}
+
+// 容器子节点所在的存储，空容器可能为空指针
+inline const void* storageOf(const rapidjson::Value& value) {
+    if (value.IsObject()) {
+        return value.MemberBegin().operator->();
+    }
+    return value.IsArray() ? value.Begin() : nullptr;
+}
+
+} // namespace
+
+bool JsonParam::applyPatch(const JsonParam& patch) {
+    if (&patch == this) {
+        return applyPatch(JsonParam(patch));
+    }
+    if (!patch.isValid()) {
+        return false;
+    }
+    if (!applyPatchOps(*patch.doc_, false)) {
+        return false;
+    }
+    // 深拷贝时常量字符串仍指向 patch 的缓冲区
+    adoptAnchors(patch);
+    return true;
+}
+
+bool JsonParam::applyPatch(JsonParam&& patch) {
+    if (&patch == this) {
+        return applyPatch(JsonParam(patch));
+    }
+    if (!isValid() || !patch.isValid() || !patch.doc_->IsArray()) {
+        return false;
+    }
+    if (patch.share_epoch_.load(std::memory_order_relaxed) != 0) {
+        // patch 的存储还被它的克隆引用，移入后原地修改会波及克隆，按常量版本复制
+        return applyPatch(static_cast<const JsonParam&>(patch));
+    }
+    // 按位移入只复制值的头部，随后对移入子树的修改失败时都会撤销，
+    // patch 的存储保持原样；全部成功后才接管 patch 的文档，失败时 patch 仍然有效
+    if (!applyPatchOps(*patch.doc_, true)) {
+        return false;
+    }
+    adoptDocument(patch);
+    return true;
+}
+
+bool JsonParam::applyPatch(std::string_view patch) {
+    // 格式错误只体现为返回 false，不输出解析错误
+    return applyPatch(JsonParam::parse(patch).value());
+}
+
+// 撤销记录。patch 的修改都原地进行，每次修改前只记下复原所需的信息：
+// 被覆盖的值或容器原来的头部、插入或删除的位置及被删除的成员，条数与路径深度成正比。
+// 被覆盖、删除的值仍留在分配器中，倒序回放即可恢复原样；容器的头部复原后，
+// 追加扩容或写时复制之前的旧存储重新生效。
+// 被丢弃的值的成员索引在 commit 时才释放，回滚后原有的表仍然可用
+class JsonParam::PatchUndo {
+public:
+    explicit PatchUndo(JsonParam& owner) : owner_(owner) {}
+
+    // 写时复制可能换掉 container 的存储，换掉时记下原来的头部
+    void unshare(rapidjson::Value& container);
+
+    // slot 即将被整体覆盖：记下旧值并把 slot 置为 null
+    void overwrite(rapidjson::Value& slot);
+
+    // 即将在 container 的 index 处插入，对象总是追加在末尾
+    void insert(rapidjson::Value& container, size_t index);
+
+    // 即将删除 container 的第 index 个成员或元素，moved 表示被删除的值会放到别处
+    void remove(rapidjson::Value& container, size_t index, bool moved);
+
+    // 全部操作成功，释放被丢弃的值的成员索引
+    void commit();
+
+    // 有操作失败，倒序撤销已做的修改
+    void rollback();
+
+private:
+    enum class Kind { kHeader, kInsert, kRemove };
+
+    struct Entry {
+        Kind kind;
+        rapidjson::Value* target;  // kHeader 为被修改的值，其余为容器
+        rapidjson::SizeType index;
+        rapidjson::Value saved;    // 修改前的头部；kRemove 为被删除的值
+        rapidjson::Value name;     // kRemove 时对象成员的名字
+        bool discarded;            // 成功后 saved 不再可达
+    };
+
+    Entry& push(Kind kind, rapidjson::Value& target, size_t index, bool discarded);
+
+    JsonParam& owner_;
+    std::vector<Entry> entries_;
+};
+
+JsonParam::PatchUndo::Entry& JsonParam::PatchUndo::push(Kind kind, rapidjson::Value& target, size_t index,
+                                                       bool discarded) {
+    entries_.emplace_back();
+    Entry& entry = entries_.back();
+    entry.kind = kind;
+    entry.target = &target;
+    entry.index = static_cast<rapidjson::SizeType>(index);
+    entry.discarded = discarded;
+    return entry;
+}
+
+void JsonParam::PatchUndo::unshare(rapidjson::Value& container) {
+    rapidjson::Value before;
+    shallowCopy(container, before);
+    owner_.unshare(container);
+    if (storageOf(container) != storageOf(before)) {
+        shallowCopy(before, push(Kind::kHeader, container, 0, false).saved);
+    }
+}
+
+void JsonParam::PatchUndo::overwrite(rapidjson::Value& slot) {
+    shallowCopy(slot, push(Kind::kHeader, slot, 0, true).saved);
+    slot.SetNull();
+}
+
+void JsonParam::PatchUndo::insert(rapidjson::Value& container, size_t index) {
+    shallowCopy(container, push(Kind::kInsert, container, index, false).saved);
+}
+
+void JsonParam::PatchUndo::remove(rapidjson::Value& container, size_t index, bool moved) {
+    Entry& entry = push(Kind::kRemove, container, index, !moved);
+    if (container.IsObject()) {
+        auto member = container.MemberBegin() + index;
+        shallowCopy(member->name, entry.name);
+        shallowCopy(member->value, entry.saved);
+    } else {
+        shallowCopy(container[entry.index], entry.saved);
+    }
+}
+
+void JsonParam::PatchUndo::commit() {
+    for (Entry& entry : entries_) {
+        if (entry.discarded) {
+            owner_.dropMemberIndex(entry.saved);
+        }
+    }
+    entries_.clear();
+}
+
+void JsonParam::PatchUndo::rollback() {
+    auto& allocator = owner_.doc_->GetAllocator();
+    JsonMemberIndex* index = owner_.member_index_.get();
+    for (auto it = entries_.rbegin(); it != entries_.rend(); ++it) {
+        rapidjson::Value& target = *it->target;
+        switch (it->kind) {
+        case Kind::kHeader:
+            if (it->discarded) {
+                // 换回被覆盖的旧值，丢弃新值的索引
+                owner_.dropMemberIndex(target);
+                shallowCopy(it->saved, target);
+            } else {
+                // 换回写时复制前的存储，索引随之迁回
+                const void* copied = storageOf(target);
+                shallowCopy(it->saved, target);
+                if (index && target.IsObject()) {
+                    index->rebase(copied, target);
+                }
+            }
+            break;
+        case Kind::kInsert:
+            if (target.IsObject()) {
+                owner_.dropMemberIndex((target.MemberEnd() - 1)->value);
+                if (index) {
+                    index->invalidate(target);
+                }
+            } else {
+                owner_.dropMemberIndex(target[it->index]);
+                if (storageOf(target) == storageOf(it->saved)) {
+                    // 没有扩容，插入时的交换发生在原存储上，先换回末尾
+                    for (rapidjson::SizeType i = it->index; i + 1 < target.Size(); ++i) {
+                        target[i].Swap(target[i + 1]);
+                    }
+                }
+            }
+            // 恢复大小；扩容过时旧存储原样未动
+            shallowCopy(it->saved, target);
+            break;
+        case Kind::kRemove:
+            // 删除不改变容量，放回时不会扩容
+            if (target.IsObject()) {
+                target.AddMember(it->name, it->saved, allocator);
+                for (auto member = target.MemberEnd() - 1; member != target.MemberBegin() + it->index; --member) {
+                    member->name.Swap((member - 1)->name);
+                    member->value.Swap((member - 1)->value);
+                }
+                if (index) {
+                    index->invalidate(target);
+                }
+            } else {
+                target.PushBack(it->saved, allocator);
+                for (rapidjson::SizeType i = target.Size() - 1; i > it->index; --i) {
+                    target[i].Swap(target[i - 1]);
+                }
+            }
+            break;
+        }
+    }
+    entries_.clear();
+}
+
+bool JsonParam::applyPatchOps(const rapidjson::Value& ops, bool steal) {
+    if (!isValid() || !ops.IsArray()) {
+        return false;
+    }
+    ++generation_;
+
+    PatchUndo undo(*this);
+    bool ok = true;
+    for (auto it = ops.Begin(); ok && it != ops.End(); ++it) {
+        ok = applyPatchOp(*it, steal, undo);
+    }
+    if (ok) {
+        undo.commit();
+    } else {
+        undo.rollback();
+    }
+    return ok;
+}
+
+bool JsonParam::applyPatchOp(const rapidjson::Value& op, bool steal, PatchUndo& undo) {
+    std::string_view name;
+    std::string_view path;
+    std::vector<std::string> tokens;
+    if (!op.IsObject() || !stringMember(op, "op", name) || !stringMember(op, "path", path) ||
+        !parsePointer(path, tokens)) {
+        return false;
+    }
+
+    auto value_it = op.FindMember("value");
+    const rapidjson::Value* value = value_it == op.MemberEnd() ? nullptr : &value_it->value;
+
+    if (name == "add") {
+        if (!value) {
+            return false;
+        }
+        rapidjson::Value moved;
+        transferValue(*value, moved, steal);
+        return addAt(tokens, moved, undo);
+    }
+    if (name == "replace") {
+        rapidjson::Value* target = value ? resolvePointer(tokens, tokens.size(), undo) : nullptr;
+        if (!target) {
+            return false;
+        }
+        undo.overwrite(*target);
+        transferValue(*value, *target, steal);
+        return true;
+    }
+    if (name == "remove") {
+        return removeAt(tokens, nullptr, undo);
+    }
+    if (name == "test") {
+        const rapidjson::Value* target = resolvePointer(tokens);
+        return value && target && *target == *value;
+    }
+
+    std::string_view from_path;
+    std::vector<std::string> from;
+    if (!stringMember(op, "from", from_path) || !parsePointer(from_path, from)) {
+        return false;
+    }
+    if (name == "copy") {
+        const rapidjson::Value* source = resolvePointer(from);
+        if (!source) {
+            return false;
+        }
+        rapidjson::Value copied(*source, doc_->GetAllocator());
+        return addAt(tokens, copied, undo);
+    }
+    if (name == "move") {
+        if (from == tokens) {
+            return resolvePointer(from) != nullptr;
+        }
+        // 不能移动到自己的子孙节点下
+        if (from.size() < tokens.size() && std::equal(from.begin(), from.end(), tokens.begin())) {
+            return false;
+        }
+        rapidjson::Value moved;
+        return removeAt(from, &moved, undo) && addAt(tokens, moved, undo);
+    }
+    return false;
+}
+
+rapidjson::Value* JsonParam::resolvePointer(const std::vector<std::string>& tokens, size_t count, PatchUndo& undo) {
+    rapidjson::Value* current = doc_.get();
+    for (size_t i = 0; i < count; ++i) {
+        if (current->IsObject()) {
+            undo.unshare(*current);
+            auto member = findMember(*current, tokens[i]);
+            if (member == current->MemberEnd()) {
+                return nullptr;
+            }
+            current = &member->value;
+        } else if (current->IsArray()) {
+            size_t index = 0;
+            if (!parseIndex(tokens[i], current->Size(), false, index)) {
+                return nullptr;
+            }
+            undo.unshare(*current);
+            current = &(*current)[static_cast<rapidjson::SizeType>(index)];
+        } else {
+            return nullptr;
+        }
+    }
+    return current;
+}
+
+const rapidjson::Value* JsonParam::resolvePointer(const std::vector<std::string>& tokens) const {
+    const rapidjson::Value* current = doc_.get();
+    for (const auto& token : tokens) {
+        if (current->IsObject()) {
+            auto member = findMember(*current, token);
+            if (member == current->MemberEnd()) {
+                return nullptr;
+            }
+            current = &member->value;
+        } else if (current->IsArray()) {
+            size_t index = 0;
+            if (!parseIndex(token, current->Size(), false, index)) {
+                return nullptr;
+            }
+            current = &(*current)[static_cast<rapidjson::SizeType>(index)];
+        } else {
+            return nullptr;
+        }
+    }
+    return current;
+}
+
+// value 已属于当前文档，移入后被置为 null
+bool JsonParam::addAt(const std::vector<std::string>& tokens, rapidjson::Value& value, PatchUndo& undo) {
+    if (tokens.empty()) {
+        undo.overwrite(*doc_);
+        static_cast<rapidjson::Value&>(*doc_) = value;
+        return true;
+    }
+    rapidjson::Value* parent = resolvePointer(tokens, tokens.size() - 1, undo);
+    if (!parent) {
+        return false;
+    }
+    const std::string& last = tokens.back();
+    if (parent->IsObject()) {
+        undo.unshare(*parent);
+        auto member = findMember(*parent, last);
+        if (member != parent->MemberEnd()) {
+            undo.overwrite(member->value);
+            member->value = value;
+        } else {
+            rapidjson::Value name(last.c_str(), static_cast<rapidjson::SizeType>(last.size()), doc_->GetAllocator());
+            undo.insert(*parent, parent->MemberCount());
+            appendMember(*parent, name, value);
+            markOwned(*parent);
+        }
+        return true;
+    }
+    if (parent->IsArray()) {
+        size_t index = 0;
+        if (!parseIndex(last, parent->Size(), true, index)) {
+            return false;
+        }
+        undo.unshare(*parent);
+        undo.insert(*parent, index);
+        parent->PushBack(value, doc_->GetAllocator());
+        // RapidJSON 没有插入接口，追加后逐个交换到目标位置
+        for (size_t i = parent->Size() - 1; i > index; --i) {
+            (*parent)[static_cast<rapidjson::SizeType>(i)].Swap((*parent)[static_cast<rapidjson::SizeType>(i - 1)]);
+        }
+        markOwned(*parent);
+        return true;
+    }
+    return false;
+}
+
+// removed 非空时接收被删除的值，不复制
+bool JsonParam::removeAt(const std::vector<std::string>& tokens, rapidjson::Value* removed, PatchUndo& undo) {
+    if (tokens.empty()) {
+        return false;
+    }
+    rapidjson::Value* parent = resolvePointer(tokens, tokens.size() - 1, undo);
+    if (!parent) {
+        return false;
+    }
+    const std::string& last = tokens.back();
+    if (parent->IsObject()) {
+        undo.unshare(*parent);
+        auto member = findMember(*parent, last);
+        if (member == parent->MemberEnd()) {
+            return false;
+        }
+        undo.remove(*parent, static_cast<size_t>(member - parent->MemberBegin()), removed != nullptr);
+        if (removed) {
+            *removed = member->value;
+        }
+        // 保持其余成员的顺序，索引随之失效。表以成员数组地址为键，删空后地址取不到，
+        // 因此在删除前丢弃；容量不变，之后追加的成员会复用同一块存储
+        if (member_index_) {
+            member_index_->invalidate(*parent);
+        }
+        parent->EraseMember(member);
+        return true;
+    }
+    if (parent->IsArray()) {
+        size_t index = 0;
+        if (!parseIndex(last, parent->Size(), false, index)) {
+            return false;
+        }
+        undo.unshare(*parent);
+        undo.remove(*parent, index, removed != nullptr);
+        if (removed) {
+            *removed = (*parent)[static_cast<rapidjson::SizeType>(index)];
+        }
+        parent->Erase(parent->Begin() + index);
+        return true;
+    }
+    return false;
+}
+
+bool JsonParam::applyMergePatch(const JsonParam& patch) {
+    if (&patch == this) {
+        return applyMergePatch(JsonParam(patch));
+    }
+    if (!patch.isValid()) {
+        return false;
+    }
+    if (!isValid()) {
+        doc_ = std::make_shared<rapidjson::Document>();
+    }
+    ++generation_;
+    mergePatch(*doc_, *patch.doc_, false);
+    adoptAnchors(patch);
+    return true;
+}
+
+bool JsonParam::applyMergePatch(JsonParam&& patch) {
+    if (&patch == this) {
+        return applyMergePatch(JsonParam(patch));
+    }
+    if (!patch.isValid()) {
+        return false;
+    }
+    if (!isValid()) {
+        doc_ = std::make_shared<rapidjson::Document>();
+    }
+    ++generation_;
+    std::shared_ptr<rapidjson::Document> source = patch.doc_;
+    adoptDocument(patch);
+    mergePatch(*doc_, *source, true);
+    return true;
+}
+
+bool JsonParam::applyMergePatch(std::string_view patch) {
+    return applyMergePatch(JsonParam::parse(patch).value());
+}
+
+void JsonParam::mergePatch(rapidjson::Value& target, const rapidjson::Value& patch, bool steal) {
+    if (!patch.IsObject()) {
+        transferValue(patch, target, steal);
+        return;
+    }
+    if (!target.IsObject()) {
+        dropMemberIndex(target);
+        target.SetObject();
+    }
+    unshare(target);
+
+    for (auto it = patch.MemberBegin(); it != patch.MemberEnd(); ++it) {
+        std::string_view key(it->name.GetString(), it->name.GetStringLength());
+        auto member = findMember(target, key);
+        if (it->value.IsNull()) {
+            if (member != target.MemberEnd()) {
+                dropMemberIndex(member->value);
+                // 删除前丢弃索引，删空后成员数组地址取不到
+                if (member_index_) {
+                    member_index_->invalidate(target);
+                }
+                target.EraseMember(member);
+            }
+        } else if (member != target.MemberEnd()) {
+            mergePatch(member->value, it->value, steal);
+        } else {
+            // 新成员同样经过合并，子对象中的 null 不会被带进来
+            rapidjson::Value name;
+            rapidjson::Value value;
+            transferValue(it->name, name, steal);
+            mergePatch(value, it->value, steal);
+            appendMember(target, name, value);
+        }
+    }
+    markOwned(target);
+}
+
+} // namespace json
+} // namespace cpputil
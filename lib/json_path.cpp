@@ -0,0 +1,155 @@
+#include "json.h"
+#include <algorithm>
+#include <string>
+#include <string_view>
+
+namespace cpputil {
+namespace json {
+
+namespace {
+
+// 十进制数组下标，不允许前导零；kWildcard 保留给通配段
+bool parseIndex(std::string_view token, size_t& index) {
+    if (token.empty() || (token.size() > 1 && token[0] == '0')) {
+        return false;
+    }
+    index = 0;
+    for (char c : token) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        size_t digit = static_cast<size_t>(c - '0');
+        if (index > (JsonPath::kWildcard - 1 - digit) / 10) {
+            return false;
+        }
+        index = index * 10 + digit;
+    }
+    return true;
+}
+
+// "/a/0/b~1c" -> {"a", NumericToken{"0", 0}, "b/c"}
+bool parsePointer(std::string_view text, JsonPath& path) {
+    size_t pos = 1;
+    while (true) {
+        size_t end = text.find('/', pos);
+        std::string_view raw = text.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos);
+        size_t index = 0;
+        if (parseIndex(raw, index)) {
+            // 保留原文，对象上按 key 查找
+            path.add(JsonPath::NumericToken{std::string(raw), index});
+        } else {
+            std::string key;
+            key.reserve(raw.size());
+            for (size_t i = 0; i < raw.size(); ++i) {
+                if (raw[i] != '~') {
+                    key += raw[i];
+                } else if (i + 1 < raw.size() && (raw[i + 1] == '0' || raw[i + 1] == '1')) {
+                    key += raw[++i] == '0' ? '~' : '/';
+                } else {
+                    return false;
+                }
+            }
+            path.add(key);
+        }
+        if (end == std::string_view::npos) {
+            return true;
+        }
+        pos = end + 1;
+    }
+}
+
+// 方括号内带引号的 key，pos 指向开引号，成功时移到闭引号之后
+bool parseQuoted(std::string_view text, size_t& pos, std::string& key) {
+    char quote = text[pos++];
+    while (pos < text.size()) {
+        char c = text[pos++];
+        if (c == quote) {
+            return true;
+        }
+        if (c == '\\') {
+            if (pos == text.size() || (text[pos] != quote && text[pos] != '\\')) {
+                return false;
+            }
+            c = text[pos++];
+        }
+        key += c;
+    }
+    return false;
+}
+
+// 方括号段，pos 指向 '['，成功时移到 ']' 之后
+bool parseBracket(std::string_view text, size_t& pos, JsonPath& path) {
+    ++pos;
+    if (pos < text.size() && (text[pos] == '"' || text[pos] == '\'')) {
+        std::string key;
+        if (!parseQuoted(text, pos, key)) {
+            return false;
+        }
+        path.add(key);
+    } else {
+        size_t close = text.find(']', pos);
+        if (close == std::string_view::npos) {
+            return false;
+        }
+        std::string_view inner = text.substr(pos, close - pos);
+        size_t index = 0;
+        if (inner == "*") {
+            path.add(JsonPath::kWildcard);
+        } else if (parseIndex(inner, index)) {
+            path.add(index);
+        } else {
+            return false;
+        }
+        pos = close;
+    }
+    if (pos >= text.size() || text[pos] != ']') {
+        return false;
+    }
+    ++pos;
+    return true;
+}
+
+// "user.scores[0]"、"items[*].price"、"a['x.y']"
+bool parseDotted(std::string_view text, JsonPath& path) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        if (text[pos] == '[') {
+            if (!parseBracket(text, pos, path)) {
+                return false;
+            }
+            continue;
+        }
+        // 除开头外，key 前面必须是点号
+        if (pos > 0) {
+            if (text[pos] != '.') {
+                return false;
+            }
+            ++pos;
+        }
+        size_t end = std::min(text.find_first_of(".[]", pos), text.size());
+        if (end == pos || (end < text.size() && text[end] == ']')) {
+            return false;
+        }
+        path.add(std::string(text.substr(pos, end - pos)));
+        pos = end;
+    }
+    return true;
+}
+
+} // namespace
+
+std::optional<JsonPath> JsonPath::parse(std::string_view text) {
+    if (text.empty()) {
+        // JSON Pointer "" 指向整个文档
+        return JsonPath::root();
+    }
+    JsonPath path;
+    bool ok = text.front() == '/' ? parsePointer(text, path) : parseDotted(text, path);
+    if (!ok) {
+        return std::nullopt;
+    }
+    return path;
+}
+
+} // namespace json
+} // namespace cpputil
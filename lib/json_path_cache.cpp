@@ -0,0 +1,78 @@
+#include "json_path_cache.h"
+#include <algorithm>
+#include <functional>
+
+namespace cpputil {
+namespace json {
+
+JsonPathCache::JsonPathCache(size_t capacity)
+    : shard_capacity_(std::max<size_t>(1, (capacity + kShards - 1) / kShards)) {}
+
+JsonPathCache::PathPtr JsonPathCache::get(std::string_view text) {
+    size_t hash = std::hash<std::string_view>()(text);
+    // 分片用高位，低位留给分片内的哈希表
+    Shard& shard = shards_[(hash >> (sizeof(size_t) * 4)) % kShards];
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.lookup.find(text);
+        if (it != shard.lookup.end()) {
+            ++shard.stats.hits;
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            return it->second->path;
+        }
+    }
+
+    // 解析在锁外进行
+    PathPtr path;
+    if (auto parsed = JsonPath::parse(text)) {
+        path = std::make_shared<const JsonPath>(std::move(*parsed));
+    }
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    ++shard.stats.misses;
+    // 其他线程可能已经插入了同一路径
+    auto it = shard.lookup.find(text);
+    if (it != shard.lookup.end()) {
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return it->second->path;
+    }
+    shard.entries.push_front(Entry{std::string(text), path});
+    shard.lookup.emplace(shard.entries.front().text, shard.entries.begin());
+    ++shard.stats.size;
+    if (shard.stats.size > shard_capacity_) {
+        shard.lookup.erase(shard.entries.back().text);
+        shard.entries.pop_back();
+        --shard.stats.size;
+        ++shard.stats.evictions;
+    }
+    return path;
+}
+
+JsonPathCache::Stats JsonPathCache::stats() const {
+    Stats total;
+    for (const Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total.hits += shard.stats.hits;
+        total.misses += shard.stats.misses;
+        total.evictions += shard.stats.evictions;
+        total.size += shard.stats.size;
+    }
+    return total;
+}
+
+void JsonPathCache::clear() {
+    for (Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.lookup.clear();
+        shard.entries.clear();
+        shard.stats.size = 0;
+    }
+}
+
+JsonPathCache& JsonPathCache::global() {
+    static JsonPathCache* instance = new JsonPathCache();
+    return *instance;
+}
+
+} // namespace json
+} // namespace cpputil
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace cpputil {
+namespace json {
+
+// 字符串路径到已解析 JsonPath 的缓存，按最近最少使用淘汰。
+// 路径来自配置或规则、在运行时反复查找时，命中缓存只需一次哈希和一次加锁，
+// 之后的 get/set 与手工构造的 JsonPath 完全相同。
+// 缓存分为若干分片，各自加锁，可以跨线程共享；也可以直接用 global()
+class JsonPathCache {
+public:
+  using PathPtr = std::shared_ptr<const JsonPath>;
+
+  struct Stats {
+    size_t hits = 0;      // 命中次数
+    size_t misses = 0;    // 未命中、需要解析的次数
+    size_t evictions = 0; // 因容量淘汰的条目数
+    size_t size = 0;      // 当前条目数
+  };
+
+  static constexpr size_t kDefaultCapacity = 4096;
+  static constexpr size_t kShards = 16;
+
+  // capacity：最多缓存的路径数，平均分到各个分片，每个分片至少一条
+  explicit JsonPathCache(size_t capacity = kDefaultCapacity);
+
+  JsonPathCache(const JsonPathCache &) = delete;
+  JsonPathCache &operator=(const JsonPathCache &) = delete;
+
+  // 按 JsonPath::parse 的语法解析 text，格式不合法时返回 nullptr。
+  // 不合法的结果同样被缓存，重复传入的坏路径不会反复解析。
+  // 返回的路径不可修改，被淘汰后持有者仍可继续使用
+  PathPtr get(std::string_view text);
+
+  // 统计信息快照
+  Stats stats() const;
+
+  // 清空所有条目，统计信息保留
+  void clear();
+
+  // 进程内共享的缓存，容量为 kDefaultCapacity，不析构
+  static JsonPathCache &global();
+
+private:
+  struct Entry {
+    std::string text;
+    PathPtr path;
+  };
+
+  // lookup 的 key 引用 entries 中的 text，list 节点不会移动
+  struct Shard {
+    mutable std::mutex mutex;
+    std::list<Entry> entries; // 最近使用的在前
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> lookup;
+    Stats stats;
+  };
+
+  const size_t shard_capacity_;
+  Shard shards_[kShards];
+};
+
+} // namespace json
+} // namespace cpputil
@@ -0,0 +1,149 @@
+#include "json.h"
+#include "json_member_index.h"
+
+namespace cpputil {
+namespace json {
+
+namespace {
+
+// 单个节点的子 key 数不少于该值且对象未被索引时，改为一次扫描全部成员
+constexpr size_t kScanMinChildren = 4;
+
+// 扫描时用位图标记已命中的子 key，保证与 FindMember 一样取第一次出现的成员
+constexpr size_t kScanMaxChildren = 64;
+
+} // namespace
+
+JsonPathPlan::JsonPathPlan(const std::vector<JsonPath>& paths) : nodes_(1), size_(paths.size()) {
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (paths[i].empty() && !paths[i].isRoot()) {
+            // 与 get 一致，空路径不选中任何值，root() 选中根
+            continue;
+        }
+        uint32_t current = 0;
+        for (const auto& element : paths[i].elements()) {
+            uint32_t child = 0;
+            bool found = false;
+            if (const std::string* key = std::get_if<std::string>(&element)) {
+                for (const auto& member : nodes_[current].members) {
+                    if (member.first == *key) {
+                        child = member.second;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) {
+                    child = static_cast<uint32_t>(nodes_.size());
+                    nodes_[current].members.emplace_back(*key, child);
+                }
+            } else if (const auto* token = std::get_if<JsonPath::NumericToken>(&element)) {
+                // 与 key、下标分开登记，不与同名 key 或同值下标共用子节点
+                for (const auto& entry : nodes_[current].tokens) {
+                    if (entry.first == *token) {
+                        child = entry.second;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) {
+                    child = static_cast<uint32_t>(nodes_.size());
+                    nodes_[current].tokens.emplace_back(*token, child);
+                }
+            } else {
+                size_t index = std::get<size_t>(element);
+                for (const auto& entry : nodes_[current].elements) {
+                    if (entry.first == index) {
+                        child = entry.second;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) {
+                    child = static_cast<uint32_t>(nodes_.size());
+                    nodes_[current].elements.emplace_back(index, child);
+                }
+            }
+            if (!found) {
+                nodes_.emplace_back();
+            }
+            current = child;
+        }
+        nodes_[current].targets.push_back(i);
+    }
+    
+    // 节点全部建好、key 的地址不再变化之后再建立查找表
+    for (auto& node : nodes_) {
+        if (node.members.size() >= kScanMinChildren && node.members.size() <= kScanMaxChildren) {
+            for (uint32_t i = 0; i < node.members.size(); ++i) {
+                node.lookup.emplace(node.members[i].first, i);
+            }
+        }
+    }
+}
+
+JsonPathResults JsonParam::extract(const JsonPathPlan& plan) const {
+    JsonPathResults results;
+    extract(plan, results);
+    return results;
+}
+
+void JsonParam::extract(const JsonPathPlan& plan, JsonPathResults& results) const {
+    results.owner_ = this;
+    results.values_.assign(plan.size(), nullptr);
+    if (isValid()) {
+        extractNode(plan, 0, *doc_, results.values_);
+    }
+}
+
+void JsonParam::extractNode(const JsonPathPlan& plan, uint32_t index, const rapidjson::Value& value,
+                            std::vector<const rapidjson::Value*>& out) const {
+    const JsonPathPlan::Node& node = plan.nodes_[index];
+    for (size_t target : node.targets) {
+        out[target] = &value;
+    }
+    
+    if (!node.members.empty() && value.IsObject()) {
+        bool indexed = member_index_ && member_index_->covers(value);
+        if (!node.lookup.empty() && !indexed) {
+            // 子 key 较多：扫描一遍成员，每个成员查一次表
+            uint64_t seen = 0;
+            for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+                auto hit = node.lookup.find(std::string_view(it->name.GetString(), it->name.GetStringLength()));
+                if (hit == node.lookup.end() || (seen & (uint64_t(1) << hit->second))) {
+                    continue;
+                }
+                seen |= uint64_t(1) << hit->second;
+                extractNode(plan, node.members[hit->second].second, it->value, out);
+            }
+        } else {
+            for (const auto& member : node.members) {
+                auto it = findMember(value, member.first);
+                if (it != value.MemberEnd()) {
+                    extractNode(plan, member.second, it->value, out);
+                }
+            }
+        }
+    }
+    
+    if (!node.elements.empty() && value.IsArray()) {
+        for (const auto& element : node.elements) {
+            if (element.first < value.Size()) {
+                extractNode(plan, element.second, value[static_cast<rapidjson::SizeType>(element.first)], out);
+            }
+        }
+    }
+
+    for (const auto& token : node.tokens) {
+        if (value.IsObject()) {
+            auto it = findMember(value, token.first.text);
+            if (it != value.MemberEnd()) {
+                extractNode(plan, token.second, it->value, out);
+            }
+        } else if (value.IsArray() && token.first.index < value.Size()) {
+            extractNode(plan, token.second, value[static_cast<rapidjson::SizeType>(token.first.index)], out);
+        }
+    }
+}
+
+} // namespace json
+} // namespace cpputil
@@ -0,0 +1,66 @@
+#include "json_pool.h"
+
+namespace cpputil {
+namespace json {
+
+void JsonParamPool::Releaser::operator()(JsonParam* param) const {
+    if (pool_) {
+        pool_->release(param);
+    } else {
+        delete param;
+    }
+}
+
+JsonParamPool::JsonParamPool(size_t max_idle, size_t max_retained_bytes)
+    : max_idle_(max_idle), max_retained_bytes_(max_retained_bytes) {}
+
+JsonParamPool::Handle JsonParamPool::acquire(std::string_view json, JsonParseError* error) {
+    std::unique_ptr<JsonParam> param;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.acquired;
+        if (!idle_.empty()) {
+            param = std::move(idle_.back());
+            idle_.pop_back();
+            ++stats_.reused;
+            --stats_.idle;
+            stats_.retained_bytes -= param->retainedBytes();
+        }
+    }
+    if (!param) {
+        param = std::make_unique<JsonParam>();
+    }
+    // 解析在锁外进行
+    JsonParseError result = param->reset(json);
+    if (error) {
+        *error = result;
+    }
+    return Handle(param.release(), Releaser(this));
+}
+
+void JsonParamPool::release(JsonParam* param) {
+    std::unique_ptr<JsonParam> owned(param);
+    size_t retained = owned->retainedBytes();
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.released;
+    if (idle_.size() >= max_idle_ || retained > max_retained_bytes_) {
+        ++stats_.dropped;
+        return;
+    }
+    idle_.push_back(std::move(owned));
+    ++stats_.idle;
+    stats_.retained_bytes += retained;
+}
+
+JsonParamPool::Stats JsonParamPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+JsonParamPool& JsonParamPool::local() {
+    thread_local JsonParamPool pool;
+    return pool;
+}
+
+} // namespace json
+} // namespace cpputil
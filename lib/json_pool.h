@@ -0,0 +1,73 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace cpputil {
+namespace json {
+
+// JsonParam 对象池：归还的对象保留 reset 建立的内存区，再次取出时原地重新解析，
+// 省去 Document、分配器内存块的反复申请和释放。池内有互斥锁，可以跨线程共享；
+// 也可以用 local() 取得当前线程独占的池，锁不会发生竞争
+class JsonParamPool {
+public:
+  struct Stats {
+    size_t acquired = 0;       // acquire 次数
+    size_t reused = 0;         // 其中取到池内对象的次数
+    size_t released = 0;       // 归还次数
+    size_t dropped = 0;        // 因池满或内存区过大而直接释放的次数
+    size_t idle = 0;           // 当前池内对象数
+    size_t retained_bytes = 0; // 池内对象保留的内存字节数
+  };
+
+  // Handle 析构时把对象还给池
+  class Releaser {
+  public:
+    explicit Releaser(JsonParamPool *pool = nullptr) : pool_(pool) {}
+    void operator()(JsonParam *param) const;
+
+  private:
+    JsonParamPool *pool_;
+  };
+
+  using Handle = std::unique_ptr<JsonParam, Releaser>;
+
+  static constexpr size_t kDefaultMaxIdle = 64;
+  static constexpr size_t kDefaultMaxRetainedBytes = 1 << 20;
+
+  // max_idle：池内最多保留的对象数；
+  // max_retained_bytes：单个对象保留的内存超过该值时归还即释放，防止偶发的大文档长期占用内存
+  explicit JsonParamPool(size_t max_idle = kDefaultMaxIdle,
+                         size_t max_retained_bytes = kDefaultMaxRetainedBytes);
+
+  JsonParamPool(const JsonParamPool &) = delete;
+  JsonParamPool &operator=(const JsonParamPool &) = delete;
+
+  // 取出一个对象并解析 json。解析失败时对象无效，同样随 Handle 归还；
+  // 不做任何输出，error 非空时写入解析错误。池必须比取出的 Handle 活得久
+  Handle acquire(std::string_view json, JsonParseError *error = nullptr);
+
+  // 统计信息快照
+  Stats stats() const;
+
+  // 当前线程独占的池，线程退出时销毁，从中取出的 Handle 须在此之前释放
+  static JsonParamPool &local();
+
+private:
+  void release(JsonParam *param);
+
+  const size_t max_idle_;
+  const size_t max_retained_bytes_;
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<JsonParam>> idle_;
+  Stats stats_;
+};
+
+} // namespace json
+} // namespace cpputil
@@ -0,0 +1,217 @@
+#include "json.h"
+#include <rapidjson/memorystream.h>
+#include <rapidjson/reader.h>
+
+namespace cpputil {
+namespace json {
+
+namespace {
+
+// 值在投影中的去向
+enum class Mode {
+    kSkip,     // 不在任何路径上，扫描后丢弃
+    kPath,     // 位于某条路径的中途，只保留命中的子节点
+    kCapture,  // 某条路径在此终止，完整保留
+};
+
+// 正在构建的容器
+struct Frame {
+    Mode mode = Mode::kPath;
+    bool is_array = false;
+    size_t depth = 0;               // kPath：已匹配的路径段数
+    size_t slot = 0;                // 本容器在父数组中的下标
+    size_t next_index = 0;          // 数组：下一个元素的下标
+    std::vector<uint32_t> states;   // kPath：匹配到本容器的路径
+    std::string key;                // 对象：当前成员的 key
+    rapidjson::Value value;
+};
+
+// 投影解析的 SAX handler。跳过的子树只计深度，不分配任何节点
+class ProjectionHandler
+    : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, ProjectionHandler> {
+public:
+    ProjectionHandler(const std::vector<JsonPathView>& paths,
+                      rapidjson::Document::AllocatorType& allocator)
+        : paths_(paths), allocator_(allocator) {}
+
+    bool Null() { return scalar(rapidjson::Value()); }
+    bool Bool(bool b) { return scalar(rapidjson::Value(b)); }
+    bool Int(int i) { return scalar(rapidjson::Value(i)); }
+    bool Uint(unsigned u) { return scalar(rapidjson::Value(u)); }
+    bool Int64(int64_t i) { return scalar(rapidjson::Value(i)); }
+    bool Uint64(uint64_t u) { return scalar(rapidjson::Value(u)); }
+    bool Double(double d) { return scalar(rapidjson::Value(d)); }
+
+    bool String(const char* str, rapidjson::SizeType length, bool) {
+        size_t slot = 0;
+        if (next(slot) == Mode::kCapture) {
+            rapidjson::Value value(str, length, allocator_);
+            attach(value, slot);
+        }
+        return true;
+    }
+
+    bool Key(const char* str, rapidjson::SizeType length, bool) {
+        if (skip_depth_ == 0) {
+            frames_.back().key.assign(str, length);
+        }
+        return true;
+    }
+
+    bool StartObject() { return start(false); }
+    bool EndObject(rapidjson::SizeType) { return end(); }
+    bool StartArray() { return start(true); }
+    bool EndArray(rapidjson::SizeType) { return end(); }
+
+    rapidjson::Value& root() { return root_; }
+
+private:
+    bool scalar(rapidjson::Value&& value) {
+        size_t slot = 0;
+        if (next(slot) == Mode::kCapture) {
+            attach(value, slot);
+        }
+        return true;
+    }
+
+    bool start(bool is_array) {
+        size_t slot = 0;
+        Mode mode = next(slot);
+        if (mode == Mode::kSkip) {
+            ++skip_depth_;
+            return true;
+        }
+        Frame frame;
+        frame.mode = mode;
+        frame.is_array = is_array;
+        frame.depth = frames_.empty() ? 0 : frames_.back().depth + 1;
+        frame.slot = slot;
+        frame.states.swap(child_states_);
+        if (is_array) {
+            frame.value.SetArray();
+        } else {
+            frame.value.SetObject();
+        }
+        frames_.push_back(std::move(frame));
+        return true;
+    }
+
+    bool end() {
+        if (skip_depth_ > 0) {
+            --skip_depth_;
+            return true;
+        }
+        Frame frame = std::move(frames_.back());
+        frames_.pop_back();
+        // 路径中途的容器没有命中任何子节点时丢弃，根节点始终保留
+        bool keep = frame.mode == Mode::kCapture || frames_.empty() ||
+                    (frame.is_array ? !frame.value.Empty() : !frame.value.ObjectEmpty());
+        if (keep) {
+            attach(frame.value, frame.slot);
+        }
+        return true;
+    }
+
+    // 决定下一个值的去向。slot 返回值在父数组中的下标；
+    // 结果为 kPath 时，匹配到该值的路径留在 child_states_ 中
+    Mode next(size_t& slot) {
+        if (skip_depth_ > 0) {
+            return Mode::kSkip;
+        }
+        child_states_.clear();
+        if (frames_.empty()) {
+            // 与 get/has 一致：只有 JsonPath::root() 选中整个文档，其他空路径什么也不选
+            for (size_t i = 0; i < paths_.size(); ++i) {
+                if (paths_[i].isRoot()) {
+                    return Mode::kCapture;
+                }
+                if (!paths_[i].empty()) {
+                    child_states_.push_back(static_cast<uint32_t>(i));
+                }
+            }
+            // 根容器总是保留，没有路径命中时结果是同类型的空容器
+            return Mode::kPath;
+        }
+
+        Frame& parent = frames_.back();
+        if (parent.is_array) {
+            slot = parent.next_index++;
+        }
+        if (parent.mode == Mode::kCapture) {
+            return Mode::kCapture;
+        }
+        for (uint32_t state : parent.states) {
+            const JsonPathView& path = paths_[state];
+            const auto& element = path[parent.depth];
+            std::string_view key;
+            size_t index = 0;
+            bool matched;
+            if (JsonPathView::keyOf(element, !parent.is_array, key, index)) {
+                matched = !parent.is_array && key == parent.key;
+            } else {
+                matched = index == JsonPath::kWildcard || (parent.is_array && index == slot);
+            }
+            if (!matched) {
+                continue;
+            }
+            if (path.size() == parent.depth + 1) {
+                return Mode::kCapture;
+            }
+            child_states_.push_back(state);
+        }
+        return child_states_.empty() ? Mode::kSkip : Mode::kPath;
+    }
+
+    // 把构建好的值挂到父容器上；数组中缺失的前序元素以 null 占位
+    void attach(rapidjson::Value& value, size_t slot) {
+        if (frames_.empty()) {
+            root_ = value;
+            return;
+        }
+        Frame& parent = frames_.back();
+        if (parent.is_array) {
+            while (parent.value.Size() < slot) {
+                parent.value.PushBack(rapidjson::Value(), allocator_);
+            }
+            parent.value.PushBack(value, allocator_);
+        } else {
+            rapidjson::Value name(parent.key.data(), static_cast<rapidjson::SizeType>(parent.key.size()),
+                                  allocator_);
+            parent.value.AddMember(name, value, allocator_);
+        }
+    }
+
+    const std::vector<JsonPathView>& paths_;
+    rapidjson::Document::AllocatorType& allocator_;
+    std::vector<Frame> frames_;
+    std::vector<uint32_t> child_states_;
+    size_t skip_depth_ = 0;
+    rapidjson::Value root_;
+};
+
+}  // namespace
+
+JsonParam JsonParam::parseProjected(std::string_view json, const std::vector<JsonPath>& paths,
+                                    JsonParseError* error) {
+    std::vector<JsonPathView> views(paths.begin(), paths.end());
+
+    JsonParam result;
+    result.doc_ = std::make_shared<rapidjson::Document>();
+    ProjectionHandler handler(views, result.doc_->GetAllocator());
+    rapidjson::Reader reader;
+    rapidjson::MemoryStream stream(json.data() ? json.data() : "", json.size());
+    rapidjson::ParseResult parsed = reader.Parse(stream, handler);
+    if (error) {
+        *error = JsonParseError{parsed.Code(), parsed.Offset()};
+    }
+    if (parsed.IsError()) {
+        result.doc_.reset();
+        return result;
+    }
+
+    static_cast<rapidjson::Value&>(*result.doc_) = handler.root();
+    return result;
+}
+
+}  // namespace json
+}  // namespace cpputil
@@ -0,0 +1,144 @@
+#include "json.h"
+#include "json_simd.h"
+#include "json_stats_recorder.h"
+#include <rapidjson/document.h>
+#include <atomic>
+
+namespace cpputil {
+namespace json {
+
+namespace simd {
+
+namespace {
+
+inline rapidjson::Document& document(void* document) {
+    return *static_cast<rapidjson::Document*>(document);
+}
+
+} // namespace
+
+bool DocumentSink::Null() { return document(document_).Null(); }
+bool DocumentSink::Bool(bool b) { return document(document_).Bool(b); }
+bool DocumentSink::Int(int i) { return document(document_).Int(i); }
+bool DocumentSink::Uint(unsigned u) { return document(document_).Uint(u); }
+bool DocumentSink::Int64(int64_t i) { return document(document_).Int64(i); }
+bool DocumentSink::Uint64(uint64_t u) { return document(document_).Uint64(u); }
+bool DocumentSink::Double(double d) { return document(document_).Double(d); }
+
+bool DocumentSink::RawNumber(const char* str, unsigned length, bool copy) {
+    return document(document_).RawNumber(str, length, copy);
+}
+
+bool DocumentSink::String(const char* str, unsigned length, bool copy) {
+    return document(document_).String(str, length, copy);
+}
+
+bool DocumentSink::StartObject() { return document(document_).StartObject(); }
+
+bool DocumentSink::Key(const char* str, unsigned length, bool copy) {
+    return document(document_).Key(str, length, copy);
+}
+
+bool DocumentSink::EndObject(unsigned member_count) { return document(document_).EndObject(member_count); }
+bool DocumentSink::StartArray() { return document(document_).StartArray(); }
+bool DocumentSink::EndArray(unsigned element_count) { return document(document_).EndArray(element_count); }
+
+} // namespace simd
+
+namespace {
+
+// 内核未编译进来时返回 nullptr
+const simd::Kernel* kernelOf(ParseKernel kernel) {
+#ifdef CPPUTIL_JSON_SIMD_X86
+    switch (kernel) {
+    case ParseKernel::kSse2:
+        return &simd::kSse2Kernel;
+    case ParseKernel::kSse42:
+        return &simd::kSse42Kernel;
+    default:
+        break;
+    }
+#else
+    (void)kernel;
+#endif
+    return nullptr;
+}
+
+bool cpuSupports(ParseKernel kernel) {
+#ifdef CPPUTIL_JSON_SIMD_X86
+    __builtin_cpu_init();
+    switch (kernel) {
+    case ParseKernel::kScalar:
+    case ParseKernel::kSse2:
+        return true;
+    case ParseKernel::kSse42:
+        return __builtin_cpu_supports("sse4.2");
+    }
+    return false;
+#else
+    return kernel == ParseKernel::kScalar;
+#endif
+}
+
+ParseKernel detectKernel() {
+    for (ParseKernel kernel : {ParseKernel::kSse42, ParseKernel::kSse2}) {
+        if (kernelOf(kernel) && cpuSupports(kernel)) {
+            return kernel;
+        }
+    }
+    return ParseKernel::kScalar;
+}
+
+std::atomic<ParseKernel>& activeKernel() {
+    static std::atomic<ParseKernel> kernel(detectKernel());
+    return kernel;
+}
+
+} // namespace
+
+ParseKernel parseKernel() {
+    return activeKernel().load(std::memory_order_relaxed);
+}
+
+bool setParseKernel(ParseKernel kernel) {
+    if (kernel != ParseKernel::kScalar && (!kernelOf(kernel) || !cpuSupports(kernel))) {
+        return false;
+    }
+    activeKernel().store(kernel, std::memory_order_relaxed);
+    return true;
+}
+
+JsonParseError JsonParam::parseTerminated(char* json, bool insitu) {
+    stats::OpTimer timer(JsonOp::kParse);
+    const simd::Kernel* kernel = kernelOf(parseKernel());
+    if (!kernel) {
+        if (insitu) {
+            doc_->ParseInsitu(json);
+        } else {
+            doc_->Parse(json);
+        }
+        JsonParseError error = takeParseError();
+        timer.fail(!error.ok());
+        return error;
+    }
+
+    // 内核只负责扫描，DOM 仍由 Document 的 handler 构建，结构与标量解析完全相同
+    simd::ParseStatus status{0, 0};
+    auto generator = [&](rapidjson::Document& handler) {
+        simd::DocumentSink sink(&handler);
+        status = insitu ? kernel->parseInsitu(json, sink) : kernel->parse(json, sink);
+        return status.code == rapidjson::kParseErrorNone;
+    };
+    doc_->Populate(generator);
+    JsonParseError error;
+    if (status.code != rapidjson::kParseErrorNone) {
+        error.code = static_cast<rapidjson::ParseErrorCode>(status.code);
+        error.offset = status.offset;
+        doc_.reset();
+        timer.fail();
+    }
+    return error;
+}
+
+} // namespace json
+} // namespace cpputil
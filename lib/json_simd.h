@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define CPPUTIL_JSON_ASAN 1
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__)
+#define CPPUTIL_JSON_ASAN 1
+#endif
+
+// 以 CPPUTIL_JSON_SIMD 构建（bazel build --config=simd）且目标为 x86-64 时编译 SIMD 扫描内核。
+// 内核按 16 字节对齐读取，可能越过 '\0' 读到同一页内缓冲区之后的字节，
+// AddressSanitizer 会报告越界，因此 ASan 构建退回标量实现
+#if defined(CPPUTIL_JSON_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && \
+    !defined(CPPUTIL_JSON_ASAN)
+#define CPPUTIL_JSON_SIMD_X86 1
+#endif
+
+namespace cpputil {
+namespace json {
+namespace simd {
+
+// 把 SAX 事件转交给 rapidjson::Document。每个内核所在的翻译单元都把 RapidJSON
+// 编译在自己的命名空间里（避免不同指令集的同名模板实例在链接时互相替换），
+// 看不到 rapidjson::Document，只能经由这里构建 DOM。成员定义在 json_simd.cpp
+class DocumentSink {
+public:
+    explicit DocumentSink(void* document) : document_(document) {}
+
+    bool Null();
+    bool Bool(bool b);
+    bool Int(int i);
+    bool Uint(unsigned u);
+    bool Int64(int64_t i);
+    bool Uint64(uint64_t u);
+    bool Double(double d);
+    bool RawNumber(const char* str, unsigned length, bool copy);
+    bool String(const char* str, unsigned length, bool copy);
+    bool StartObject();
+    bool Key(const char* str, unsigned length, bool copy);
+    bool EndObject(unsigned member_count);
+    bool StartArray();
+    bool EndArray(unsigned element_count);
+
+private:
+    void* document_;  // rapidjson::Document
+};
+
+// 解析结果，code 为 rapidjson::ParseErrorCode
+struct ParseStatus {
+    int code;
+    size_t offset;
+};
+
+// 一组扫描内核的解析入口，json 必须以 '\0' 结尾
+struct Kernel {
+    ParseStatus (*parse)(const char* json, DocumentSink& sink);
+    // 就地解码，字符串值指向 json
+    ParseStatus (*parseInsitu)(char* json, DocumentSink& sink);
+};
+
+#ifdef CPPUTIL_JSON_SIMD_X86
+extern const Kernel kSse2Kernel;
+extern const Kernel kSse42Kernel;
+#endif
+
+} // namespace simd
+} // namespace json
+} // namespace cpputil
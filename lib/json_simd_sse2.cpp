@@ -0,0 +1,43 @@
+// SSE2 扫描内核：RapidJSON 以 RAPIDJSON_SSE2 编译在私有命名空间里。
+// SSE2 是 x86-64 的基线指令集，无需额外的编译选项，作为不支持 SSE4.2 时的后备
+#include "json_simd.h"
+
+#ifdef CPPUTIL_JSON_SIMD_X86
+
+#define RAPIDJSON_SSE2
+#define RAPIDJSON_NAMESPACE cpputil_rapidjson_sse2
+#define RAPIDJSON_NAMESPACE_BEGIN namespace cpputil_rapidjson_sse2 {
+#define RAPIDJSON_NAMESPACE_END }
+#include <rapidjson/reader.h>
+
+namespace cpputil {
+namespace json {
+namespace simd {
+
+namespace {
+
+namespace rj = cpputil_rapidjson_sse2;
+
+ParseStatus parse(const char* json, DocumentSink& sink) {
+    rj::Reader reader;
+    rj::StringStream stream(json);
+    rj::ParseResult result = reader.Parse<rj::kParseDefaultFlags>(stream, sink);
+    return ParseStatus{static_cast<int>(result.Code()), result.Offset()};
+}
+
+ParseStatus parseInsitu(char* json, DocumentSink& sink) {
+    rj::Reader reader;
+    rj::InsituStringStream stream(json);
+    rj::ParseResult result = reader.Parse<rj::kParseDefaultFlags | rj::kParseInsituFlag>(stream, sink);
+    return ParseStatus{static_cast<int>(result.Code()), result.Offset()};
+}
+
+} // namespace
+
+const Kernel kSse2Kernel = {parse, parseInsitu};
+
+} // namespace simd
+} // namespace json
+} // namespace cpputil
+
+#endif // CPPUTIL_JSON_SIMD_X86
@@ -0,0 +1,66 @@
+// SSE4.2 扫描内核：RapidJSON 以 RAPIDJSON_SSE42 编译在私有命名空间里，空白跳过和
+// 字符串扫描使用 PCMPISTRI。只在运行时检测到 SSE4.2 后才会被调用，
+// 因此用 target pragma 而不是全局 -msse4.2 编译，其余代码仍可在任何 x86-64 上运行
+#include "json_simd.h"
+
+#ifdef CPPUTIL_JSON_SIMD_X86
+
+// 先在默认指令集下包含 RapidJSON 依赖的标准库头文件，它们的内联函数不带 SSE4.2 指令
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <string>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse4.2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("sse4.2")
+#endif
+
+#define RAPIDJSON_SSE42
+#define RAPIDJSON_NAMESPACE cpputil_rapidjson_sse42
+#define RAPIDJSON_NAMESPACE_BEGIN namespace cpputil_rapidjson_sse42 {
+#define RAPIDJSON_NAMESPACE_END }
+#include <rapidjson/reader.h>
+
+namespace cpputil {
+namespace json {
+namespace simd {
+
+namespace {
+
+namespace rj = cpputil_rapidjson_sse42;
+
+ParseStatus parse(const char* json, DocumentSink& sink) {
+    rj::Reader reader;
+    rj::StringStream stream(json);
+    rj::ParseResult result = reader.Parse<rj::kParseDefaultFlags>(stream, sink);
+    return ParseStatus{static_cast<int>(result.Code()), result.Offset()};
+}
+
+ParseStatus parseInsitu(char* json, DocumentSink& sink) {
+    rj::Reader reader;
+    rj::InsituStringStream stream(json);
+    rj::ParseResult result = reader.Parse<rj::kParseDefaultFlags | rj::kParseInsituFlag>(stream, sink);
+    return ParseStatus{static_cast<int>(result.Code()), result.Offset()};
+}
+
+} // namespace
+
+const Kernel kSse42Kernel = {parse, parseInsitu};
+
+} // namespace simd
+} // namespace json
+} // namespace cpputil
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif // CPPUTIL_JSON_SIMD_X86
@@ -0,0 +1,104 @@
+#include "json_snapshot.h"
+#include <algorithm>
+#include <vector>
+
+namespace cpputil {
+namespace json {
+
+namespace {
+
+// 版本号全局递增，同一地址上先后出现的两个持有者不会有相同的版本号，
+// 线程缓存因此可以只按地址和版本号匹配
+std::atomic<uint64_t> g_version(0);
+
+uint64_t nextVersion() {
+    return g_version.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+struct CacheEntry {
+    const void* state;
+    uint64_t version;
+    std::weak_ptr<const void> owner;  // 判断持有者是否已析构
+    JsonSnapshot value;
+};
+
+// 每个线程读过的持有者通常只有几个，线性查找即可
+thread_local std::vector<CacheEntry> t_cache;
+
+} // namespace
+
+AtomicJsonParam::AtomicJsonParam() : AtomicJsonParam(nullptr) {}
+
+AtomicJsonParam::AtomicJsonParam(JsonSnapshot initial) : state_(std::make_shared<State>()) {
+    state_->current = std::move(initial);
+    state_->version.store(nextVersion(), std::memory_order_release);
+}
+
+void AtomicJsonParam::store(JsonSnapshot next) {
+    JsonSnapshot old;
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        old = std::move(state_->current);
+        state_->current = std::move(next);
+        state_->version.store(nextVersion(), std::memory_order_release);
+    }
+    // 旧版本在锁外释放（如果这里是最后一个引用）
+}
+
+void AtomicJsonParam::store(JsonParam&& next) {
+    // 发布后只读，之后不会再有建立索引的机会
+    next.refreshMemberIndex();
+    store(std::make_shared<const JsonParam>(std::move(next)));
+}
+
+const JsonParam* AtomicJsonParam::get() const {
+    return cached().get();
+}
+
+JsonSnapshot AtomicJsonParam::load() const {
+    return cached();
+}
+
+uint64_t AtomicJsonParam::version() const {
+    return state_->version.load(std::memory_order_acquire);
+}
+
+void AtomicJsonParam::release() const {
+    const void* state = state_.get();
+    t_cache.erase(std::remove_if(t_cache.begin(), t_cache.end(),
+                                 [state](const CacheEntry& entry) { return entry.state == state; }),
+                  t_cache.end());
+}
+
+void AtomicJsonParam::releaseThreadCache() {
+    std::vector<CacheEntry>().swap(t_cache);
+}
+
+const JsonSnapshot& AtomicJsonParam::cached() const {
+    State* state = state_.get();
+    uint64_t version = state->version.load(std::memory_order_acquire);
+    auto it = std::find_if(t_cache.begin(), t_cache.end(),
+                           [state](const CacheEntry& entry) { return entry.state == state; });
+    if (it != t_cache.end() && it->version == version) {
+        return it->value;
+    }
+
+    // 未命中时顺便清理已析构的持有者留下的缓存，释放它们的最后一个版本
+    t_cache.erase(std::remove_if(t_cache.begin(), t_cache.end(),
+                                 [](const CacheEntry& entry) { return entry.owner.expired(); }),
+                  t_cache.end());
+    it = std::find_if(t_cache.begin(), t_cache.end(),
+                      [state](const CacheEntry& entry) { return entry.state == state; });
+    if (it == t_cache.end()) {
+        t_cache.push_back(CacheEntry{state, 0, state_, nullptr});
+        it = t_cache.end() - 1;
+    }
+    it->owner = state_;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    it->value = state->current;
+    it->version = state->version.load(std::memory_order_relaxed);
+    return it->value;
+}
+
+} // namespace json
+} // namespace cpputil
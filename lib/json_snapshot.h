@@ -0,0 +1,69 @@
+#pragma once
+
+#include "json.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace cpputil {
+namespace json {
+
+// 已发布的不可变文档
+using JsonSnapshot = std::shared_ptr<const JsonParam>;
+
+// 可热替换的文档持有者，读多写少，语义类似 RCU：写者原子地发布新版本，
+// 读者总能拿到某个完整的版本，旧版本在最后一个读者放下它之后释放。
+//
+// 每个线程缓存自己最近读到的版本。读取时只做一次原子读比较版本号，
+// 命中缓存就直接返回，不加锁、不改引用计数；版本变化后的第一次读取
+// 才加锁取新版本。get 返回的指针要在下一次读取前一直有效，发布者因此不能
+// 替读者放下旧版本，保留的上限是：每个线程为它读过的每个仍然存在的持有者
+// 保留一个版本，直到该线程再次读取这个持有者或调用 release/releaseThreadCache；
+// 已析构的持有者留下的版本在该线程下一次未命中缓存时释放。
+// 很少读取的线程应在空闲前调用 releaseThreadCache。旧版本可能在读者线程上析构
+class AtomicJsonParam {
+public:
+  AtomicJsonParam();
+  explicit AtomicJsonParam(JsonSnapshot initial);
+
+  AtomicJsonParam(const AtomicJsonParam &) = delete;
+  AtomicJsonParam &operator=(const AtomicJsonParam &) = delete;
+
+  // 发布新版本。发布后的对象不应再被修改；启用了成员索引的文档应在发布前
+  // 调用 refreshMemberIndex，右值版本会自动调用
+  void store(JsonSnapshot next);
+  void store(JsonParam &&next);
+
+  // 读取快路径，未发布任何版本时为空。
+  // 返回的指针在本线程下一次对同一对象调用 get/load 之前有效
+  const JsonParam *get() const;
+
+  // 当前版本的快照，可以长期持有或交给其他线程。命中缓存时不加锁，只增加一次引用计数
+  JsonSnapshot load() const;
+
+  // 当前版本号，每次 store 后变大
+  uint64_t version() const;
+
+  // 放下本线程缓存的该持有者的版本，之前 get 返回的指针随之失效
+  void release() const;
+
+  // 放下本线程缓存的所有版本，供线程空闲或退出前调用
+  static void releaseThreadCache();
+
+private:
+  struct State {
+    std::atomic<uint64_t> version;
+    std::mutex mutex;
+    JsonSnapshot current;
+  };
+
+  // 本线程缓存的当前版本
+  const JsonSnapshot &cached() const;
+
+  std::shared_ptr<State> state_;
+};
+
+} // namespace json
+} // namespace cpputil
@@ -0,0 +1,265 @@
+#include "json_stats.h"
+#include "json_stats_recorder.h"
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cpputil {
+namespace json {
+
+namespace {
+
+const char* const kOpNames[kJsonOpCount] = {"parse", "get", "set", "has", "update", "clone", "to_string"};
+
+} // namespace
+
+const char* jsonOpName(JsonOp op) {
+    size_t i = static_cast<size_t>(op);
+    return i < kJsonOpCount ? kOpNames[i] : "unknown";
+}
+
+uint64_t LatencyHistogram::count() const {
+    uint64_t n = 0;
+    for (uint64_t c : counts) {
+        n += c;
+    }
+    return n;
+}
+
+double LatencyHistogram::meanNanos() const {
+    uint64_t n = count();
+    return n ? static_cast<double>(total_nanos) / static_cast<double>(n) : 0.0;
+}
+
+uint64_t LatencyHistogram::percentileNanos(double q) const {
+    uint64_t n = count();
+    if (n == 0) {
+        return 0;
+    }
+    q = std::min(std::max(q, 0.0), 1.0);
+    // 第 rank 个（从 1 开始）调用所在的桶
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(q * static_cast<double>(n) + 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return (uint64_t(1) << (i + 1)) - 1;
+        }
+    }
+    return (uint64_t(1) << kBuckets) - 1;
+}
+
+void JsonStats::forEach(const std::function<void(std::string_view name, uint64_t value)>& visit) const {
+    std::string name;
+    for (size_t op = 0; op < kJsonOpCount; ++op) {
+        const JsonOpStats& stats = ops[op];
+        auto emit = [&](const char* suffix, uint64_t value) {
+            name.assign(kOpNames[op]).append(".").append(suffix);
+            visit(name, value);
+        };
+        emit("calls", stats.calls);
+        emit("failures", stats.failures);
+        emit("total_ns", stats.latency.total_nanos);
+        emit("p50_ns", stats.latency.percentileNanos(0.5));
+        emit("p99_ns", stats.latency.percentileNanos(0.99));
+    }
+    visit("created_paths", created_paths);
+}
+
+#ifdef CPPUTIL_JSON_STATS
+
+namespace stats {
+
+std::atomic<bool> g_enabled(true);
+std::atomic<uint32_t> g_latency_sampling(1);
+thread_local uint32_t t_skip_timing = 0;
+
+namespace {
+
+// 单个线程的计数。只有所属线程写入，用 relaxed 的 load + store 代替读改写；
+// 读取快照的线程看到的可能是稍旧的值，但不会撕裂
+struct alignas(64) ThreadCounters {
+    struct Op {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> failures{0};
+        std::atomic<uint64_t> total_nanos{0};
+        std::atomic<uint64_t> buckets[LatencyHistogram::kBuckets] = {};
+    };
+
+    Op ops[kJsonOpCount];
+    std::atomic<uint64_t> created_paths{0};
+
+    static void bump(std::atomic<uint64_t>& counter, uint64_t delta = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    void addTo(JsonStats& total) const {
+        for (size_t op = 0; op < kJsonOpCount; ++op) {
+            JsonOpStats& dst = total.ops[op];
+            dst.calls += ops[op].calls.load(std::memory_order_relaxed);
+            dst.failures += ops[op].failures.load(std::memory_order_relaxed);
+            dst.latency.total_nanos += ops[op].total_nanos.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < LatencyHistogram::kBuckets; ++i) {
+                dst.latency.counts[i] += ops[op].buckets[i].load(std::memory_order_relaxed);
+            }
+        }
+        total.created_paths += created_paths.load(std::memory_order_relaxed);
+    }
+};
+
+void accumulate(JsonStats& total, const JsonStats& part, bool subtract = false) {
+    auto apply = [subtract](uint64_t& a, uint64_t b) { a = subtract ? a - b : a + b; };
+    for (size_t op = 0; op < kJsonOpCount; ++op) {
+        JsonOpStats& dst = total.ops[op];
+        const JsonOpStats& src = part.ops[op];
+        apply(dst.calls, src.calls);
+        apply(dst.failures, src.failures);
+        apply(dst.latency.total_nanos, src.latency.total_nanos);
+        for (size_t i = 0; i < LatencyHistogram::kBuckets; ++i) {
+            apply(dst.latency.counts[i], src.latency.counts[i]);
+        }
+    }
+    apply(total.created_paths, part.created_paths);
+}
+
+// 所有线程的计数块；线程退出时把计数并入 retired
+class Registry {
+public:
+    void add(ThreadCounters* counters) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        live_.push_back(counters);
+    }
+
+    void remove(ThreadCounters* counters) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        counters->addTo(retired_);
+        live_.erase(std::find(live_.begin(), live_.end(), counters));
+    }
+
+    JsonStats snapshot() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        JsonStats total = totalLocked();
+        accumulate(total, baseline_, true);
+        return total;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        baseline_ = totalLocked();
+    }
+
+private:
+    JsonStats totalLocked() const {
+        JsonStats total = retired_;
+        for (const ThreadCounters* counters : live_) {
+            counters->addTo(total);
+        }
+        return total;
+    }
+
+    std::mutex mutex_;
+    std::vector<ThreadCounters*> live_;
+    JsonStats retired_;
+    // resetStats 时的总数，快照减去它；计数块只由所属线程写，不能从外部清零
+    JsonStats baseline_;
+};
+
+// 不析构：其他线程的 thread_local 计数块可能在静态对象析构之后才退出
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+class ThreadSlot {
+public:
+    ThreadSlot() { registry().add(&counters_); }
+    ~ThreadSlot() { registry().remove(&counters_); }
+
+    ThreadCounters& counters() { return counters_; }
+
+private:
+    ThreadCounters counters_;
+};
+
+ThreadCounters& local() {
+    thread_local ThreadSlot slot;
+    return slot.counters();
+}
+
+size_t bucketOf(uint64_t nanos) {
+    if (nanos == 0) {
+        return 0;
+    }
+    size_t bucket = 63 - static_cast<size_t>(__builtin_clzll(nanos));
+    return std::min(bucket, LatencyHistogram::kBuckets - 1);
+}
+
+} // namespace
+
+void record(JsonOp op, bool failed, bool timed, uint64_t nanos) {
+    ThreadCounters::Op& counters = local().ops[static_cast<size_t>(op)];
+    ThreadCounters::bump(counters.calls);
+    if (failed) {
+        ThreadCounters::bump(counters.failures);
+    }
+    if (timed) {
+        ThreadCounters::bump(counters.total_nanos, nanos);
+        ThreadCounters::bump(counters.buckets[bucketOf(nanos)]);
+    }
+}
+
+void recordCreatedPath() {
+    ThreadCounters::bump(local().created_paths);
+}
+
+} // namespace stats
+
+bool statsCompiledIn() {
+    return true;
+}
+
+void setStatsEnabled(bool enabled) {
+    stats::g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool statsEnabled() {
+    return stats::g_enabled.load(std::memory_order_relaxed);
+}
+
+void setStatsLatencySampling(uint32_t every) {
+    stats::g_latency_sampling.store(std::max<uint32_t>(every, 1), std::memory_order_relaxed);
+}
+
+JsonStats statsSnapshot() {
+    return stats::registry().snapshot();
+}
+
+void resetStats() {
+    stats::registry().reset();
+}
+
+#else
+
+bool statsCompiledIn() {
+    return false;
+}
+
+void setStatsEnabled(bool) {}
+
+bool statsEnabled() {
+    return false;
+}
+
+void setStatsLatencySampling(uint32_t) {}
+
+JsonStats statsSnapshot() {
+    return JsonStats();
+}
+
+void resetStats() {}
+
+#endif
+
+} // namespace json
+} // namespace cpputil
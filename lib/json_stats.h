@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+namespace cpputil {
+namespace json {
+
+// JsonParam 操作计数与延迟直方图。
+//
+// 统计只在以 --config=stats 构建（定义 CPPUTIL_JSON_STATS）时编译进库，
+// 否则埋点是空的内联函数，不产生任何指令，statsSnapshot() 恒为全零。
+// 编译进来后默认开启，可以用 setStatsEnabled 暂停。每个线程写自己的计数块，
+// 热路径上没有原子读改写和锁；读取快照时才把各线程的计数加在一起
+
+// 被统计的操作
+enum class JsonOp {
+  kParse,    // 构造时解析、reset
+  kGet,      // get<T>
+  kSet,      // set<T>
+  kHas,      // has
+  kUpdate,   // update、mergeAll
+  kClone,    // clone
+  kToString, // toString
+};
+
+constexpr size_t kJsonOpCount = 7;
+
+// 操作名，如 "get"、"to_string"
+const char *jsonOpName(JsonOp op);
+
+// 按 2 的幂分桶的延迟直方图：第 i 个桶统计耗时在 [2^i, 2^(i+1)) 纳秒的调用，
+// 第 0 个桶包含 0 纳秒，最后一个桶包含所有更长的调用
+struct LatencyHistogram {
+  static constexpr size_t kBuckets = 40;
+
+  std::array<uint64_t, kBuckets> counts{};
+  uint64_t total_nanos = 0;
+
+  uint64_t count() const;
+  double meanNanos() const;
+
+  // 第 q（0 到 1）分位所在桶的上界，纳秒；没有数据时返回 0
+  uint64_t percentileNanos(double q) const;
+};
+
+struct JsonOpStats {
+  uint64_t calls = 0;
+  // 失败次数：解析失败，get/has 路径不存在，set/update/clone 失败
+  uint64_t failures = 0;
+  // 被计时调用的延迟，见 setStatsLatencySampling
+  LatencyHistogram latency;
+};
+
+struct JsonStats {
+  std::array<JsonOpStats, kJsonOpCount> ops{};
+  // set 新建路径的次数：追加对象成员或扩展数组各算一次
+  uint64_t created_paths = 0;
+
+  const JsonOpStats &operator[](JsonOp op) const {
+    return ops[static_cast<size_t>(op)];
+  }
+
+  // 以扁平的名字逐项输出，便于导出到监控系统：
+  // "<op>.calls"、"<op>.failures"、"<op>.total_ns"、"<op>.p50_ns"、
+  // "<op>.p99_ns" 以及 "created_paths"
+  void forEach(const std::function<void(std::string_view name, uint64_t value)>
+                   &visit) const;
+};
+
+// 库是否以统计支持编译
+bool statsCompiledIn();
+
+// 暂停或恢复记录，未编译统计时无效果
+void setStatsEnabled(bool enabled);
+bool statsEnabled();
+
+// 每个线程每 every 次调用计时一次（默认 1，即每次都计时）。计数始终精确，
+// 直方图只包含被计时的调用；读时钟是埋点的主要开销，热路径上可设为 8~64
+void setStatsLatencySampling(uint32_t every);
+
+// 合并所有线程（含已退出的线程）自上次 resetStats 以来的计数
+JsonStats statsSnapshot();
+
+// 之后的快照从零开始计数
+void resetStats();
+
+} // namespace json
+} // namespace cpputil
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "json_stats.h"
+
+#ifdef CPPUTIL_JSON_STATS
+#include <atomic>
+#include <chrono>
+#endif
+
+namespace cpputil {
+namespace json {
+namespace stats {
+
+// 库内部的埋点。未定义 CPPUTIL_JSON_STATS 时全部是空的内联函数，
+// 编译器会把它们连同调用一起消除
+
+#ifdef CPPUTIL_JSON_STATS
+
+extern std::atomic<bool> g_enabled;
+extern std::atomic<uint32_t> g_latency_sampling;
+// 距下一次计时还要跳过的调用数
+extern thread_local uint32_t t_skip_timing;
+
+// timed 为 false 时只计数，nanos 无意义
+void record(JsonOp op, bool failed, bool timed, uint64_t nanos);
+void recordCreatedPath();
+
+// 作用域计时：构造时开始，析构时记录一次调用。按采样间隔只对部分调用读时钟
+class OpTimer {
+public:
+  explicit OpTimer(JsonOp op)
+      : op_(op), active_(g_enabled.load(std::memory_order_relaxed)) {
+    if (!active_) {
+      return;
+    }
+    if (t_skip_timing == 0) {
+      t_skip_timing = g_latency_sampling.load(std::memory_order_relaxed) - 1;
+      timed_ = true;
+      start_ = std::chrono::steady_clock::now();
+    } else {
+      --t_skip_timing;
+    }
+  }
+
+  ~OpTimer() {
+    if (!active_) {
+      return;
+    }
+    uint64_t nanos = 0;
+    if (timed_) {
+      auto elapsed = std::chrono::steady_clock::now() - start_;
+      nanos = static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+    record(op_, failed_, timed_, nanos);
+  }
+
+  OpTimer(const OpTimer &) = delete;
+  OpTimer &operator=(const OpTimer &) = delete;
+
+  // 把本次调用记为失败
+  void fail(bool failed = true) { failed_ = failed; }
+
+private:
+  JsonOp op_;
+  bool active_;
+  bool timed_ = false;
+  bool failed_ = false;
+  std::chrono::steady_clock::time_point start_;
+};
+
+inline void createdPath() {
+  if (g_enabled.load(std::memory_order_relaxed)) {
+    recordCreatedPath();
+  }
+}
+
+#else
+
+class OpTimer {
+public:
+  explicit OpTimer(JsonOp) {}
+  void fail(bool = true) {}
+};
+
+inline void createdPath() {}
+
+#endif
+
+} // namespace stats
+} // namespace json
+} // namespace cpputil
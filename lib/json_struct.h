@@ -0,0 +1,321 @@
+#pragma once
+
+#include "json.h"
+
+#include <map>
+#include <optional>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 结构体绑定：在结构体所在的命名空间中声明字段映射，
+//
+//   struct User { std::string name; int age = 0; std::vector<std::string> tags; };
+//   CPPUTIL_JSON_FIELDS(User, name, age, tags)
+//
+// 之后 JsonParam::decode 一次遍历填充整个结构体，encode 经 RapidJSON Writer
+// 直接输出 JSON，不构造中间 DOM。字段名即 JSON key，成员必须是公有的，最多 32 个字段。
+// 字段类型可以是 bool、int、int64_t、unsigned、uint64_t、float、double、std::string、
+// 已声明映射的结构体，以及它们组成的 std::vector、std::map/std::unordered_map（key 为
+// std::string）、std::optional
+
+namespace cpputil {
+namespace json {
+
+// 字段描述：JSON key 与成员指针
+template <typename C, typename M> struct JsonField {
+  std::string_view name;
+  M C::*member;
+};
+
+template <typename C, typename M>
+constexpr JsonField<C, M> jsonField(std::string_view name, M C::*member) {
+  return JsonField<C, M>{name, member};
+}
+
+namespace detail {
+
+// 经 ADL 查找 CPPUTIL_JSON_FIELDS 生成的 cpputilJsonFields
+template <typename T, typename = void> struct has_json_fields : std::false_type {};
+
+template <typename T>
+struct has_json_fields<
+    T, std::void_t<decltype(cpputilJsonFields(static_cast<const T *>(nullptr)))>>
+    : std::true_type {};
+
+template <typename T> struct is_vector : std::false_type {};
+template <typename V> struct is_vector<std::vector<V>> : std::true_type {};
+
+template <typename T> struct is_string_map : std::false_type {};
+template <typename V>
+struct is_string_map<std::map<std::string, V>> : std::true_type {};
+template <typename V>
+struct is_string_map<std::unordered_map<std::string, V>> : std::true_type {};
+
+template <typename T> struct is_optional : std::false_type {};
+template <typename V> struct is_optional<std::optional<V>> : std::true_type {};
+
+template <typename T> struct dependent_false : std::false_type {};
+
+struct StructAccess {
+  // 与 get 相同的成员查找，启用成员索引的大对象走索引
+  static rapidjson::Value::ConstMemberIterator
+  findMember(const JsonParam &owner, const rapidjson::Value &object,
+             std::string_view key) {
+    return owner.findMember(object, key);
+  }
+};
+
+template <typename T>
+bool decodeValue(const JsonParam &owner, const rapidjson::Value &value, T &out);
+
+// 按字段声明顺序读取：先看游标处的成员，JSON 与结构体字段顺序一致时每个字段 O(1)，
+// 否则回退到 owner 的成员查找
+template <typename T>
+bool decodeStruct(const JsonParam &owner, const rapidjson::Value &object, T &out) {
+  if (!object.IsObject()) {
+    return false;
+  }
+  bool ok = true;
+  rapidjson::SizeType cursor = 0;
+  auto decodeField = [&](const auto &field) {
+    rapidjson::Value::ConstMemberIterator member = object.MemberEnd();
+    if (cursor < object.MemberCount()) {
+      const rapidjson::Value &name = object.MemberBegin()[cursor].name;
+      if (std::string_view(name.GetString(), name.GetStringLength()) == field.name) {
+        member = object.MemberBegin() + cursor;
+      }
+    }
+    if (member == object.MemberEnd()) {
+      member = StructAccess::findMember(owner, object, field.name);
+      if (member == object.MemberEnd()) {
+        // 缺失的字段保持原值
+        return;
+      }
+    }
+    cursor = static_cast<rapidjson::SizeType>(member - object.MemberBegin()) + 1;
+    ok = decodeValue(owner, member->value, out.*(field.member)) && ok;
+  };
+  std::apply([&](const auto &...fields) { (decodeField(fields), ...); },
+             cpputilJsonFields(static_cast<const T *>(nullptr)));
+  return ok;
+}
+
+// 类型不符时 out 保持原值并返回 false；容器中不符的元素保留默认值
+template <typename T>
+bool decodeValue(const JsonParam &owner, const rapidjson::Value &value, T &out) {
+  if constexpr (std::is_same_v<T, bool>) {
+    if (!value.IsBool()) return false;
+    out = value.GetBool();
+  } else if constexpr (std::is_same_v<T, int>) {
+    if (!value.IsInt()) return false;
+    out = value.GetInt();
+  } else if constexpr (std::is_same_v<T, int64_t>) {
+    if (!value.IsInt64()) return false;
+    out = value.GetInt64();
+  } else if constexpr (std::is_same_v<T, unsigned>) {
+    if (!value.IsUint()) return false;
+    out = value.GetUint();
+  } else if constexpr (std::is_same_v<T, uint64_t>) {
+    if (!value.IsUint64()) return false;
+    out = value.GetUint64();
+  } else if constexpr (std::is_floating_point_v<T>) {
+    if (!value.IsNumber()) return false;
+    out = static_cast<T>(value.GetDouble());
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    if (!value.IsString()) return false;
+    out.assign(value.GetString(), value.GetStringLength());
+  } else if constexpr (is_optional<T>::value) {
+    if (value.IsNull()) {
+      out.reset();
+      return true;
+    }
+    typename T::value_type element{};
+    if (!decodeValue(owner, value, element)) {
+      return false;
+    }
+    out = std::move(element);
+  } else if constexpr (is_vector<T>::value) {
+    if (!value.IsArray()) return false;
+    bool ok = true;
+    out.clear();
+    out.reserve(value.Size());
+    for (auto item = value.Begin(); item != value.End(); ++item) {
+      typename T::value_type element{};
+      ok = decodeValue(owner, *item, element) && ok;
+      out.push_back(std::move(element));
+    }
+    return ok;
+  } else if constexpr (is_string_map<T>::value) {
+    if (!value.IsObject()) return false;
+    bool ok = true;
+    out.clear();
+    for (auto member = value.MemberBegin(); member != value.MemberEnd(); ++member) {
+      typename T::mapped_type element{};
+      ok = decodeValue(owner, member->value, element) && ok;
+      out[std::string(member->name.GetString(), member->name.GetStringLength())] =
+          std::move(element);
+    }
+    return ok;
+  } else if constexpr (has_json_fields<T>::value) {
+    return decodeStruct(owner, value, out);
+  } else {
+    static_assert(dependent_false<T>::value, "type has no JSON binding");
+  }
+  return true;
+}
+
+template <typename Writer, typename T>
+void encodeValue(Writer &writer, const T &value) {
+  if constexpr (std::is_same_v<T, bool>) {
+    writer.Bool(value);
+  } else if constexpr (std::is_same_v<T, int>) {
+    writer.Int(value);
+  } else if constexpr (std::is_same_v<T, int64_t>) {
+    writer.Int64(value);
+  } else if constexpr (std::is_same_v<T, unsigned>) {
+    writer.Uint(value);
+  } else if constexpr (std::is_same_v<T, uint64_t>) {
+    writer.Uint64(value);
+  } else if constexpr (std::is_floating_point_v<T>) {
+    writer.Double(static_cast<double>(value));
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    writer.String(value.data(), static_cast<rapidjson::SizeType>(value.size()));
+  } else if constexpr (is_optional<T>::value) {
+    if (value) {
+      encodeValue(writer, *value);
+    } else {
+      writer.Null();
+    }
+  } else if constexpr (is_vector<T>::value) {
+    writer.StartArray();
+    for (const auto &element : value) {
+      encodeValue(writer, static_cast<const typename T::value_type &>(element));
+    }
+    writer.EndArray();
+  } else if constexpr (is_string_map<T>::value) {
+    writer.StartObject();
+    for (const auto &entry : value) {
+      writer.Key(entry.first.data(), static_cast<rapidjson::SizeType>(entry.first.size()));
+      encodeValue(writer, entry.second);
+    }
+    writer.EndObject();
+  } else if constexpr (has_json_fields<T>::value) {
+    writer.StartObject();
+    auto encodeField = [&](const auto &field) {
+      const auto &member = value.*(field.member);
+      // 空的 optional 字段整体省略
+      if constexpr (is_optional<std::decay_t<decltype(member)>>::value) {
+        if (!member) {
+          return;
+        }
+      }
+      writer.Key(field.name.data(), static_cast<rapidjson::SizeType>(field.name.size()));
+      encodeValue(writer, member);
+    };
+    std::apply([&](const auto &...fields) { (encodeField(fields), ...); },
+               cpputilJsonFields(static_cast<const T *>(nullptr)));
+    writer.EndObject();
+  } else {
+    static_assert(dependent_false<T>::value, "type has no JSON binding");
+  }
+}
+
+} // namespace detail
+
+template <typename T>
+bool JsonParam::decode(const JsonPathView &path, T &out) const {
+  // 与 get 相同：整个文档用 JsonPath::root()，其他空路径什么也不选
+  const rapidjson::Value *value = getValueByPath(path);
+  return value && detail::decodeValue(*this, *value, out);
+}
+
+// 把 value 写到任意 RapidJSON Writer（Writer、PrettyWriter 等）
+template <typename Writer, typename T> void encode(Writer &writer, const T &value) {
+  detail::encodeValue(writer, value);
+}
+
+// 把 value 序列化为 JSON 字符串
+template <typename T> std::string encode(const T &value) {
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  detail::encodeValue(writer, value);
+  return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+} // namespace json
+} // namespace cpputil
+
+#define CPPUTIL_JSON_EXPAND(x) x
+#define CPPUTIL_JSON_FOR_EACH_1(M, x) M(x)
+#define CPPUTIL_JSON_FOR_EACH_2(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_1(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_3(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_2(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_4(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_3(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_5(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_4(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_6(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_5(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_7(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_6(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_8(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_7(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_9(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_8(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_10(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_9(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_11(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_10(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_12(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_11(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_13(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_12(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_14(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_13(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_15(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_14(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_16(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_15(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_17(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_16(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_18(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_17(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_19(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_18(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_20(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_19(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_21(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_20(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_22(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_21(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_23(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_22(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_24(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_23(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_25(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_24(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_26(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_25(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_27(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_26(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_28(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_27(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_29(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_28(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_30(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_29(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_31(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_30(M, __VA_ARGS__))
+#define CPPUTIL_JSON_FOR_EACH_32(M, x, ...) M(x), CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_FOR_EACH_31(M, __VA_ARGS__))
+#define CPPUTIL_JSON_SELECT_FOR_EACH(                                          \
+    _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16,    \
+    _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30,     \
+    _31, _32, NAME, ...)                                                      \
+  NAME
+#define CPPUTIL_JSON_FOR_EACH(M, ...)                                          \
+  CPPUTIL_JSON_EXPAND(CPPUTIL_JSON_SELECT_FOR_EACH(                             \
+      __VA_ARGS__,                                                            \
+      CPPUTIL_JSON_FOR_EACH_32, CPPUTIL_JSON_FOR_EACH_31,                     \
+      CPPUTIL_JSON_FOR_EACH_30, CPPUTIL_JSON_FOR_EACH_29,                     \
+      CPPUTIL_JSON_FOR_EACH_28, CPPUTIL_JSON_FOR_EACH_27,                     \
+      CPPUTIL_JSON_FOR_EACH_26, CPPUTIL_JSON_FOR_EACH_25,                     \
+      CPPUTIL_JSON_FOR_EACH_24, CPPUTIL_JSON_FOR_EACH_23,                     \
+      CPPUTIL_JSON_FOR_EACH_22, CPPUTIL_JSON_FOR_EACH_21,                     \
+      CPPUTIL_JSON_FOR_EACH_20, CPPUTIL_JSON_FOR_EACH_19,                     \
+      CPPUTIL_JSON_FOR_EACH_18, CPPUTIL_JSON_FOR_EACH_17,                     \
+      CPPUTIL_JSON_FOR_EACH_16, CPPUTIL_JSON_FOR_EACH_15,                     \
+      CPPUTIL_JSON_FOR_EACH_14, CPPUTIL_JSON_FOR_EACH_13,                     \
+      CPPUTIL_JSON_FOR_EACH_12, CPPUTIL_JSON_FOR_EACH_11,                     \
+      CPPUTIL_JSON_FOR_EACH_10, CPPUTIL_JSON_FOR_EACH_9,                      \
+      CPPUTIL_JSON_FOR_EACH_8, CPPUTIL_JSON_FOR_EACH_7,                       \
+      CPPUTIL_JSON_FOR_EACH_6, CPPUTIL_JSON_FOR_EACH_5,                       \
+      CPPUTIL_JSON_FOR_EACH_4, CPPUTIL_JSON_FOR_EACH_3,                       \
+      CPPUTIL_JSON_FOR_EACH_2, CPPUTIL_JSON_FOR_EACH_1, )(M, __VA_ARGS__))
+
+#define CPPUTIL_JSON_FIELD(x) ::cpputil::json::jsonField(#x, &CppUtilJsonType::x)
+
+// 在 Type 所在的命名空间中声明字段映射，供 ADL 查找
+#define CPPUTIL_JSON_FIELDS(Type, ...)                                         \
+  inline auto cpputilJsonFields(const Type *) {                               \
+    using CppUtilJsonType = Type;                                             \
+    return std::make_tuple(                                                   \
+        CPPUTIL_JSON_FOR_EACH(CPPUTIL_JSON_FIELD, __VA_ARGS__));              \
+  }
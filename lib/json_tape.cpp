@@ -0,0 +1,572 @@
+#include "json_tape.h"
+#include <rapidjson/document.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace cpputil {
+namespace json {
+
+namespace detail {
+
+// 磁带中的一个节点，布局即文件格式
+struct TapeNode {
+    uint32_t type;     // 低 8 位为节点类型，其余位为标志
+    uint32_t count;    // 字符串长度 / 数组元素数 / 对象成员数
+    uint64_t payload;  // 标量的值，或字符串、子节点所在的偏移
+};
+
+static_assert(sizeof(TapeNode) == 16, "tape node layout");
+
+} // namespace detail
+
+namespace {
+
+using detail::TapeNode;
+
+enum TapeType : uint32_t {
+    kTapeNull = 0,
+    kTapeFalse,
+    kTapeTrue,
+    kTapeInt64,
+    kTapeUint64,
+    kTapeDouble,
+    kTapeString,
+    kTapeArray,
+    kTapeObject,
+};
+
+constexpr uint32_t kTypeMask = 0xff;
+// 对象成员之后附带按键排序的 uint32 下标
+constexpr uint32_t kSortedIndexFlag = 0x100;
+// 成员数超过该值的对象才建立排序下标，小对象线性查找更快
+constexpr uint32_t kSortedIndexThreshold = 8;
+
+constexpr char kMagic[8] = {'J', 'S', 'O', 'N', 'T', 'A', 'P', 'E'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+constexpr size_t kMaxDepth = 512;
+
+struct TapeHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t size;  // 整个磁带的字节数
+    uint64_t root;  // 根节点偏移
+};
+
+static_assert(sizeof(TapeHeader) % sizeof(TapeNode) == 0, "nodes must stay aligned");
+
+uint32_t typeOf(const TapeNode& node) { return node.type & kTypeMask; }
+
+// 对象的 n 对成员之后附带的下标占用的节点数
+uint64_t sortedIndexNodes(uint64_t members) {
+    return (members * sizeof(uint32_t) + sizeof(TapeNode) - 1) / sizeof(TapeNode);
+}
+
+// 先在 vector 中按下标构建节点（vector 会扩容，不能持有引用），
+// 字符串先记录在字符串表中的相对位置，最后统一加上字符串表的起始偏移
+class TapeEncoder {
+public:
+    std::string encode(const rapidjson::Value& root) {
+        nodes_.resize(1);
+        fill(root, 0);
+
+        uint64_t strings_base = sizeof(TapeHeader) + nodes_.size() * sizeof(TapeNode);
+        for (size_t index : string_nodes_) {
+            nodes_[index].payload += strings_base;
+        }
+
+        TapeHeader header;
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.byte_order = kByteOrderMark;
+        header.size = strings_base + strings_.size();
+        header.root = sizeof(TapeHeader);
+
+        std::string out;
+        out.reserve(header.size);
+        out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.append(reinterpret_cast<const char*>(nodes_.data()), nodes_.size() * sizeof(TapeNode));
+        out.append(strings_);
+        return out;
+    }
+
+private:
+    void fill(const rapidjson::Value& value, size_t index) {
+        TapeNode node{};
+        switch (value.GetType()) {
+        case rapidjson::kNullType:
+            node.type = kTapeNull;
+            break;
+        case rapidjson::kFalseType:
+            node.type = kTapeFalse;
+            break;
+        case rapidjson::kTrueType:
+            node.type = kTapeTrue;
+            break;
+        case rapidjson::kNumberType:
+            if (value.IsUint64()) {
+                node.type = kTapeUint64;
+                node.payload = value.GetUint64();
+            } else if (value.IsInt64()) {
+                node.type = kTapeInt64;
+                node.payload = static_cast<uint64_t>(value.GetInt64());
+            } else {
+                double d = value.GetDouble();
+                node.type = kTapeDouble;
+                std::memcpy(&node.payload, &d, sizeof(d));
+            }
+            break;
+        case rapidjson::kStringType:
+            node = stringNode(value.GetString(), value.GetStringLength(), index);
+            break;
+        case rapidjson::kArrayType: {
+            size_t start = allocate(value.Size());
+            node.type = kTapeArray;
+            node.count = value.Size();
+            node.payload = offsetOf(start);
+            for (rapidjson::SizeType i = 0; i < value.Size(); ++i) {
+                fill(value[i], start + i);
+            }
+            break;
+        }
+        case rapidjson::kObjectType:
+            node = objectNode(value);
+            break;
+        }
+        nodes_[index] = node;
+    }
+
+    TapeNode objectNode(const rapidjson::Value& object) {
+        uint32_t count = object.MemberCount();
+        bool sorted = count > kSortedIndexThreshold;
+        size_t start = allocate(2 * static_cast<size_t>(count) + (sorted ? sortedIndexNodes(count) : 0));
+
+        std::vector<std::string_view> keys;
+        keys.reserve(count);
+        size_t slot = start;
+        for (auto it = object.MemberBegin(); it != object.MemberEnd(); ++it, slot += 2) {
+            nodes_[slot] = stringNode(it->name.GetString(), it->name.GetStringLength(), slot);
+            keys.emplace_back(it->name.GetString(), it->name.GetStringLength());
+            fill(it->value, slot + 1);
+        }
+
+        if (sorted) {
+            // 稳定排序，重复的键按原顺序排列，二分查找命中第一个，与 JsonParam 一致
+            std::vector<uint32_t> order(count);
+            for (uint32_t i = 0; i < count; ++i) {
+                order[i] = i;
+            }
+            std::stable_sort(order.begin(), order.end(),
+                             [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+            std::memcpy(&nodes_[start + 2 * static_cast<size_t>(count)], order.data(),
+                        order.size() * sizeof(uint32_t));
+        }
+
+        TapeNode node{};
+        node.type = kTapeObject | (sorted ? kSortedIndexFlag : 0);
+        node.count = count;
+        node.payload = offsetOf(start);
+        return node;
+    }
+
+    TapeNode stringNode(const char* str, uint32_t length, size_t index) {
+        std::string_view key(str, length);
+        auto it = string_offsets_.find(key);
+        uint64_t offset;
+        if (it != string_offsets_.end()) {
+            offset = it->second;
+        } else {
+            offset = strings_.size();
+            strings_.append(str, length);
+            strings_.push_back('\0');
+            string_offsets_.emplace(key, offset);
+        }
+        string_nodes_.push_back(index);
+
+        TapeNode node{};
+        node.type = kTapeString;
+        node.count = length;
+        node.payload = offset;
+        return node;
+    }
+
+    // 追加 n 个连续节点，返回第一个的下标
+    size_t allocate(size_t n) {
+        size_t start = nodes_.size();
+        nodes_.resize(start + n);
+        return start;
+    }
+
+    static uint64_t offsetOf(size_t index) { return sizeof(TapeHeader) + index * sizeof(TapeNode); }
+
+    std::vector<TapeNode> nodes_;
+    std::vector<size_t> string_nodes_;
+    std::string strings_;
+    // 键引用源文档中的字符串，编码期间源文档不变
+    std::unordered_map<std::string_view, uint64_t> string_offsets_;
+};
+
+// 只读文件映射，析构时解除映射
+class TapeMapping {
+public:
+    TapeMapping(void* addr, size_t length) : addr_(addr), length_(length) {}
+    ~TapeMapping() { ::munmap(addr_, length_); }
+    TapeMapping(const TapeMapping&) = delete;
+    TapeMapping& operator=(const TapeMapping&) = delete;
+
+    const char* data() const { return static_cast<const char*>(addr_); }
+
+private:
+    void* addr_;
+    size_t length_;
+};
+
+} // namespace
+
+std::string JsonTapeView::encode(const JsonParam& json) {
+    if (!json.isValid()) {
+        return std::string();
+    }
+    return TapeEncoder().encode(*json.doc_);
+}
+
+bool JsonTapeView::writeFile(const JsonParam& json, const std::string& path) {
+    std::string tape = encode(json);
+    if (tape.empty()) {
+        return false;
+    }
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = std::fwrite(tape.data(), 1, tape.size(), file) == tape.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+JsonTapeView JsonTapeView::open(const std::string& path) {
+    JsonTapeView view;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || ::fstat(fd, &st) != 0) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        view.fail("cannot open file");
+        return view;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size < sizeof(TapeHeader)) {
+        ::close(fd);
+        view.fail("truncated header");
+        return view;
+    }
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        view.fail("cannot map file");
+        return view;
+    }
+
+    auto mapping = std::make_shared<TapeMapping>(addr, size);
+    const char* data = mapping->data();
+    view.attach(std::move(mapping), data, size);
+    return view;
+}
+
+JsonTapeView::JsonTapeView(std::string tape) {
+    auto owned = std::make_shared<std::string>(std::move(tape));
+    const char* data = owned->data();
+    size_t size = owned->size();
+    attach(std::move(owned), data, size);
+}
+
+void JsonTapeView::attach(std::shared_ptr<const void> anchor, const char* data, size_t size) {
+    const char* error = nullptr;
+    TapeHeader header;
+    if (size < sizeof(TapeHeader)) {
+        error = "truncated header";
+    } else if (reinterpret_cast<uintptr_t>(data) % alignof(TapeNode) != 0) {
+        error = "misaligned data";
+    } else {
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+            error = "bad magic";
+        } else if (header.byte_order != kByteOrderMark) {
+            error = "byte order mismatch";
+        } else if (header.version != kVersion) {
+            error = "unsupported version";
+        } else if (header.size != size) {
+            error = "size mismatch";
+        }
+    }
+    if (error) {
+        fail(error);
+        return;
+    }
+
+    anchor_ = std::move(anchor);
+    base_ = data;
+    size_ = size;
+    if (!root()) {
+        anchor_.reset();
+        base_ = nullptr;
+        size_ = 0;
+        fail("bad root offset");
+    }
+}
+
+void JsonTapeView::fail(const char* reason) {
+    error_.code = rapidjson::kParseErrorValueInvalid;
+    error_.offset = 0;
+    error_.reason = reason;
+}
+
+const JsonTapeView::Node* JsonTapeView::node(uint64_t offset) const {
+    if (offset % alignof(Node) != 0 || offset > size_ || size_ - offset < sizeof(Node)) {
+        return nullptr;
+    }
+    return reinterpret_cast<const Node*>(base_ + offset);
+}
+
+const JsonTapeView::Node* JsonTapeView::root() const {
+    if (!base_) {
+        return nullptr;
+    }
+    return node(reinterpret_cast<const TapeHeader*>(base_)->root);
+}
+
+bool JsonTapeView::stringOf(const Node& node, std::string_view& out) const {
+    if (typeOf(node) != kTapeString || node.payload >= size_ || node.count >= size_ - node.payload ||
+        base_[node.payload + node.count] != '\0') {
+        return false;
+    }
+    out = std::string_view(base_ + node.payload, node.count);
+    return true;
+}
+
+const JsonTapeView::Node* JsonTapeView::findMember(const Node& object, std::string_view key) const {
+    uint64_t count = object.count;
+    auto keyAt = [&](uint64_t i, std::string_view& out) {
+        const Node* name = node(object.payload + 2 * i * sizeof(Node));
+        return name && stringOf(*name, out);
+    };
+
+    if (!(object.type & kSortedIndexFlag)) {
+        std::string_view name;
+        for (uint64_t i = 0; i < count; ++i) {
+            if (keyAt(i, name) && name == key) {
+                return node(object.payload + (2 * i + 1) * sizeof(Node));
+            }
+        }
+        return nullptr;
+    }
+
+    // 下标紧跟在 n 对成员之后
+    uint64_t index_offset = object.payload + 2 * count * sizeof(Node);
+    if (object.payload > size_ || index_offset > size_ || size_ - index_offset < count * sizeof(uint32_t)) {
+        return nullptr;
+    }
+    auto memberAt = [&](uint64_t position) {
+        uint32_t i;
+        std::memcpy(&i, base_ + index_offset + position * sizeof(uint32_t), sizeof(i));
+        return static_cast<uint64_t>(i);
+    };
+
+    uint64_t lo = 0;
+    uint64_t hi = count;
+    std::string_view name;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (!keyAt(memberAt(mid), name)) {
+            return nullptr;
+        }
+        if (name < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == count || !keyAt(memberAt(lo), name) || name != key) {
+        return nullptr;
+    }
+    return node(object.payload + (2 * memberAt(lo) + 1) * sizeof(Node));
+}
+
+const JsonTapeView::Node* JsonTapeView::find(const JsonPathView& path) const {
+    if (path.empty() && !path.isRoot()) {
+        return nullptr;
+    }
+    const Node* current = root();
+    for (const auto& element : path) {
+        if (!current) {
+            return nullptr;
+        }
+        std::string_view key;
+        size_t index = 0;
+        if (JsonPathView::keyOf(element, typeOf(*current) == kTapeObject, key, index)) {
+            if (typeOf(*current) != kTapeObject) {
+                return nullptr;
+            }
+            current = findMember(*current, key);
+        } else {
+            if (typeOf(*current) != kTapeArray || index >= current->count) {
+                return nullptr;
+            }
+            current = node(current->payload + index * sizeof(Node));
+        }
+    }
+    return current;
+}
+
+template <typename T>
+T JsonTapeView::get(const JsonPathView& path, const T& default_value) const {
+    const Node* found = find(path);
+    if (!found) {
+        return default_value;
+    }
+
+    // 借用磁带数据构造临时 Value，读取规则与 JsonParam::get 完全相同
+    rapidjson::Value value;
+    switch (typeOf(*found)) {
+    case kTapeNull:
+        break;
+    case kTapeFalse:
+    case kTapeTrue:
+        value.SetBool(typeOf(*found) == kTapeTrue);
+        break;
+    case kTapeInt64:
+        value.SetInt64(static_cast<int64_t>(found->payload));
+        break;
+    case kTapeUint64:
+        value.SetUint64(found->payload);
+        break;
+    case kTapeDouble: {
+        double d;
+        std::memcpy(&d, &found->payload, sizeof(d));
+        value.SetDouble(d);
+        break;
+    }
+    case kTapeString: {
+        std::string_view str;
+        if (!stringOf(*found, str)) {
+            return default_value;
+        }
+        value.SetString(rapidjson::StringRef(str.data(), static_cast<rapidjson::SizeType>(str.size())));
+        break;
+    }
+    default:
+        return default_value;
+    }
+    return detail::readScalar(value, default_value);
+}
+
+template std::string JsonTapeView::get<std::string>(const JsonPathView&, const std::string&) const;
+template std::string_view JsonTapeView::get<std::string_view>(const JsonPathView&, const std::string_view&) const;
+template const char* JsonTapeView::get<const char*>(const JsonPathView&, const char* const&) const;
+template int JsonTapeView::get<int>(const JsonPathView&, const int&) const;
+template double JsonTapeView::get<double>(const JsonPathView&, const double&) const;
+template bool JsonTapeView::get<bool>(const JsonPathView&, const bool&) const;
+
+bool JsonTapeView::has(const JsonPathView& path) const {
+    return find(path) != nullptr;
+}
+
+template <typename Handler>
+bool JsonTapeView::emit(const Node& node, Handler& handler, size_t depth, size_t& budget) const {
+    if (budget == 0) {
+        return false;
+    }
+    --budget;
+    switch (typeOf(node)) {
+    case kTapeNull:
+        return handler.Null();
+    case kTapeFalse:
+        return handler.Bool(false);
+    case kTapeTrue:
+        return handler.Bool(true);
+    case kTapeInt64:
+        return handler.Int64(static_cast<int64_t>(node.payload));
+    case kTapeUint64:
+        return handler.Uint64(node.payload);
+    case kTapeDouble: {
+        double d;
+        std::memcpy(&d, &node.payload, sizeof(d));
+        return handler.Double(d);
+    }
+    case kTapeString: {
+        std::string_view str;
+        return stringOf(node, str) && handler.String(str.data(), static_cast<rapidjson::SizeType>(str.size()), false);
+    }
+    default:
+        break;
+    }
+
+    if (depth >= kMaxDepth) {
+        return false;
+    }
+    if (typeOf(node) == kTapeArray) {
+        if (!handler.StartArray()) {
+            return false;
+        }
+        for (uint64_t i = 0; i < node.count; ++i) {
+            const Node* element = this->node(node.payload + i * sizeof(Node));
+            if (!element || !emit(*element, handler, depth + 1, budget)) {
+                return false;
+            }
+        }
+        return handler.EndArray(node.count);
+    }
+    if (typeOf(node) == kTapeObject) {
+        if (!handler.StartObject()) {
+            return false;
+        }
+        for (uint64_t i = 0; i < node.count; ++i) {
+            const Node* name = this->node(node.payload + 2 * i * sizeof(Node));
+            const Node* value = this->node(node.payload + (2 * i + 1) * sizeof(Node));
+            std::string_view key;
+            if (!name || !value || !stringOf(*name, key) ||
+                !handler.Key(key.data(), static_cast<rapidjson::SizeType>(key.size()), false) ||
+                !emit(*value, handler, depth + 1, budget)) {
+                return false;
+            }
+        }
+        return handler.EndObject(node.count);
+    }
+    return false;
+}
+
+JsonParam JsonTapeView::toJsonParam(const JsonPathView& path) const {
+    const Node* start = find(path);
+    if (!start) {
+        return JsonParam();
+    }
+
+    JsonParam result;
+    result.doc_ = std::make_shared<rapidjson::Document>();
+    // 完好的磁带中每个节点只展开一次
+    size_t budget = (size_ - sizeof(TapeHeader)) / sizeof(Node);
+    bool ok = false;
+    auto generator = [&](rapidjson::Document& handler) {
+        ok = emit(*start, handler, 0, budget);
+        return ok;
+    };
+    result.doc_->Populate(generator);
+    if (!ok) {
+        return JsonParam();
+    }
+    // 字符串引用磁带数据，磁带随结果保留
+    result.anchors_.push_back(anchor_);
+    return result;
+}
+
+} // namespace json
+} // namespace cpputil
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace cpputil {
+namespace json {
+
+namespace detail {
+struct TapeNode;
+} // namespace detail
+
+// 磁带格式：JsonParam 的只读二进制快照，可以直接 mmap 后查询，无需解析。
+//
+// 文件由定长头部、节点区和字符串表组成，所有位置都是相对文件开头的偏移，
+// 与加载地址无关。每个节点 16 字节：类型、元素个数和一个 64 位载荷——
+// 标量直接存值，字符串指向字符串表（以 '\0' 结尾，相同内容只存一份），
+// 数组指向连续的 n 个子节点，对象指向连续的 n 对键/值节点；
+// 成员较多的对象在成员之后附带按键排序的下标，查找为二分。
+// 数值按本机字节序（小端）保存，字节序不同的文件会被拒绝。
+//
+// 打开只校验头部，耗时与文件大小无关；之后每次访问都检查偏移是否越界，
+// 损坏的文件只会让查询失败，不会越界读取
+class JsonTapeView {
+public:
+  // 把 json 编码为磁带格式，json 无效时返回空串
+  static std::string encode(const JsonParam &json);
+
+  // 编码并写入文件（覆盖写），失败时返回 false，不做输出
+  static bool writeFile(const JsonParam &json, const std::string &path);
+
+  // 只读 mmap 打开文件，映射随视图（及其拷贝）一起释放。
+  // 打开失败或格式不符时返回无效视图，原因见 error()，不做任何输出
+  static JsonTapeView open(const std::string &path);
+
+  // 接管内存中的磁带数据，例如从网络收到的；校验规则与输出同 open
+  explicit JsonTapeView(std::string tape);
+
+  JsonTapeView() = default;
+
+  bool isValid() const { return base_ != nullptr; }
+
+  // open 或构造失败的原因，如 "bad magic"、"size mismatch"（在 reason 中）；
+  // 有效视图与默认构造的视图 ok() 为 true
+  const JsonParseError &error() const { return error_; }
+
+  // 磁带数据的字节数
+  size_t size() const { return size_; }
+
+  // 读取规则与 JsonParam::get 相同，支持 std::string、std::string_view、
+  // const char*、int、double、bool；string_view 与 const char* 直接指向磁带数据
+  template <typename T>
+  T get(const JsonPathView &path, const T &default_value = T{}) const;
+
+  template <typename T>
+  T get(const JsonPath &path, const T &default_value = T{}) const {
+    return get<T>(JsonPathView(path), default_value);
+  }
+
+  template <typename T>
+  T get(std::initializer_list<JsonPathView::PathElement> path_elements,
+        const T &default_value = T{}) const {
+    return get<T>(JsonPathView(path_elements), default_value);
+  }
+
+  // 检查路径是否存在
+  bool has(const JsonPathView &path) const;
+  bool has(const JsonPath &path) const { return has(JsonPathView(path)); }
+  bool has(std::initializer_list<JsonPathView::PathElement> path_elements) const {
+    return has(JsonPathView(path_elements));
+  }
+
+  // 把 path 处的子树展开为可修改的 JsonParam，默认为整个文档；
+  // 与 get 一样，root() 以外的空路径什么也不选。
+  // 字符串不拷贝，继续引用磁带数据，磁带随结果一起保留。
+  // 路径不存在或节点区损坏时返回无效的 JsonParam，不做输出
+  JsonParam toJsonParam(const JsonPathView &path = JsonPathView::root()) const;
+
+private:
+  using Node = detail::TapeNode;
+
+  // 校验头部，失败时记录错误并保持无效
+  void attach(std::shared_ptr<const void> anchor, const char *data, size_t size);
+
+  // 记录失败原因，reason 为静态字符串
+  void fail(const char *reason);
+
+  // 返回 offset 处的节点，越界或未对齐时返回 nullptr
+  const Node *node(uint64_t offset) const;
+  const Node *root() const;
+  const Node *find(const JsonPathView &path) const;
+  const Node *findMember(const Node &object, std::string_view key) const;
+  bool stringOf(const Node &node, std::string_view &out) const;
+
+  // 按 SAX 事件展开 node。depth 超过上限或展开的节点数超过 budget 时失败，
+  // 防止损坏数据中的环或相互重叠的子节点区
+  template <typename Handler>
+  bool emit(const Node &node, Handler &handler, size_t depth, size_t &budget) const;
+
+  std::shared_ptr<const void> anchor_;
+  const char *base_ = nullptr;
+  size_t size_ = 0;
+  JsonParseError error_;
+};
+
+} // namespace json
+} // namespace cpputil
@@ -0,0 +1,227 @@
+#include "json.h"
+#include "json_stats_recorder.h"
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/writer.h>
+#include <cerrno>
+#include <unistd.h>
+
+namespace cpputil {
+namespace json {
+
+namespace {
+
+constexpr size_t kWriteBufferSize = 64 * 1024;
+
+// 追加写入 std::string 的输出流
+class StringAppendStream {
+public:
+    typedef char Ch;
+
+    explicit StringAppendStream(std::string& out) : out_(out) {}
+
+    void Put(char c) { out_.push_back(c); }
+    void Flush() {}
+
+    // 以下接口 Writer 不使用
+    char Peek() const { return '\0'; }
+    char Take() { return '\0'; }
+    size_t Tell() const { return 0; }
+    char* PutBegin() { return nullptr; }
+    size_t PutEnd(char*) { return 0; }
+
+private:
+    std::string& out_;
+};
+
+// 写入调用方定长缓冲区的输出流，放不下的部分只计数不写入
+class FixedBufferStream {
+public:
+    typedef char Ch;
+
+    FixedBufferStream(char* buffer, size_t capacity) : buffer_(buffer), capacity_(capacity), size_(0) {}
+
+    void Put(char c) {
+        if (size_ < capacity_) {
+            buffer_[size_] = c;
+        }
+        ++size_;
+    }
+    void Flush() {}
+
+    size_t size() const { return size_; }
+
+    // 以下接口 Writer 不使用
+    char Peek() const { return '\0'; }
+    char Take() { return '\0'; }
+    size_t Tell() const { return 0; }
+    char* PutBegin() { return nullptr; }
+    size_t PutEnd(char*) { return 0; }
+
+private:
+    char* buffer_;
+    size_t capacity_;
+    size_t size_;
+};
+
+// 攒满固定大小的块后交给 sink(data, size) 的缓冲输出流，满足 RapidJSON 的 Stream 概念。
+// sink 返回 false 后丢弃其余输出
+template <typename Sink>
+class ChunkedWriteStream {
+public:
+    typedef char Ch;
+
+    explicit ChunkedWriteStream(Sink sink) : sink_(std::move(sink)), size_(0), ok_(true) {}
+
+    void Put(char c) {
+        if (size_ == kWriteBufferSize) {
+            Flush();
+        }
+        buffer_[size_++] = c;
+    }
+
+    void Flush() {
+        if (ok_ && size_ > 0) {
+            ok_ = sink_(buffer_, size_);
+        }
+        size_ = 0;
+    }
+
+    bool ok() const { return ok_; }
+
+    // 以下接口 Writer 不使用
+    char Peek() const { return '\0'; }
+    char Take() { return '\0'; }
+    size_t Tell() const { return 0; }
+    char* PutBegin() { return nullptr; }
+    size_t PutEnd(char*) { return 0; }
+
+private:
+    Sink sink_;
+    char buffer_[kWriteBufferSize];
+    size_t size_;
+    bool ok_;
+};
+
+// indent 为 0 时输出紧凑格式，否则每层缩进 indent 个空格。
+// 遇到 NaN、Inf 等无法表示为 JSON 的值时 Writer 中途停止，返回 false，已输出的是不完整的片段
+template <typename Stream>
+bool writeValue(const rapidjson::Value& value, Stream& stream, unsigned indent) {
+    if (indent == 0) {
+        rapidjson::Writer<Stream> writer(stream);
+        return value.Accept(writer);
+    }
+    rapidjson::PrettyWriter<Stream> writer(stream);
+    writer.SetIndent(' ', indent);
+    return value.Accept(writer);
+}
+
+template <typename Sink>
+bool writeChunked(const rapidjson::Value& value, Sink sink, unsigned indent) {
+    // 64KB 缓冲区放在堆上，避免占用调用方栈空间
+    auto stream = std::make_unique<ChunkedWriteStream<Sink>>(std::move(sink));
+    bool complete = writeValue(value, *stream, indent);
+    stream->Flush();
+    return complete && stream->ok();
+}
+
+// 追加到 out，失败时把 out 恢复原样
+bool appendValue(const rapidjson::Value& value, std::string& out, unsigned indent) {
+    size_t size = out.size();
+    StringAppendStream stream(out);
+    if (!writeValue(value, stream, indent)) {
+        out.resize(size);
+        return false;
+    }
+    return true;
+}
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+std::string JsonParam::toString(unsigned indent) const {
+    stats::OpTimer timer(JsonOp::kToString);
+    std::string out;
+    timer.fail(!writeTo(out, indent));
+    return out;
+}
+
+std::string JsonParam::toString(const JsonPathView& path, unsigned indent) const {
+    stats::OpTimer timer(JsonOp::kToString);
+    std::string out;
+    timer.fail(!writeTo(out, path, indent));
+    return out;
+}
+
+std::string JsonParam::toString(const JsonPath& path, unsigned indent) const {
+    return toString(JsonPathView(path), indent);
+}
+
+std::string JsonParam::toString(std::initializer_list<JsonPathView::PathElement> path_elements,
+                                unsigned indent) const {
+    return toString(JsonPathView(path_elements), indent);
+}
+
+bool JsonParam::writeTo(int fd, unsigned indent) const {
+    if (!isValid()) {
+        return false;
+    }
+    return writeChunked(*doc_, [fd](const char* data, size_t size) { return writeAll(fd, data, size); }, indent);
+}
+
+bool JsonParam::writeTo(std::FILE* file, unsigned indent) const {
+    if (!isValid() || !file) {
+        return false;
+    }
+    return writeChunked(*doc_, [file](const char* data, size_t size) {
+        return std::fwrite(data, 1, size, file) == size;
+    }, indent);
+}
+
+bool JsonParam::writeTo(std::string& out, unsigned indent) const {
+    if (!isValid()) {
+        return false;
+    }
+    return appendValue(*doc_, out, indent);
+}
+
+bool JsonParam::writeTo(std::string& out, const JsonPathView& path, unsigned indent) const {
+    const rapidjson::Value* value = getValueByPath(path);
+    if (!value) {
+        return false;
+    }
+    return appendValue(*value, out, indent);
+}
+
+size_t JsonParam::writeTo(char* buffer, size_t capacity, unsigned indent) const {
+    if (!isValid()) {
+        return 0;
+    }
+    FixedBufferStream stream(buffer, capacity);
+    return writeValue(*doc_, stream, indent) ? stream.size() : 0;
+}
+
+bool JsonParam::writeTo(const ChunkSink& sink, unsigned indent) const {
+    if (!isValid() || !sink) {
+        return false;
+    }
+    return writeChunked(*doc_, [&sink](const char* data, size_t size) {
+        return sink(std::string_view(data, size));
+    }, indent);
+}
+
+} // namespace json
+} // namespace cpputil
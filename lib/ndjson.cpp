@@ -0,0 +1,345 @@
+#include "ndjson.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace cpputil {
+namespace json {
+
+namespace {
+
+// 每个任务块包含的记录数，工作线程按块领取任务
+constexpr size_t kChunkRecords = 256;
+
+// 回调模式下每个线程每批解析的记录数
+constexpr size_t kBatchRecordsPerThread = 4096;
+
+// 写出器缓冲区达到该大小后写出
+constexpr size_t kFlushBytes = 64 * 1024;
+
+size_t resolveThreads(size_t threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    return std::max<size_t>(threads, 1);
+}
+
+// 从 pos 开始切分至多 limit 条非空记录追加到 lines，返回下一次切分的起点
+size_t splitLines(std::string_view buffer, size_t pos, size_t limit, std::vector<std::string_view>& lines) {
+    const char* data = buffer.data();
+    size_t size = buffer.size();
+    size_t count = 0;
+    while (pos < size && count < limit) {
+        const void* newline = std::memchr(data + pos, '\n', size - pos);
+        size_t end = newline ? static_cast<size_t>(static_cast<const char*>(newline) - data) : size;
+        size_t next = newline ? end + 1 : size;
+        if (end > pos && data[end - 1] == '\r') {
+            --end;
+        }
+        if (end > pos) {
+            lines.emplace_back(data + pos, end - pos);
+            ++count;
+        }
+        pos = next;
+    }
+    return pos;
+}
+
+// 只读映射整个文件，析构时解除映射
+class ReadOnlyFile {
+public:
+    ReadOnlyFile() = default;
+    ~ReadOnlyFile() {
+        if (data_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+    }
+    ReadOnlyFile(const ReadOnlyFile&) = delete;
+    ReadOnlyFile& operator=(const ReadOnlyFile&) = delete;
+
+    bool open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        bool ok = ::fstat(fd, &st) == 0;
+        if (ok && st.st_size > 0) {
+            void* addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            ok = addr != MAP_FAILED;
+            if (ok) {
+                data_ = static_cast<const char*>(addr);
+                size_ = static_cast<size_t>(st.st_size);
+            }
+        }
+        int saved_errno = errno;
+        ::close(fd);
+        errno = saved_errno;
+        return ok;
+    }
+
+    std::string_view view() const { return std::string_view(data_, size_); }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+namespace detail {
+
+// threads - 1 个常驻线程加上调用线程一起执行任务。同一时刻只执行一个任务，
+// 线程池忙时 run 直接在调用线程上串行执行，不等待
+class NdjsonWorkerPool {
+public:
+    explicit NdjsonWorkerPool(size_t threads) : size_(threads) {}
+
+    ~NdjsonWorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& thread : workers_) {
+            thread.join();
+        }
+    }
+
+    NdjsonWorkerPool(const NdjsonWorkerPool&) = delete;
+    NdjsonWorkerPool& operator=(const NdjsonWorkerPool&) = delete;
+
+    // 并行执行 fn(chunk)，chunk 取值 [0, chunks)，全部完成后返回
+    void run(size_t chunks, const std::function<void(size_t)>& fn) {
+        std::unique_lock<std::mutex> busy(run_mutex_, std::try_to_lock);
+        if (size_ <= 1 || chunks <= 1 || !busy) {
+            for (size_t chunk = 0; chunk < chunks; ++chunk) {
+                fn(chunk);
+            }
+            return;
+        }
+        if (workers_.empty()) {
+            // 第一次并行执行时启动，此后常驻
+            workers_.reserve(size_ - 1);
+            for (size_t i = 1; i < size_; ++i) {
+                workers_.emplace_back([this] { loop(); });
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            fn_ = &fn;
+            chunks_ = chunks;
+            next_.store(0, std::memory_order_relaxed);
+            pending_ = workers_.size();
+            ++job_;
+        }
+        wake_.notify_all();
+        work(fn, chunks);
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return pending_ == 0; });
+        fn_ = nullptr;
+    }
+
+private:
+    void work(const std::function<void(size_t)>& fn, size_t chunks) {
+        for (size_t chunk = next_.fetch_add(1); chunk < chunks; chunk = next_.fetch_add(1)) {
+            fn(chunk);
+        }
+    }
+
+    void loop() {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [&] { return stop_ || job_ != seen; });
+            if (stop_) {
+                return;
+            }
+            seen = job_;
+            const std::function<void(size_t)>& fn = *fn_;
+            size_t chunks = chunks_;
+            lock.unlock();
+            work(fn, chunks);
+            lock.lock();
+            if (--pending_ == 0) {
+                done_.notify_one();
+            }
+        }
+    }
+
+    const size_t size_;
+    std::mutex run_mutex_; // 同一时刻只执行一个任务
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const std::function<void(size_t)>* fn_ = nullptr;
+    size_t chunks_ = 0;
+    std::atomic<size_t> next_{0};
+    size_t pending_ = 0; // 尚未完成当前任务的工作线程数
+    uint64_t job_ = 0;
+    bool stop_ = false;
+};
+
+} // namespace detail
+
+// ==================== NdjsonReader ====================
+
+NdjsonReader::NdjsonReader(size_t threads)
+    : threads_(resolveThreads(threads)), pool_(std::make_shared<detail::NdjsonWorkerPool>(threads_)) {}
+
+void NdjsonReader::parseLines(const std::vector<std::string_view>& lines,
+                              std::vector<JsonParam>& records) const {
+    size_t base = records.size();
+    records.resize(base + lines.size());
+    size_t chunks = (lines.size() + kChunkRecords - 1) / kChunkRecords;
+    pool_->run(chunks, [&](size_t chunk) {
+        size_t begin = chunk * kChunkRecords;
+        size_t end = std::min(begin + kChunkRecords, lines.size());
+        for (size_t i = begin; i < end; ++i) {
+            // 坏行多时逐行输出错误会让工作线程在 std::cerr 上串行化
+            records[base + i] = JsonParam::parse(lines[i]).value();
+        }
+    });
+}
+
+std::vector<JsonParam> NdjsonReader::parse(std::string_view buffer) const {
+    std::vector<std::string_view> lines;
+    splitLines(buffer, 0, buffer.size(), lines);
+    std::vector<JsonParam> records;
+    parseLines(lines, records);
+    return records;
+}
+
+void NdjsonReader::parse(std::string_view buffer, const Callback& callback) const {
+    size_t batch = threads_ * kBatchRecordsPerThread;
+    std::vector<std::string_view> lines;
+    std::vector<JsonParam> records;
+    size_t pos = 0;
+    while (pos < buffer.size()) {
+        lines.clear();
+        records.clear();
+        pos = splitLines(buffer, pos, batch, lines);
+        parseLines(lines, records);
+        for (auto& record : records) {
+            callback(std::move(record));
+        }
+    }
+}
+
+bool NdjsonReader::parseFile(const std::string& path, std::vector<JsonParam>& records) const {
+    ReadOnlyFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+    records = parse(file.view());
+    return true;
+}
+
+bool NdjsonReader::parseFile(const std::string& path, const Callback& callback) const {
+    ReadOnlyFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+    parse(file.view(), callback);
+    return true;
+}
+
+// ==================== NdjsonWriter ====================
+
+NdjsonWriter::NdjsonWriter(int fd, size_t threads)
+    : fd_(fd), pool_(std::make_shared<detail::NdjsonWorkerPool>(resolveThreads(threads))), ok_(true) {}
+
+NdjsonWriter::~NdjsonWriter() {
+    flush();
+}
+
+bool NdjsonWriter::write(const JsonParam& record) {
+    if (!record.writeTo(buffer_)) {
+        return false;
+    }
+    buffer_ += '\n';
+    if (buffer_.size() >= kFlushBytes) {
+        flush();
+    }
+    return ok_;
+}
+
+bool NdjsonWriter::write(const std::vector<JsonParam>& records) {
+    bool all_written = serializeTo(records, *pool_, buffer_);
+    if (buffer_.size() >= kFlushBytes) {
+        flush();
+    }
+    return all_written && ok_;
+}
+
+bool NdjsonWriter::flush() {
+    if (ok_ && !buffer_.empty()) {
+        ok_ = writeAll(fd_, buffer_.data(), buffer_.size());
+    }
+    buffer_.clear();
+    return ok_;
+}
+
+std::string NdjsonWriter::serialize(const std::vector<JsonParam>& records, size_t threads) {
+    detail::NdjsonWorkerPool pool(resolveThreads(threads));
+    std::string out;
+    serializeTo(records, pool, out);
+    return out;
+}
+
+bool NdjsonWriter::serializeTo(const std::vector<JsonParam>& records, detail::NdjsonWorkerPool& pool,
+                               std::string& out) {
+    size_t chunks = (records.size() + kChunkRecords - 1) / kChunkRecords;
+    std::vector<std::string> parts(chunks);
+    std::atomic<bool> all_written{true};
+    pool.run(chunks, [&](size_t chunk) {
+        size_t begin = chunk * kChunkRecords;
+        size_t end = std::min(begin + kChunkRecords, records.size());
+        std::string& part = parts[chunk];
+        for (size_t i = begin; i < end; ++i) {
+            if (records[i].writeTo(part)) {
+                part += '\n';
+            } else {
+                all_written.store(false, std::memory_order_relaxed);
+            }
+        }
+    });
+
+    size_t total = out.size();
+    for (const auto& part : parts) {
+        total += part.size();
+    }
+    out.reserve(total);
+    for (const auto& part : parts) {
+        out += part;
+    }
+    return all_written.load(std::memory_order_relaxed);
+}
+
+} // namespace json
+} // namespace cpputil
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "json.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cpputil {
+namespace json {
+
+namespace detail {
+// 常驻的工作线程，见 ndjson.cpp
+class NdjsonWorkerPool;
+} // namespace detail
+
+// NDJSON（JSON Lines）读取器：按 '\n' 切分记录（兼容 "\r\n"，跳过空行），
+// 由工作线程并行解析，结果始终按行序交付。无法解析的行对应一个无效的 JsonParam，
+// 不输出错误信息。
+// 工作线程在第一次并行解析时启动，此后常驻，随读取器（及其拷贝）一起销毁。
+// 多个线程同时使用同一个读取器时，线程池忙则在调用线程上串行解析
+class NdjsonReader {
+public:
+  using Callback = std::function<void(JsonParam &&record)>;
+
+  // threads 为 0 时使用 std::thread::hardware_concurrency()
+  explicit NdjsonReader(size_t threads = 0);
+
+  // 实际使用的线程数（含调用线程）
+  size_t threads() const { return threads_; }
+
+  // 一次解析整个缓冲区
+  std::vector<JsonParam> parse(std::string_view buffer) const;
+
+  // 分批并行解析，在调用线程上按行序逐条回调，内存占用只与批大小有关
+  void parse(std::string_view buffer, const Callback &callback) const;
+
+  // 读取文件（只读 mmap），打开或映射失败时返回 false，不做输出，errno 保留失败原因
+  bool parseFile(const std::string &path, std::vector<JsonParam> &records) const;
+  bool parseFile(const std::string &path, const Callback &callback) const;
+
+private:
+  // 并行解析 lines，结果按下标写入 records
+  void parseLines(const std::vector<std::string_view> &lines,
+                  std::vector<JsonParam> &records) const;
+
+  size_t threads_;
+  std::shared_ptr<detail::NdjsonWorkerPool> pool_;
+};
+
+// NDJSON 写出器：每条记录经 writeTo 直接追加到缓冲区，序列化为一行，攒满缓冲区后整块写出。
+// 批量写入时由写出器常驻的工作线程并行序列化，输出顺序与输入一致
+class NdjsonWriter {
+public:
+  // 写到已打开的文件描述符，不关闭 fd；threads 为 0 时使用硬件线程数
+  explicit NdjsonWriter(int fd, size_t threads = 0);
+
+  // 析构时写出缓冲区中剩余的数据
+  ~NdjsonWriter();
+
+  NdjsonWriter(const NdjsonWriter &) = delete;
+  NdjsonWriter &operator=(const NdjsonWriter &) = delete;
+
+  // 写入一条记录，无效或无法序列化（含 NaN、Inf）的记录被跳过并返回 false
+  bool write(const JsonParam &record);
+
+  // 批量写入，任一记录被跳过或写出失败时返回 false，其余记录照常写入
+  bool write(const std::vector<JsonParam> &records);
+
+  // 写出缓冲区
+  bool flush();
+
+  // 之前的写出是否全部成功
+  bool ok() const { return ok_; }
+
+  // 把 records 序列化为 NDJSON 文本，无效或无法序列化的记录被跳过。
+  // 一次性的调用，工作线程随调用启动和退出；反复批量序列化时用 write
+  static std::string serialize(const std::vector<JsonParam> &records,
+                               size_t threads = 0);
+
+private:
+  // 用 pool 并行序列化 records，追加到 out；有记录被跳过时返回 false
+  static bool serializeTo(const std::vector<JsonParam> &records,
+                          detail::NdjsonWorkerPool &pool, std::string &out);
+
+  int fd_;
+  std::shared_ptr<detail::NdjsonWorkerPool> pool_;
+  std::string buffer_;
+  bool ok_;
+};
+
+} // namespace json
+} // namespace cpputil
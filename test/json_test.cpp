@@ -1,9 +1,43 @@
 #include <gtest/gtest.h>
 #include "lib/json.h"
+#include "lib/json_path_cache.h"
+#include "lib/json_pool.h"
+#include "lib/json_snapshot.h"
+#include "lib/json_stats.h"
+#include "lib/json_struct.h"
+#include "lib/json_tape.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <map>
+#include <new>
+#include <optional>
+#include <thread>
+#include <unistd.h>
 #include <unordered_map>
 #include <vector>
 
+// 统计当前线程在计数期间经全局 operator new 申请内存的次数，用于检查 reset 的内存复用
+namespace {
+thread_local bool count_allocations = false;
+thread_local size_t allocation_count = 0;
+} // namespace
+
+void* operator new(size_t size) {
+    if (count_allocations) {
+        ++allocation_count;
+    }
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
 namespace cpputil {
 namespace json {
 namespace {
@@ -1127,4 +1161,1649 @@ TEST(JsonParamTest, CloneEmptyObject) {
     auto nonEmptyClone = original.clone({"nonEmptyObject"});
     EXPECT_TRUE(nonEmptyClone->isValid());
     EXPECT_EQ(nonEmptyClone->get({"key"}, std::string("")), "value");
-} 
\ No newline at end of file
+}
+
+// 测试写时复制：克隆共享未修改的子树，修改只对自身可见
+TEST(JsonParamTest, CloneSharesUnmodifiedSubtrees) {
+    std::string json = R"({
+        "config": {"name": "a fairly long string that is not inlined", "limits": [1, 2, 3]},
+        "user": {"name": "Alice", "tags": ["x"]}
+    })";
+    cpputil::json::JsonParam original(json);
+    auto cloned = original.clone();
+    
+    // 未修改的字符串指向同一份存储
+    std::string_view source_name = original.get({"config", "name"}, std::string_view());
+    EXPECT_EQ(cloned->get({"config", "name"}, std::string_view()).data(), source_name.data());
+    
+    cloned->set({"user", "name"}, std::string("Bob"));
+    cloned->set({"user", "tags", size_t(1)}, std::string("y"));
+    cloned->set({"config", "limits", size_t(0)}, 10);
+    EXPECT_EQ(original.toString(),
+              R"({"config":{"name":"a fairly long string that is not inlined","limits":[1,2,3]},)"
+              R"("user":{"name":"Alice","tags":["x"]}})");
+    EXPECT_EQ(cloned->toString(),
+              R"({"config":{"name":"a fairly long string that is not inlined","limits":[10,2,3]},)"
+              R"("user":{"name":"Bob","tags":["x","y"]}})");
+    // 写路径之外的节点仍然共享
+    EXPECT_EQ(cloned->get({"config", "name"}, std::string_view()).data(), source_name.data());
+    
+    // 来源的修改对克隆同样不可见
+    original.set({"user", "age"}, 30);
+    original.update(cpputil::json::JsonParam(R"({"user": {"tags": ["z"]}})"));
+    EXPECT_EQ(original.get({"user", "tags"}, std::vector<std::string>()), (std::vector<std::string>{"x", "z"}));
+    EXPECT_FALSE(cloned->has({"user", "age"}));
+    EXPECT_EQ(cloned->get({"user", "tags"}, std::vector<std::string>()), (std::vector<std::string>{"x", "y"}));
+    
+    // 拷贝构造同样共享，克隆链上的每一层互不影响
+    cpputil::json::JsonParam copy(*cloned);
+    auto second = cloned->clone();
+    cloned->set({"user", "name"}, std::string("Carol"));
+    copy.set({"user", "name"}, std::string("Dave"));
+    EXPECT_EQ(second->get({"user", "name"}, std::string()), "Bob");
+    EXPECT_EQ(copy.get({"user", "name"}, std::string()), "Dave");
+    EXPECT_EQ(cloned->get({"user", "name"}, std::string()), "Carol");
+    EXPECT_EQ(original.get({"user", "name"}, std::string()), "Alice");
+}
+
+// 测试克隆在来源析构或 reset 之后依然有效
+TEST(JsonParamTest, CloneOutlivesSource) {
+    cpputil::json::JsonParamPtr cloned;
+    cpputil::json::JsonParamPtr sub;
+    {
+        cpputil::json::JsonParam original(std::string(R"({"a": {"b": [1, 2, {"c": "value"}]}})"));
+        cloned = original.clone();
+        sub = original.clone({"a", "b", size_t(2)});
+        original.reset(R"({"other": true})");
+        EXPECT_EQ(original.toString(), R"({"other":true})");
+    }
+    EXPECT_EQ(cloned->toString(), R"({"a":{"b":[1,2,{"c":"value"}]}})");
+    EXPECT_EQ(sub->get({"c"}, std::string()), "value");
+    
+    // 来自 arena 的文档会被下一次 reset 回收，克隆退化为深拷贝
+    cpputil::json::JsonParam pooled;
+    pooled.reset(R"({"k": [1, 2, 3]})");
+    auto deep = pooled.clone();
+    pooled.reset(R"({"k": [4]})");
+    EXPECT_EQ(deep->get({"k"}, std::vector<int>()), (std::vector<int>{1, 2, 3}));
+}
+TEST(JsonParamTest, JsonPathViewInlineAndOverflow) {
+    cpputil::json::JsonPathView path = {"a", size_t(1), "b"};
+    EXPECT_EQ(path.size(), 3);
+    EXPECT_EQ(std::get<std::string_view>(path[0]), "a");
+    EXPECT_EQ(std::get<size_t>(path[1]), 1);
+
+    // 超出内联容量后元素顺序保持不变
+    cpputil::json::JsonPathView long_path;
+    for (size_t i = 0; i < cpputil::json::JsonPathView::kInlineCapacity + 3; ++i) {
+        long_path.add(i);
+    }
+    EXPECT_EQ(long_path.size(), cpputil::json::JsonPathView::kInlineCapacity + 3);
+    size_t expected = 0;
+    for (const auto& element : long_path) {
+        EXPECT_EQ(std::get<size_t>(element), expected++);
+    }
+
+    // 从 JsonPath 构造视图
+    cpputil::json::JsonPath owned = {"user", size_t(0)};
+    cpputil::json::JsonPathView view(owned);
+    EXPECT_EQ(view.size(), 2);
+    EXPECT_EQ(std::get<std::string_view>(view[0]), "user");
+}
+
+TEST(JsonParamTest, JsonPathViewAccess) {
+    cpputil::json::JsonParam js(R"({"user": {"name": "Alice", "scores": [90, 85]}})");
+
+    // key 可以是不以 '\0' 结尾的子串
+    std::string keys = "user.name";
+    std::string_view user = std::string_view(keys).substr(0, 4);
+    std::string_view name = std::string_view(keys).substr(5);
+
+    cpputil::json::JsonPathView path = {user, name};
+    EXPECT_EQ(js.get(path, std::string("")), "Alice");
+    EXPECT_TRUE(js.has(path));
+    EXPECT_TRUE(js.has({user, "scores", size_t(1)}));
+    EXPECT_FALSE(js.has({user, "missing"}));
+    EXPECT_EQ(js.get({user, "scores", size_t(1)}, 0), 85);
+
+    std::string city_key = "city";
+    EXPECT_TRUE(js.set({user, std::string_view(city_key)}, std::string("Paris")));
+    EXPECT_EQ(js.get({"user", "city"}, std::string("")), "Paris");
+
+    auto user_clone = js.clone(cpputil::json::JsonPathView{user});
+    EXPECT_TRUE(user_clone->isValid());
+    EXPECT_EQ(user_clone->get({"city"}, std::string("")), "Paris");
+}
+
+TEST(JsonParamTest, MemberIndexLookup) {
+    cpputil::json::JsonParam js(R"({"tenants": {}})");
+    js.enableMemberIndex(16);
+
+    // 逐个追加成员，跨过阈值并触发成员数组多次搬迁
+    for (int i = 0; i < 300; ++i) {
+        EXPECT_TRUE(js.set({"tenants", "t" + std::to_string(i)}, i));
+    }
+    for (int i = 0; i < 300; ++i) {
+        EXPECT_EQ(js.get({"tenants", "t" + std::to_string(i)}, -1), i);
+    }
+    EXPECT_FALSE(js.has({"tenants", "t300"}));
+
+    // 覆盖已有成员不会产生重复 key
+    EXPECT_TRUE(js.set({"tenants", "t42"}, 4200));
+    EXPECT_EQ(js.get({"tenants", "t42"}, -1), 4200);
+    EXPECT_EQ(js.get({"tenants"}, std::map<std::string, int>{}).size(), 300);
+
+    // update 同样走索引
+    cpputil::json::JsonParam overlay(R"({"tenants": {"t7": 70, "t500": 500}})");
+    EXPECT_TRUE(js.update(overlay));
+    EXPECT_EQ(js.get({"tenants", "t7"}, -1), 70);
+    EXPECT_EQ(js.get({"tenants", "t500"}, -1), 500);
+
+    // 拷贝保留索引设置，结果与关闭索引一致
+    cpputil::json::JsonParam copy(js);
+    copy.disableMemberIndex();
+    EXPECT_EQ(copy.get({"tenants", "t299"}, -1), 299);
+    EXPECT_EQ(copy.toString(), js.toString());
+}
+
+TEST(JsonParamTest, MemberIndexAcrossRewrites) {
+    std::string wide = "{";
+    for (int i = 0; i < 100; ++i) {
+        wide += (i ? ", \"k" : "\"k") + std::to_string(i) + "\": " + std::to_string(i);
+    }
+    wide += "}";
+    cpputil::json::JsonParam js(R"({"a": )" + wide + R"(, "b": )" + wide + "}");
+    js.enableMemberIndex(16);
+
+    // 写时复制换了成员数组后，两边的索引各自有效
+    auto copy = js.clone();
+    EXPECT_TRUE(copy->set({"a", "k5"}, 500));
+    EXPECT_TRUE(copy->set({"a", "new"}, 1));
+    EXPECT_EQ(copy->get({"a", "k5"}, -1), 500);
+    EXPECT_EQ(copy->get({"a", "k99"}, -1), 99);
+    EXPECT_EQ(js.get({"a", "k5"}, -1), 5);
+    EXPECT_FALSE(js.has({"a", "new"}));
+
+    // 整体覆盖后旧索引作废，新对象按新内容查找
+    EXPECT_TRUE(js.set({"a"}, std::map<std::string, int>{{"k5", 50}}));
+    EXPECT_EQ(js.get({"a", "k5"}, -1), 50);
+    EXPECT_FALSE(js.has({"a", "k6"}));
+    EXPECT_TRUE(js.set({"b"}, 1));
+    EXPECT_EQ(js.get({"b"}, 0), 1);
+
+    // 移入的大对象补建索引前后结果一致
+    EXPECT_TRUE(js.update(cpputil::json::JsonParam(R"({"c": )" + wide + "}")));
+    EXPECT_EQ(js.get({"c", "k77"}, -1), 77);
+    js.refreshMemberIndex();
+    EXPECT_EQ(js.get({"c", "k77"}, -1), 77);
+
+    // 无效对象 update 时直接采用来源的文档，自己的索引设置保持不变
+    cpputil::json::JsonParam moved_into;
+    moved_into.enableMemberIndex(16);
+    EXPECT_TRUE(moved_into.update(cpputil::json::JsonParam(wide)));
+    EXPECT_TRUE(moved_into.memberIndexEnabled());
+    EXPECT_EQ(moved_into.get({"k42"}, -1), 42);
+    cpputil::json::JsonParam copied_into;
+    copied_into.enableMemberIndex(16);
+    EXPECT_TRUE(copied_into.update(moved_into));
+    EXPECT_TRUE(copied_into.memberIndexEnabled());
+    EXPECT_EQ(copied_into.get({"k42"}, -1), 42);
+    cpputil::json::JsonParam plain;
+    EXPECT_TRUE(plain.update(js));
+    EXPECT_FALSE(plain.memberIndexEnabled());
+
+    // 只读查找可以在多个线程上并发
+    std::vector<std::thread> readers;
+    std::atomic<int> mismatches{0};
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&] {
+            for (int i = 0; i < 1000; ++i) {
+                if (js.get({"c", "k" + std::to_string(i % 100)}, -1) != i % 100) {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(mismatches.load(), 0);
+}
+
+TEST(JsonParamTest, ParseFromRange) {
+    // 只解析前半段，后面的内容不应被读取
+    std::string text = R"({"a": 1, "b": "x"}garbage)";
+    cpputil::json::JsonParam js(text.data(), text.size() - 7);
+    EXPECT_TRUE(js.isValid());
+    EXPECT_EQ(js.get({"a"}, 0), 1);
+
+    cpputil::json::JsonParam from_view(std::string_view(text).substr(0, text.size() - 7));
+    EXPECT_TRUE(from_view.isValid());
+    EXPECT_EQ(from_view.get({"b"}, std::string("")), "x");
+
+    cpputil::json::JsonParam whole(std::string_view{text});
+    EXPECT_FALSE(whole.isValid());
+}
+
+TEST(JsonParamTest, ParseInsituOwnsBuffer) {
+    std::string text = R"({"name": "Al\"ice", "tags": ["a", "b"], "n": 3})";
+    cpputil::json::JsonParam js = cpputil::json::JsonParam::parseInsitu(std::move(text)).value();
+    EXPECT_TRUE(js.isValid());
+    EXPECT_EQ(js.memoryUsage().anchors, 1u);
+    EXPECT_EQ(js.get({"name"}, std::string("")), "Al\"ice");
+    EXPECT_EQ(js.get({"tags"}, std::vector<std::string>{}), std::vector<std::string>({"a", "b"}));
+
+    std::unique_ptr<char[]> buffer(new char[32]);
+    std::strcpy(buffer.get(), R"({"k": "v"})");
+    cpputil::json::JsonParam from_buffer(std::move(buffer));
+    EXPECT_EQ(from_buffer.get({"k"}, std::string("")), "v");
+
+    cpputil::json::JsonParam invalid = cpputil::json::JsonParam::parseInsitu("{not json").value();
+    EXPECT_FALSE(invalid.isValid());
+
+    // 临时字符串按常规方式拷贝，不保留输入缓冲区
+    cpputil::json::JsonParam copied(std::string(R"({"k": "v"})"));
+    EXPECT_EQ(copied.get({"k"}, std::string("")), "v");
+    EXPECT_EQ(copied.memoryUsage().anchors, 0u);
+}
+
+TEST(JsonParamTest, ParseInsituCopiesOutliveSource) {
+    cpputil::json::JsonParamPtr cloned;
+    cpputil::json::JsonParamPtr sub;
+    cpputil::json::JsonParam merged(R"({"base": true})");
+    {
+        cpputil::json::JsonParam source =
+            cpputil::json::JsonParam::parseInsitu(R"({"user": {"name": "Alice"}, "city": "Paris"})").value();
+        cloned = source.clone();
+        sub = source.clone({"user"});
+        EXPECT_TRUE(merged.update(source));
+    }
+    // 原地解析的缓冲区由拷贝继续持有
+    EXPECT_EQ(cloned->get({"user", "name"}, std::string("")), "Alice");
+    EXPECT_EQ(sub->get({"name"}, std::string("")), "Alice");
+    EXPECT_EQ(merged.get({"city"}, std::string("")), "Paris");
+    EXPECT_EQ(merged.toString(), R"({"base":true,"user":{"name":"Alice"},"city":"Paris"})");
+}
+
+TEST(JsonParamTest, ParseKernelsAgree) {
+    using cpputil::json::ParseKernel;
+    // 大段空白和长字符串让 SIMD 内核走到按 16 字节扫描的分支
+    std::string text = "{\n";
+    for (int i = 0; i < 64; ++i) {
+        text += "                                \"key" + std::to_string(i) + "\" :\t\r\n  ";
+        text += "\"" + std::string(static_cast<size_t>(i) * 7, 'x') + "\\n\\u00e9\\\"tail\",\n";
+    }
+    text += "    \"numbers\": [ 1 , -2 , 3.5 , 1e3 ]\n}\n      ";
+
+    ParseKernel original = cpputil::json::parseKernel();
+    ASSERT_TRUE(cpputil::json::setParseKernel(ParseKernel::kScalar));
+    std::string expected = cpputil::json::JsonParam(text).toString();
+    ASSERT_FALSE(expected.empty());
+
+    for (ParseKernel kernel : {ParseKernel::kScalar, ParseKernel::kSse2, ParseKernel::kSse42}) {
+        if (!cpputil::json::setParseKernel(kernel)) {
+            continue;
+        }
+        EXPECT_EQ(cpputil::json::parseKernel(), kernel);
+        EXPECT_EQ(cpputil::json::JsonParam(text).toString(), expected);
+        EXPECT_EQ(cpputil::json::JsonParam(text.c_str()).toString(), expected);
+        EXPECT_EQ(cpputil::json::JsonParam::parseInsitu(text).value().toString(), expected);
+        EXPECT_FALSE(cpputil::json::JsonParam::parseInsitu("{\"a\":   }").ok());
+        EXPECT_FALSE(cpputil::json::JsonParam("   ").isValid());
+    }
+    cpputil::json::setParseKernel(original);
+}
+
+TEST(JsonParamTest, BinaryRoundTrip) {
+    cpputil::json::JsonParam js(R"({
+        "null": null, "t": true, "f": false,
+        "ints": [0, 23, 24, 255, 256, 65535, 65536, 4294967295, 4294967296, 18446744073709551615,
+                 -1, -24, -25, -33, -129, -32769, -2147483648, -2147483649, -9223372036854775808],
+        "doubles": [0.5, -1.25, 0.1, 1e300, 3.0],
+        "text": "héllo \"world\"", "long": "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx",
+        "nested": {"a": [{"b": []}, {}], "": "empty key"}
+    })");
+    ASSERT_TRUE(js.isValid());
+
+    std::string cbor = js.toCbor();
+    std::string msgpack = js.toMsgPack();
+    EXPECT_LT(cbor.size(), js.toString().size());
+    EXPECT_LT(msgpack.size(), js.toString().size());
+
+    for (const auto& decoded : {cpputil::json::JsonParam::fromCbor(cbor).value(),
+                                cpputil::json::JsonParam::fromMsgPack(msgpack).value()}) {
+        ASSERT_TRUE(decoded.isValid());
+        EXPECT_EQ(decoded.toString(), js.toString());
+        EXPECT_EQ(decoded.toString({"ints", size_t(9)}), "18446744073709551615");
+        EXPECT_EQ(decoded.toString({"ints", size_t(18)}), "-9223372036854775808");
+        EXPECT_EQ(decoded.get({"doubles", size_t(2)}, 0.0), 0.1);
+        EXPECT_EQ(decoded.get({"text"}, std::string()), "h\xc3\xa9llo \"world\"");
+    }
+
+    // 追加到已有内容之后；无效文档不输出
+    std::string out = "prefix";
+    EXPECT_TRUE(js.toCbor(out));
+    EXPECT_EQ(out, "prefix" + cbor);
+    cpputil::json::JsonParam invalid;
+    EXPECT_EQ(invalid.toCbor(), "");
+    EXPECT_FALSE(invalid.toMsgPack(out));
+}
+
+TEST(JsonParamTest, BinaryWireFormat) {
+    using cpputil::json::JsonParam;
+    // RFC 8949 附录 A 与 MessagePack 规范中的编码
+    EXPECT_EQ(JsonParam(R"([0, 100, -1, -1000, 1.5, "a", true, null])").toCbor(),
+              std::string("\x88\x00\x18\x64\x20\x39\x03\xe7\xfa\x3f\xc0\x00\x00\x61\x61\xf5\xf6", 17));
+    EXPECT_EQ(JsonParam(R"({"a": 1, "b": [2, 3]})").toCbor(), std::string("\xa2\x61\x61\x01\x61\x62\x82\x02\x03", 9));
+    EXPECT_EQ(JsonParam(R"({"a": [1, -1, 200, -200, 1.5], "b": null})").toMsgPack(),
+              std::string("\x82\xa1\x61\x95\x01\xff\xcc\xc8\xd1\xff\x38\xca\x3f\xc0\x00\x00\xa1\x62\xc0", 19));
+
+    // 其他编码器可能产生的形式：半精度浮点、标签、不定长数组/映射/文本串
+    JsonParam cbor = JsonParam::fromCbor(
+        std::string("\xbf\x61\x68\xf9\x3c\x00\x61\x74\xc1\x1a\x00\x01\x00\x00"
+                    "\x7f\x61\x6b\xff\x9f\x01\x7f\x62\x61\x62\x61\x63\xff\xf7\xff\xff", 30)).value();
+    ASSERT_TRUE(cbor.isValid());
+    EXPECT_EQ(cbor.toString(), R"({"h":1.0,"t":65536,"k":[1,"abc",null]})");
+    EXPECT_EQ(JsonParam::fromMsgPack(std::string("\xd9\x03xyz", 5)).value().toString(), R"("xyz")");
+
+    // 截断、多余字节、字节串、非字符串键、NaN 和过深的嵌套都被拒绝
+    EXPECT_FALSE(JsonParam::fromCbor(std::string("\x82\x01", 2)).ok());
+    EXPECT_FALSE(JsonParam::fromCbor(std::string("\x01\x02", 2)).ok());
+    EXPECT_FALSE(JsonParam::fromCbor(std::string("\x41\x00", 2)).ok());
+    EXPECT_FALSE(JsonParam::fromCbor(std::string("\xa1\x01\x02", 3)).ok());
+    EXPECT_FALSE(JsonParam::fromCbor(std::string("\xf9\x7e\x00", 3)).ok());
+    EXPECT_FALSE(JsonParam::fromCbor(std::string()).ok());
+    EXPECT_FALSE(JsonParam::fromMsgPack(std::string("\xc4\x01\x00", 3)).ok());
+    EXPECT_FALSE(JsonParam::fromMsgPack(std::string("\x81\x01\x02", 3)).ok());
+    EXPECT_FALSE(JsonParam::fromMsgPack(std::string("\xdd\xff\xff\xff\xff", 5)).ok());
+    EXPECT_FALSE(JsonParam::fromCbor(std::string(100000, '\x81')).ok());
+    EXPECT_FALSE(JsonParam::fromMsgPack(std::string(100000, '\x91')).ok());
+
+    // 失败时不输出，错误带原因和偏移，文档无效
+    testing::internal::CaptureStderr();
+    auto truncated = JsonParam::fromCbor(std::string("\x82\x01", 2));
+    auto trailing = JsonParam::fromMsgPack(std::string("\x01\x02", 2));
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "");
+    EXPECT_FALSE(truncated.value().isValid());
+    EXPECT_STREQ(truncated.error().reason, "unexpected end of data");
+    EXPECT_EQ(truncated.error().offset, 2u);
+    EXPECT_EQ(truncated.error().message(), "unexpected end of data at offset 2");
+    EXPECT_STREQ(trailing.error().reason, "trailing bytes after value");
+    EXPECT_EQ(trailing.error().offset, 1u);
+    EXPECT_EQ(JsonParam::fromCbor(std::string("\x01", 1)).error().reason, nullptr);
+}
+
+TEST(JsonParamTest, TapeRoundTrip) {
+    using cpputil::json::JsonParam;
+    using cpputil::json::JsonTapeView;
+    std::string json = R"({"name": "tape", "n": -7, "big": 18446744073709551615, "pi": 3.25, "ok": true,)"
+                       R"( "none": null, "list": [1, "x", {"k": "x"}, []], "dup": "x", "wide": {)";
+    for (int i = 0; i < 40; ++i) {
+        json += (i ? ", " : "") + ("\"k" + std::to_string(39 - i) + "\": ") + std::to_string(i);
+    }
+    json += R"(, "k5": -1}})";
+    JsonParam js(json);
+    ASSERT_TRUE(js.isValid());
+
+    std::string path = ::testing::TempDir() + "json_tape_round_trip.tape";
+    ASSERT_TRUE(JsonTapeView::writeFile(js, path));
+    for (const JsonTapeView& tape : {JsonTapeView(JsonTapeView::encode(js)), JsonTapeView::open(path)}) {
+        ASSERT_TRUE(tape.isValid());
+        EXPECT_EQ(tape.get({"name"}, std::string()), "tape");
+        EXPECT_EQ(tape.get({"n"}, 0), -7);
+        EXPECT_EQ(tape.get({"pi"}, 0.0), 3.25);
+        EXPECT_TRUE(tape.get({"ok"}, false));
+        EXPECT_EQ(tape.get({"list", size_t(1)}, std::string_view()), "x");
+        EXPECT_STREQ(tape.get({"list", size_t(2), "k"}, static_cast<const char*>("")), "x");
+        // 成员较多的对象走排序下标，重复的键与 JsonParam 一样命中第一个
+        EXPECT_EQ(tape.get({"wide", "k0"}, -1), 39);
+        EXPECT_EQ(tape.get({"wide", "k39"}, -1), 0);
+        EXPECT_EQ(tape.get({"wide", "k5"}, -1), js.get({"wide", "k5"}, -1));
+        EXPECT_FALSE(tape.has({"wide", "k40"}));
+        EXPECT_TRUE(tape.has({"none"}));
+        EXPECT_FALSE(tape.has({"list", size_t(4)}));
+        EXPECT_EQ(tape.get({"name", "x"}, 5), 5);
+        EXPECT_EQ(tape.get({"list"}, 5), 5);
+
+        // 展开后与原文档完全相同，整数类型也一致
+        JsonParam full = tape.toJsonParam();
+        EXPECT_EQ(full.toString(), js.toString());
+        EXPECT_EQ(full.toCbor(), js.toCbor());
+        EXPECT_EQ(tape.toJsonParam({"list", size_t(2)}).toString(), R"({"k":"x"})");
+        EXPECT_FALSE(tape.toJsonParam({"missing"}).isValid());
+        EXPECT_FALSE(tape.toJsonParam({}).isValid());
+    }
+
+    // 展开结果持有磁带，视图释放后仍可使用
+    JsonParam detached = JsonTapeView::open(path).toJsonParam({"list"});
+    detached.set({size_t(0)}, 10);
+    EXPECT_EQ(detached.toString(), R"([10,"x",{"k":"x"},[]])");
+}
+
+TEST(JsonParamTest, TapeRejectsCorruptData) {
+    using cpputil::json::JsonParam;
+    using cpputil::json::JsonTapeView;
+    std::string tape = JsonTapeView::encode(JsonParam(R"({"a": [1, 2, {"b": "c"}]})"));
+    ASSERT_FALSE(tape.empty());
+    EXPECT_TRUE(JsonTapeView::encode(JsonParam()).empty());
+
+    // 头部错误：截断、魔数、长度不符。原因在 error() 中，不做任何输出
+    ::testing::internal::CaptureStderr();
+    EXPECT_TRUE(JsonTapeView(tape).error().ok());
+    JsonTapeView truncated(tape.substr(0, 16));
+    EXPECT_FALSE(truncated.isValid());
+    EXPECT_STREQ(truncated.error().reason, "truncated header");
+    JsonTapeView short_data(tape.substr(0, tape.size() - 1));
+    EXPECT_FALSE(short_data.isValid());
+    EXPECT_STREQ(short_data.error().reason, "size mismatch");
+    std::string bad_magic = tape;
+    bad_magic[0] = 'X';
+    EXPECT_FALSE(JsonTapeView(bad_magic).isValid());
+    EXPECT_EQ(JsonTapeView(bad_magic).error().message(), "bad magic at offset 0");
+    JsonTapeView missing = JsonTapeView::open(::testing::TempDir() + "json_tape_missing.tape");
+    EXPECT_FALSE(missing.isValid());
+    EXPECT_FALSE(missing.error().ok());
+
+    // 节点区的任意字节被破坏都不会越界读取，只会让查询或展开失败
+    for (size_t i = 32; i < tape.size(); ++i) {
+        for (char byte : {'\x00', '\x7f', '\xff'}) {
+            std::string corrupt = tape;
+            corrupt[i] = byte;
+            JsonTapeView view(corrupt);
+            ASSERT_TRUE(view.isValid());
+            view.get({"a", size_t(2), "b"}, std::string());
+            view.has({"a", size_t(1)});
+            view.toJsonParam();
+        }
+    }
+    EXPECT_EQ(::testing::internal::GetCapturedStderr(), "");
+}
+
+TEST(JsonParamTest, OperationStats) {
+    using cpputil::json::JsonOp;
+    using cpputil::json::JsonParam;
+    cpputil::json::resetStats();
+
+    JsonParam js(R"({"a": {"b": 1}})");
+    JsonParam broken("{");
+    js.get({"a", "b"}, 0);
+    js.get({"a", "missing"}, 0);
+    js.has({"a"});
+    js.set({"c", "d", size_t(2)}, 5);
+    js.update(JsonParam(R"({"e": 1})"));
+    js.clone();
+    js.toString();
+    // 其他线程的计数在线程退出后仍然计入
+    std::thread([&] { js.get({"a", "b"}, 0); }).join();
+
+    cpputil::json::JsonStats stats = cpputil::json::statsSnapshot();
+    if (!cpputil::json::statsCompiledIn()) {
+        EXPECT_FALSE(cpputil::json::statsEnabled());
+        EXPECT_EQ(stats[JsonOp::kGet].calls, 0u);
+        return;
+    }
+    EXPECT_EQ(stats[JsonOp::kParse].calls, 3u);
+    EXPECT_EQ(stats[JsonOp::kParse].failures, 1u);
+    EXPECT_EQ(stats[JsonOp::kGet].calls, 3u);
+    EXPECT_EQ(stats[JsonOp::kGet].failures, 1u);
+    EXPECT_EQ(stats[JsonOp::kHas].calls, 1u);
+    EXPECT_EQ(stats[JsonOp::kSet].calls, 1u);
+    EXPECT_EQ(stats[JsonOp::kUpdate].calls, 1u);
+    EXPECT_EQ(stats[JsonOp::kClone].calls, 1u);
+    EXPECT_EQ(stats[JsonOp::kToString].calls, 1u);
+    // "c"、"d" 两个成员和一次数组扩展
+    EXPECT_EQ(stats.created_paths, 3u);
+    EXPECT_EQ(stats[JsonOp::kGet].latency.count(), 3u);
+    EXPECT_GE(stats[JsonOp::kGet].latency.percentileNanos(0.99),
+              stats[JsonOp::kGet].latency.percentileNanos(0.5));
+
+    std::map<std::string, uint64_t> exported;
+    stats.forEach([&](std::string_view name, uint64_t value) { exported[std::string(name)] = value; });
+    EXPECT_EQ(exported["get.calls"], 3u);
+    EXPECT_EQ(exported["to_string.calls"], 1u);
+    EXPECT_EQ(exported["created_paths"], 3u);
+
+    // 暂停期间不记录，reset 之后从零开始
+    cpputil::json::setStatsEnabled(false);
+    js.get({"a", "b"}, 0);
+    cpputil::json::setStatsEnabled(true);
+    EXPECT_EQ(cpputil::json::statsSnapshot()[JsonOp::kGet].calls, 3u);
+    cpputil::json::resetStats();
+    EXPECT_EQ(cpputil::json::statsSnapshot()[JsonOp::kGet].calls, 0u);
+
+    // 采样时计数仍然精确，只有部分调用进入直方图
+    cpputil::json::setStatsLatencySampling(4);
+    for (int i = 0; i < 40; ++i) {
+        js.has({"a"});
+    }
+    cpputil::json::setStatsLatencySampling(1);
+    stats = cpputil::json::statsSnapshot();
+    EXPECT_EQ(stats[JsonOp::kHas].calls, 40u);
+    EXPECT_GE(stats[JsonOp::kHas].latency.count(), 9u);
+    EXPECT_LE(stats[JsonOp::kHas].latency.count(), 11u);
+}
+
+// 测试数值数组的批量转换与混合类型的回退结果一致
+TEST(JsonParamTest, GetNumericVector) {
+    cpputil::json::JsonParam js(R"({"d": [1.5, 2, -3.25], "i": [1, 2, 3], "mixed": [1, 2.5, "x", true, 4]})");
+    EXPECT_EQ(js.get({"d"}, std::vector<double>()), (std::vector<double>{1.5, 2, -3.25}));
+    EXPECT_EQ(js.get({"i"}, std::vector<int>()), (std::vector<int>{1, 2, 3}));
+    // 批量转换在 "x" 处失败，逐元素路径把无法转换的元素置为默认值
+    EXPECT_EQ(js.get({"mixed"}, std::vector<double>()), (std::vector<double>{1, 2.5, 0, 0, 4}));
+    EXPECT_EQ(js.get({"mixed"}, std::vector<int>()), (std::vector<int>{1, 0, 0, 0, 4}));
+}
+
+TEST(JsonParamTest, MemoryUsage) {
+    using cpputil::json::JsonParam;
+    std::string big(4096, 'x');
+    JsonParam js(R"({"big": [")" + big + R"(", ")" + big + R"("], "small": 1, "a/b~c": {"k": "v"}})");
+    JsonParam::MemoryUsage usage = js.memoryUsage();
+    EXPECT_GE(usage.live, 2 * big.size());
+    EXPECT_GE(usage.capacity, usage.used);
+    EXPECT_EQ(JsonParam().memoryUsage().capacity, 0u);
+
+    // 覆盖写入的旧字符串留在分配器中，计入 wasted
+    for (int i = 0; i < 8; ++i) {
+        js.set({"small"}, big);
+    }
+    usage = js.memoryUsage();
+    ASSERT_TRUE(usage.wasted.has_value());
+    EXPECT_GE(*usage.wasted, 4 * big.size());
+    EXPECT_GE(usage.used, usage.live);
+
+    // 与来源共享的子树计入 live，却不在克隆的分配器中，无法估计 wasted；
+    // 来源自己的存储都在自己的分配器中，不受影响
+    auto copy = js.clone();
+    JsonParam::MemoryUsage copied = copy->memoryUsage();
+    EXPECT_EQ(copied.live, usage.live);
+    EXPECT_FALSE(copied.wasted.has_value());
+    EXPECT_EQ(js.memoryUsage().wasted, usage.wasted);
+
+    // 原地解析的字符串在输入缓冲区中，同样无法估计
+    JsonParam insitu = JsonParam::parseInsitu(R"({"s": ")" + big + R"("})").value();
+    EXPECT_GE(insitu.memoryUsage().live, big.size());
+    EXPECT_FALSE(insitu.memoryUsage().wasted.has_value());
+
+    std::vector<JsonParam::MemoryEntry> entries = js.memoryBreakdown();
+    ASSERT_EQ(entries.size(), 4u);
+    EXPECT_EQ(entries[0].path, "");
+    EXPECT_EQ(entries[0].values, 7u);
+    EXPECT_EQ(entries[1].path, "/big");
+    EXPECT_EQ(entries[1].values, 3u);
+    EXPECT_EQ(entries[2].path, "/small");
+    EXPECT_EQ(entries[3].path, "/a~1b~0c");
+    EXPECT_GT(entries[0].bytes, entries[1].bytes + entries[2].bytes + entries[3].bytes - 1);
+
+    entries = js.memoryBreakdown(2, {"big"});
+    ASSERT_EQ(entries.size(), 3u);
+    EXPECT_EQ(entries[0].path, "/big");
+    EXPECT_EQ(entries[1].path, "/big/0");
+    EXPECT_EQ(entries[2].path, "/big/1");
+    EXPECT_EQ(js.memoryBreakdown(0).size(), 1u);
+    EXPECT_TRUE(js.memoryBreakdown(1, {"missing"}).empty());
+    EXPECT_TRUE(js.memoryBreakdown(1, {}).empty());
+    EXPECT_TRUE(JsonParam().memoryBreakdown().empty());
+}
+
+TEST(JsonParamTest, ParseWithoutOutput) {
+    using cpputil::json::JsonParam;
+    using cpputil::json::JsonParseResult;
+    ::testing::internal::CaptureStderr();
+    JsonParseResult bad = JsonParam::parse(std::string_view(R"({"a": 1,})"));
+    JsonParseResult empty = JsonParam::parse("");
+    JsonParseResult insitu = JsonParam::parseInsitu("[1, 2");
+    JsonParseResult good = JsonParam::parse(std::string(R"({"a": [1, 2]})"));
+    EXPECT_EQ(::testing::internal::GetCapturedStderr(), "");
+
+    EXPECT_FALSE(bad);
+    EXPECT_EQ(bad.error().code, rapidjson::kParseErrorObjectMissName);
+    EXPECT_EQ(bad.error().offset, 8u);
+    EXPECT_FALSE(bad.value().isValid());
+    EXPECT_EQ(bad.error().message(), "Missing a name for object member. at offset 8");
+    EXPECT_EQ(empty.error().code, rapidjson::kParseErrorDocumentEmpty);
+    EXPECT_FALSE(insitu.ok());
+    EXPECT_EQ(insitu.error().offset, 5u);
+
+    ASSERT_TRUE(good.ok());
+    EXPECT_TRUE(good.error().message().empty());
+    JsonParam js = std::move(good).value();
+    EXPECT_EQ(js.get({"a", size_t(1)}, 0), 2);
+
+    // 构造函数保持原有行为，失败时输出同样的错误
+    ::testing::internal::CaptureStderr();
+    EXPECT_FALSE(JsonParam(R"({"a": 1,})").isValid());
+    EXPECT_EQ(::testing::internal::GetCapturedStderr(), "JSON parse error: " + bad.error().message() + "\n");
+}
+
+TEST(JsonParamTest, ParseStringPath) {
+    using cpputil::json::JsonPath;
+    auto elements = [](std::string_view text) {
+        std::optional<JsonPath> path = JsonPath::parse(text);
+        EXPECT_TRUE(path.has_value()) << text;
+        return path ? path->elements() : std::vector<JsonPath::PathElement>();
+    };
+    using E = std::vector<JsonPath::PathElement>;
+    using Token = JsonPath::NumericToken;
+
+    EXPECT_EQ(elements(""), E());
+    EXPECT_TRUE(JsonPath::parse("")->isRoot());
+    EXPECT_FALSE(JsonPath().isRoot());
+    EXPECT_EQ(elements("/user/scores/0"), (E{"user", "scores", Token{"0", 0}}));
+    EXPECT_EQ(elements("/a~1b/~0/"), (E{"a/b", "~", ""}));
+    EXPECT_EQ(elements("/01/-"), (E{"01", "-"}));
+    EXPECT_EQ(elements("user.scores[0]"), (E{"user", "scores", size_t(0)}));
+    EXPECT_EQ(elements("[2][10].x"), (E{size_t(2), size_t(10), "x"}));
+    EXPECT_EQ(elements("items[*].price"), (E{"items", JsonPath::kWildcard, "price"}));
+    EXPECT_EQ(elements(R"(a["x.y"]['it\'s']["\\"])"), (E{"a", "x.y", "it's", "\\"}));
+
+    for (const char* bad : {"/a~2", "/a~", ".a", "a.", "a..b", "a.[0]", "a[0]b", "a[", "a[]", "a[01]",
+                            "a[-1]", "a[x]", "a]", R"(a["x)", R"(a["x"y])", R"(a["\n"])",
+                            "a[99999999999999999999]"}) {
+        EXPECT_FALSE(JsonPath::parse(bad).has_value()) << bad;
+    }
+
+    cpputil::json::JsonParam js(R"({"user": {"scores": [7, 8]}, "a.b": {"c~d": 1}})");
+    EXPECT_EQ(js.get(*JsonPath::parse("/user/scores/1"), 0), 8);
+    EXPECT_EQ(js.get(*JsonPath::parse("user.scores[1]"), 0), 8);
+    EXPECT_EQ(js.get(*JsonPath::parse("/a.b/c~0d"), 0), 1);
+    EXPECT_EQ(js.get(*JsonPath::parse(R"(["a.b"]["c~d"])"), 0), 1);
+
+    // JSON Pointer 的数字段在对象上按 key 查找，在数组上按下标；"" 选中整个文档
+    cpputil::json::JsonParam ports(R"({"ports": {"8080": "http"}, "codes": {"404": ["nf"]}, "list": [5, 6]})");
+    EXPECT_EQ(ports.get(*JsonPath::parse("/ports/8080"), std::string()), "http");
+    EXPECT_EQ(ports.get(*JsonPath::parse("/codes/404/0"), std::string()), "nf");
+    EXPECT_EQ(ports.get(*JsonPath::parse("/list/1"), 0), 6);
+    EXPECT_EQ(ports.get(*JsonPath::parse(R"(ports["8080"])"), std::string()), "http");
+    EXPECT_FALSE(ports.has(*JsonPath::parse("/ports/443")));
+    EXPECT_TRUE(ports.has(*JsonPath::parse("")));
+
+    // 手工构造的下标与空路径保持原有规则
+    EXPECT_FALSE(ports.has({"ports", size_t(8080)}));
+    EXPECT_FALSE(ports.has(*JsonPath::parse("ports[8080]")));
+    EXPECT_FALSE(ports.has(JsonPath()));
+
+    // set 在已有对象上按 key 写入，不存在的容器按下标建成数组
+    EXPECT_TRUE(ports.set(*JsonPath::parse("/ports/443"), std::string("https")));
+    EXPECT_TRUE(ports.set(*JsonPath::parse("/fresh/1"), 1));
+    EXPECT_EQ(ports.toString({"ports"}), R"({"8080":"http","443":"https"})");
+    EXPECT_EQ(ports.get({"fresh"}, std::vector<int>()), (std::vector<int>{0, 1}));
+
+    // extract、投影解析与磁带视图遵循同样的规则
+    cpputil::json::JsonPathPlan plan({*JsonPath::parse("/ports/8080"), *JsonPath::parse("/list/0"),
+                                      JsonPath{"ports", size_t(8080)}, *JsonPath::parse("")});
+    cpputil::json::JsonPathResults results = ports.extract(plan);
+    EXPECT_EQ(results.get<std::string>(0), "http");
+    EXPECT_EQ(results.get<int>(1), 5);
+    EXPECT_FALSE(results.has(2));
+    EXPECT_TRUE(results.has(3));
+    cpputil::json::JsonParam projected =
+        cpputil::json::JsonParam::parseProjected(ports.toString(), {*JsonPath::parse("/ports/8080")});
+    EXPECT_EQ(projected.toString(), R"({"ports":{"8080":"http"}})");
+    cpputil::json::JsonTapeView tape(cpputil::json::JsonTapeView::encode(ports));
+    EXPECT_EQ(tape.get(*JsonPath::parse("/codes/404/0"), std::string()), "nf");
+    EXPECT_TRUE(tape.has(*JsonPath::parse("")));
+}
+
+TEST(JsonParamTest, PathCache) {
+    using cpputil::json::JsonPathCache;
+    JsonPathCache cache(JsonPathCache::kShards * 2);
+    cpputil::json::JsonParam js(R"({"user": {"scores": [7, 8]}})");
+
+    JsonPathCache::PathPtr first = cache.get("user.scores[1]");
+    ASSERT_TRUE(first);
+    EXPECT_EQ(js.get(*first, 0), 8);
+    EXPECT_EQ(cache.get("user.scores[1]"), first);
+    EXPECT_FALSE(cache.get("user..scores"));
+    EXPECT_FALSE(cache.get("user..scores"));
+    JsonPathCache::Stats stats = cache.stats();
+    EXPECT_EQ(stats.hits, 2u);
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.size, 2u);
+
+    // 超出容量后淘汰最久未用的条目，已取出的路径仍然有效
+    for (size_t i = 0; i < 1000; ++i) {
+        cache.get("/k" + std::to_string(i));
+    }
+    stats = cache.stats();
+    EXPECT_LE(stats.size, JsonPathCache::kShards * 2);
+    EXPECT_EQ(stats.size + stats.evictions, 1002u);
+    EXPECT_EQ(js.get(*first, 0), 8);
+
+    cache.clear();
+    EXPECT_EQ(cache.stats().size, 0u);
+
+    // 多线程并发查找同一组路径
+    std::vector<std::thread> threads;
+    std::atomic<int> sum{0};
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 1000; ++i) {
+                JsonPathCache::PathPtr path = cache.get(i % 2 ? "/user/scores/1" : "user.scores[0]");
+                sum += js.get(*path, 0);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(sum.load(), 4 * 500 * (7 + 8));
+    EXPECT_EQ(cache.stats().size, 2u);
+    EXPECT_EQ(&JsonPathCache::global(), &JsonPathCache::global());
+}
+
+TEST(JsonParamTest, FileRoundTrip) {
+    std::string path = ::testing::TempDir() + "json_file_round_trip.json";
+    cpputil::json::JsonParam js(R"({"user": {"name": "A\nB", "scores": [1, 2, 3]}, "ok": true})");
+    ASSERT_TRUE(js.toFile(path));
+
+    for (bool keep_mapping : {false, true}) {
+        cpputil::json::JsonParam loaded = cpputil::json::JsonParam::fromFile(path, keep_mapping);
+        EXPECT_TRUE(loaded.isValid());
+        EXPECT_EQ(loaded.get({"user", "name"}, std::string("")), "A\nB");
+        EXPECT_EQ(loaded.toString(), js.toString());
+    }
+
+    // 失败不做任何输出，错误写入 error
+    cpputil::json::JsonParseError error;
+    ::testing::internal::CaptureStderr();
+    EXPECT_FALSE(cpputil::json::JsonParam::fromFile(path + ".missing", false, &error).isValid());
+    EXPECT_STREQ(error.reason, "cannot open file");
+    std::string broken = ::testing::TempDir() + "json_file_broken.json";
+    ASSERT_TRUE(cpputil::json::JsonParam(R"({"a": 1})").toFile(broken));
+    ASSERT_EQ(::truncate(broken.c_str(), 5), 0);
+    for (bool keep_mapping : {false, true}) {
+        EXPECT_FALSE(cpputil::json::JsonParam::fromFile(broken, keep_mapping, &error).isValid());
+        EXPECT_FALSE(error.ok());
+        EXPECT_EQ(error.reason, nullptr);
+    }
+    EXPECT_TRUE(cpputil::json::JsonParam::fromFile(path, false, &error).isValid());
+    EXPECT_TRUE(error.ok());
+    EXPECT_EQ(::testing::internal::GetCapturedStderr(), "");
+}
+
+TEST(JsonParamTest, FromFileKeepMappingPageAligned) {
+    // 文件长度恰好是页大小的整数倍，原地解析依赖映射区之后的 '\0'
+    std::string text = R"({"key": "value"})";
+    text.resize(static_cast<size_t>(::sysconf(_SC_PAGESIZE)), ' ');
+    std::string path = ::testing::TempDir() + "json_file_page_aligned.json";
+    {
+        std::FILE* fp = std::fopen(path.c_str(), "wb");
+        ASSERT_NE(fp, nullptr);
+        std::fwrite(text.data(), 1, text.size(), fp);
+        std::fclose(fp);
+    }
+
+    cpputil::json::JsonParamPtr cloned;
+    {
+        cpputil::json::JsonParam loaded = cpputil::json::JsonParam::fromFile(path, true);
+        ASSERT_TRUE(loaded.isValid());
+        cloned = loaded.clone();
+    }
+    // 映射由拷贝继续持有
+    EXPECT_EQ(cloned->get({"key"}, std::string("")), "value");
+}
+
+TEST(JsonParamTest, WriteToTargets) {
+    cpputil::json::JsonParam js(R"({"user": {"name": "Alice", "tags": [1, 2]}, "ok": true})");
+    const std::string compact = R"({"user":{"name":"Alice","tags":[1,2]},"ok":true})";
+    EXPECT_EQ(js.toString(), compact);
+    EXPECT_EQ(js.toString({"user", "tags"}), "[1,2]");
+    EXPECT_EQ(js.toString({"missing"}), "");
+    EXPECT_EQ(js.toString({"user", "tags"}, 2), "[\n  1,\n  2\n]");
+    // 整个文档用 root()，其他空路径与 get 一样什么也不选
+    EXPECT_EQ(js.toString(cpputil::json::JsonPath::root()), compact);
+    EXPECT_EQ(js.toString(cpputil::json::JsonPath()), "");
+
+    // 追加到已有内容之后，子树同样可以追加
+    std::string out = "x";
+    EXPECT_TRUE(js.writeTo(out));
+    EXPECT_TRUE(js.writeTo(out, cpputil::json::JsonPath({"user", "name"})));
+    EXPECT_FALSE(js.writeTo(out, cpputil::json::JsonPath({"nope"})));
+    EXPECT_FALSE(js.writeTo(out, cpputil::json::JsonPathView()));
+    EXPECT_EQ(out, "x" + compact + "\"Alice\"");
+
+    // 定长缓冲区：放得下时完整写入，放不下时截断并返回所需长度
+    char buffer[128];
+    ASSERT_EQ(js.writeTo(buffer, sizeof(buffer)), compact.size());
+    EXPECT_EQ(std::string(buffer, compact.size()), compact);
+    char small[8];
+    EXPECT_EQ(js.writeTo(small, sizeof(small)), compact.size());
+    EXPECT_EQ(std::string(small, sizeof(small)), compact.substr(0, sizeof(small)));
+    EXPECT_EQ(js.writeTo(static_cast<char*>(nullptr), 0), compact.size());
+
+    // 分块回调，返回 false 时中止
+    std::string chunks;
+    EXPECT_TRUE(js.writeTo([&](std::string_view chunk) {
+        chunks.append(chunk.data(), chunk.size());
+        return true;
+    }, 4));
+    EXPECT_EQ(chunks, js.toString(4));
+    EXPECT_FALSE(js.writeTo([](std::string_view) { return false; }));
+
+    // FILE* 与文件描述符
+    std::string path = ::testing::TempDir() + "json_write_to.json";
+    std::FILE* fp = std::fopen(path.c_str(), "wb");
+    ASSERT_NE(fp, nullptr);
+    EXPECT_TRUE(js.writeTo(fp, 2));
+    std::fclose(fp);
+    EXPECT_EQ(cpputil::json::JsonParam::fromFile(path).toString(), compact);
+
+    cpputil::json::JsonParam invalid;
+    std::string untouched;
+    EXPECT_FALSE(invalid.writeTo(untouched));
+    EXPECT_EQ(invalid.writeTo(buffer, sizeof(buffer)), 0u);
+    EXPECT_FALSE(invalid.writeTo(stdout));
+    EXPECT_EQ(invalid.toString(), "");
+
+    // NaN 无法表示为 JSON：各个 writeTo 都报告失败，追加到字符串时不留下片段
+    cpputil::json::JsonParam nan(R"({"a": 1, "b": 2})");
+    ASSERT_TRUE(nan.set({"b"}, std::numeric_limits<double>::quiet_NaN()));
+    std::string kept = "x";
+    EXPECT_FALSE(nan.writeTo(kept));
+    EXPECT_FALSE(nan.writeTo(kept, cpputil::json::JsonPath({"b"})));
+    EXPECT_EQ(kept, "x");
+    EXPECT_EQ(nan.writeTo(buffer, sizeof(buffer)), 0u);
+    EXPECT_FALSE(nan.writeTo([](std::string_view) { return true; }));
+    fp = std::fopen(path.c_str(), "wb");
+    ASSERT_NE(fp, nullptr);
+    EXPECT_FALSE(nan.writeTo(fp));
+    std::fclose(fp);
+    EXPECT_FALSE(nan.toFile(path));
+    EXPECT_TRUE(nan.writeTo(kept, cpputil::json::JsonPath({"a"})));
+    EXPECT_EQ(kept, "x1");
+}
+
+TEST(JsonParamTest, WriteToLargeDocumentInChunks) {
+    // 超过一个块（64KB）的输出按块交出，拼接后与 toString 一致
+    cpputil::json::JsonParam js("[]");
+    for (int i = 0; i < 20000; ++i) {
+        js.set({static_cast<size_t>(i)}, std::string("value-") + std::to_string(i));
+    }
+    std::string expected = js.toString();
+    ASSERT_GT(expected.size(), 64u * 1024);
+
+    size_t calls = 0;
+    std::string joined;
+    EXPECT_TRUE(js.writeTo([&](std::string_view chunk) {
+        ++calls;
+        joined.append(chunk.data(), chunk.size());
+        return true;
+    }));
+    EXPECT_GT(calls, 1u);
+    EXPECT_EQ(joined, expected);
+}
+
+TEST(JsonParamTest, ParseProjected) {
+    using cpputil::json::JsonPath;
+    std::string text = R"({
+        "meta": {"id": 7, "tags": ["a", "b"]},
+        "items": [{"name": "x", "price": 1.5}, {"name": "y"}, {"name": "z", "price": 3}],
+        "big": {"blob": [1, 2, 3, {"deep": true}]}
+    })";
+
+    cpputil::json::JsonParam projected = cpputil::json::JsonParam::parseProjected(
+        text, {{"meta", "id"}, {"items", JsonPath::kWildcard, "price"}, {"missing", "x"}});
+    ASSERT_TRUE(projected.isValid());
+    EXPECT_EQ(projected.get({"meta", "id"}, 0), 7);
+    EXPECT_DOUBLE_EQ(projected.get({"items", size_t(0), "price"}, 0.0), 1.5);
+    EXPECT_DOUBLE_EQ(projected.get({"items", size_t(2), "price"}, 0.0), 3.0);
+    EXPECT_FALSE(projected.has({"big"}));
+    EXPECT_FALSE(projected.has({"missing"}));
+    EXPECT_EQ(projected.toString(), R"({"meta":{"id":7},"items":[{"price":1.5},null,{"price":3}]})");
+
+    // 具体下标之前的元素以 null 占位，命中的子树完整保留
+    cpputil::json::JsonParam indexed =
+        cpputil::json::JsonParam::parseProjected(text, {{"items", size_t(1)}, {"big"}});
+    EXPECT_EQ(indexed.toString(),
+              R"({"items":[null,{"name":"y"}],"big":{"blob":[1,2,3,{"deep":true}]}})");
+
+    // JsonPath::root() 选中整个文档，其他空路径与 get/has 一样什么也不选
+    EXPECT_EQ(cpputil::json::JsonParam::parseProjected(text, {JsonPath::root()}).toString(),
+              cpputil::json::JsonParam(text).toString());
+    EXPECT_EQ(cpputil::json::JsonParam::parseProjected(text, {*JsonPath::parse("")}).toString(),
+              cpputil::json::JsonParam(text).toString());
+    EXPECT_EQ(cpputil::json::JsonParam::parseProjected(text, {JsonPath{}}).toString(), "{}");
+    EXPECT_EQ(cpputil::json::JsonParam::parseProjected(text, {JsonPath{}, {"meta"}}).toString(),
+              cpputil::json::JsonParam::parseProjected(text, {{"meta"}}).toString());
+
+    cpputil::json::JsonParseError error;
+    ::testing::internal::CaptureStderr();
+    EXPECT_FALSE(cpputil::json::JsonParam::parseProjected(R"({"meta": )", {{"meta"}}, &error).isValid());
+    EXPECT_EQ(::testing::internal::GetCapturedStderr(), "");
+    EXPECT_EQ(error.code, rapidjson::kParseErrorValueInvalid);
+    EXPECT_EQ(error.offset, 9u);
+}
+
+TEST(JsonParamTest, ResetReusesArena) {
+    cpputil::json::JsonParam js;
+    EXPECT_EQ(js.retainedBytes(), 0u);
+    ASSERT_TRUE(js.reset(R"({"a": 1, "s": "short"})").ok());
+    EXPECT_EQ(js.get({"a"}, 0), 1);
+    size_t small = js.retainedBytes();
+    EXPECT_GT(small, 0u);
+
+    // 大文档溢出缓冲区后，下一次 reset 扩大缓冲区，此后保持不变
+    std::string big = "[";
+    for (int i = 0; i < 2000; ++i) {
+        big += (i ? ",\"" : "\"") + std::string(32, 'x') + std::to_string(i) + "\"";
+    }
+    big += "]";
+    ASSERT_TRUE(js.reset(big).ok());
+    ASSERT_TRUE(js.reset(big).ok());
+    size_t grown = js.retainedBytes();
+    EXPECT_GT(grown, small);
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(js.reset(big).ok());
+        EXPECT_EQ(js.retainedBytes(), grown);
+    }
+    EXPECT_EQ(js.get({size_t(1999)}, std::string("")), std::string(32, 'x') + "1999");
+
+    // 拷贝不共享内存区
+    cpputil::json::JsonParam copy(js);
+    ASSERT_TRUE(js.reset(R"({"b": [true]})").ok());
+    EXPECT_EQ(copy.get({size_t(0)}, std::string("")), std::string(32, 'x') + "0");
+    EXPECT_TRUE(js.get({"b", size_t(0)}, false));
+
+    // 解析失败不做任何输出，错误由返回值带回
+    ::testing::internal::CaptureStderr();
+    cpputil::json::JsonParseError error = js.reset("{bad");
+    EXPECT_EQ(::testing::internal::GetCapturedStderr(), "");
+    EXPECT_FALSE(error.ok());
+    EXPECT_EQ(error.code, rapidjson::kParseErrorObjectMissName);
+    EXPECT_FALSE(js.isValid());
+    ASSERT_TRUE(js.reset("[1]").ok());
+    EXPECT_EQ(js.toString(), "[1]");
+}
+
+// 测试规模不变的反复 reset 不再申请内存：分配器内存区和 DOM 构建栈都被复用
+TEST(JsonParamTest, ResetDoesNotAllocate) {
+    std::string doc = "[";
+    for (int i = 0; i < 200; ++i) {
+        doc += (i ? ",{\"id\": " : "{\"id\": ") + std::to_string(i) + R"(, "tags": [")" + std::string(24, 'x') +
+               R"(", [[[)" + std::to_string(i) + "]]]]}";
+    }
+    doc += "]";
+
+    // 前几次 reset 让内存区和构建栈增长到峰值
+    cpputil::json::JsonParam js;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(js.reset(doc).ok());
+    }
+    size_t retained = js.retainedBytes();
+
+    bool ok = true;
+    count_allocations = true;
+    allocation_count = 0;
+    for (int i = 0; i < 10; ++i) {
+        ok = js.reset(doc).ok() && ok;
+    }
+    count_allocations = false;
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(allocation_count, 0u);
+    EXPECT_EQ(js.retainedBytes(), retained);
+    EXPECT_EQ(js.get({size_t(199), "id"}, 0), 199);
+    EXPECT_EQ(js.get({size_t(7), "tags", size_t(1), size_t(0), size_t(0)}, std::vector<int>()), std::vector<int>{7});
+}
+
+TEST(JsonParamTest, ResetWithMemberIndex) {
+    cpputil::json::JsonParam js;
+    js.enableMemberIndex(2);
+    ASSERT_TRUE(js.reset(R"({"a": 1, "b": 2, "c": 3})").ok());
+    EXPECT_EQ(js.get({"c"}, 0), 3);
+    ASSERT_TRUE(js.reset(R"({"c": 30, "b": 20, "a": 10})").ok());
+    EXPECT_EQ(js.get({"c"}, 0), 30);
+    EXPECT_EQ(js.get({"a"}, 0), 10);
+
+    // arena 中的文档被深拷贝，拷贝保留索引设置但不沿用以来源地址为键的表：
+    // 来源反复 reset 复用内存后，拷贝覆盖已有成员仍不会追加重复的 key
+    auto copy = js.clone();
+    cpputil::json::JsonParam assigned;
+    assigned = js;
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_TRUE(js.reset(R"({"x": 1, "y": 2, "z": 3})").ok());
+    }
+    for (cpputil::json::JsonParam* target : {copy.get(), &assigned}) {
+        EXPECT_TRUE(target->memberIndexEnabled());
+        EXPECT_TRUE(target->set({"a"}, 11));
+        EXPECT_TRUE(target->set({"d"}, 40));
+        EXPECT_EQ(target->toString(), R"({"c":30,"b":20,"a":11,"d":40})");
+    }
+}
+
+TEST(JsonParamPoolTest, AcquireReleaseStats) {
+    cpputil::json::JsonParamPool pool(1);
+    {
+        auto first = pool.acquire(R"({"n": 1})");
+        auto second = pool.acquire(R"({"n": 2})");
+        EXPECT_EQ(first->get({"n"}, 0), 1);
+        EXPECT_EQ(second->get({"n"}, 0), 2);
+    }
+    auto stats = pool.stats();
+    EXPECT_EQ(stats.acquired, 2u);
+    EXPECT_EQ(stats.reused, 0u);
+    EXPECT_EQ(stats.released, 2u);
+    EXPECT_EQ(stats.dropped, 1u);
+    EXPECT_EQ(stats.idle, 1u);
+    EXPECT_GT(stats.retained_bytes, 0u);
+
+    {
+        auto again = pool.acquire(R"({"n": 3})");
+        EXPECT_EQ(again->get({"n"}, 0), 3);
+        EXPECT_EQ(pool.stats().idle, 0u);
+        EXPECT_EQ(pool.stats().retained_bytes, 0u);
+        cpputil::json::JsonParseError error;
+        ::testing::internal::CaptureStderr();
+        auto invalid = pool.acquire("{bad", &error);
+        EXPECT_EQ(::testing::internal::GetCapturedStderr(), "");
+        EXPECT_FALSE(invalid->isValid());
+        EXPECT_FALSE(error.ok());
+    }
+    stats = pool.stats();
+    EXPECT_EQ(stats.reused, 1u);
+    EXPECT_EQ(stats.released, 4u);
+
+    auto local = cpputil::json::JsonParamPool::local().acquire("[1, 2]");
+    EXPECT_EQ(local->toString(), "[1,2]");
+}
+
+TEST(JsonParamTest, BorrowedStringGetters) {
+    cpputil::json::JsonParam js(R"({"name": "Alice", "bin": "a\u0000b", "n": 1})");
+    std::string_view name = js.get<std::string_view>({"name"});
+    EXPECT_EQ(name, "Alice");
+    EXPECT_EQ(js.get<std::string_view>({"bin"}).size(), 3u);
+    EXPECT_EQ(js.get<std::string_view>({"n"}, "none"), "none");
+    EXPECT_STREQ(js.get<const char*>({"name"}), "Alice");
+    EXPECT_EQ(js.get<const char*>({"missing"}), nullptr);
+
+    // 借用的字符串指向文档内部，多次获取地址相同
+    EXPECT_EQ(js.get<std::string_view>({"name"}).data(), name.data());
+}
+
+TEST(JsonParamTest, ArrayView) {
+    cpputil::json::JsonParam js(R"({"scores": [90, 85.5, "x", 70], "tags": ["a", "bc"], "obj": {}})");
+    auto scores = js.get<cpputil::json::JsonArrayView<double>>({"scores"});
+    ASSERT_TRUE(scores.valid());
+    ASSERT_EQ(scores.size(), 4u);
+    EXPECT_DOUBLE_EQ(scores[0], 90.0);
+    EXPECT_DOUBLE_EQ(scores[1], 85.5);
+    EXPECT_DOUBLE_EQ(scores.at(2, -1.0), -1.0);
+    EXPECT_DOUBLE_EQ(scores.at(9, -1.0), -1.0);
+
+    double sum = 0;
+    for (double score : scores) {
+        sum += score;
+    }
+    EXPECT_DOUBLE_EQ(sum, 245.5);
+
+    auto tags = js.get<cpputil::json::JsonArrayView<std::string_view>>({"tags"});
+    std::vector<std::string_view> collected(tags.begin(), tags.end());
+    EXPECT_EQ(collected, (std::vector<std::string_view>{"a", "bc"}));
+
+    auto not_array = js.get<cpputil::json::JsonArrayView<int>>({"obj"});
+    EXPECT_FALSE(not_array.valid());
+    EXPECT_TRUE(not_array.empty());
+    EXPECT_FALSE(js.get<cpputil::json::JsonArrayView<int>>({"missing"}).valid());
+}
+
+#ifndef NDEBUG
+TEST(JsonParamDeathTest, ArrayViewDetectsMutation) {
+    cpputil::json::JsonParam js(R"({"a": [1, 2]})");
+    auto view = js.get<cpputil::json::JsonArrayView<int>>({"a"});
+    EXPECT_EQ(view.size(), 2u);
+    js.set({"b"}, 1);
+    EXPECT_DEATH(view.size(), "modified");
+}
+#endif
+
+TEST(JsonParamTest, GetNumbersBulk) {
+    cpputil::json::JsonParam js(
+        R"({"emb": [0.5, 1.25, -2.0], "mixed": [1, 2.5, 3000000000], "ints": [1, -2, 3],
+            "big": [1, 5000000000], "bad": [1, "2"], "empty": []})");
+
+    double buf[3];
+    EXPECT_EQ(js.getNumbers({"emb"}, buf, 3), 3u);
+    EXPECT_DOUBLE_EQ(buf[1], 1.25);
+    EXPECT_DOUBLE_EQ(buf[2], -2.0);
+    // 容量不足时只返回长度
+    EXPECT_EQ(js.getNumbers({"emb"}, buf, 2), 3u);
+    EXPECT_EQ(js.getNumbers({"bad"}, buf, 3), cpputil::json::JsonParam::npos);
+    EXPECT_EQ(js.getNumbers({"missing"}, buf, 3), cpputil::json::JsonParam::npos);
+    EXPECT_EQ(js.getNumbers<double>({"empty"}, nullptr, 0), 0u);
+
+    std::vector<float> floats;
+    ASSERT_TRUE(js.getNumbers({"mixed"}, floats));
+    EXPECT_EQ(floats, (std::vector<float>{1.0f, 2.5f, 3e9f}));
+
+    std::vector<int32_t> ints;
+    ASSERT_TRUE(js.getNumbers({"ints"}, ints));
+    EXPECT_EQ(ints, (std::vector<int32_t>{1, -2, 3}));
+    EXPECT_FALSE(js.getNumbers({"big"}, ints));
+    EXPECT_FALSE(js.getNumbers({"emb"}, ints));
+
+    std::vector<int64_t> longs;
+    ASSERT_TRUE(js.getNumbers({"big"}, longs));
+    EXPECT_EQ(longs, (std::vector<int64_t>{1, 5000000000LL}));
+
+    // get<vector<T>> 的批量路径与逐元素规则一致
+    EXPECT_EQ(js.get({"emb"}, std::vector<double>{}), (std::vector<double>{0.5, 1.25, -2.0}));
+    EXPECT_EQ(js.get({"mixed"}, std::vector<double>{}), (std::vector<double>{1.0, 2.5, 0.0}));
+    EXPECT_EQ(js.get({"ints"}, std::vector<int>{}), (std::vector<int>{1, -2, 3}));
+}
+
+namespace binding {
+
+struct Address {
+    std::string city;
+    int zip = 0;
+};
+CPPUTIL_JSON_FIELDS(Address, city, zip)
+
+struct User {
+    std::string name;
+    int age = 0;
+    double score = 0;
+    int64_t id = 0;
+    bool active = false;
+    std::vector<std::string> tags;
+    std::map<std::string, int> quota;
+    Address address;
+    std::vector<Address> history;
+    std::optional<std::string> nickname;
+};
+CPPUTIL_JSON_FIELDS(User, name, age, score, id, active, tags, quota, address, history, nickname)
+
+} // namespace binding
+
+TEST(JsonParamTest, StructBindingDecode) {
+    cpputil::json::JsonParam js(R"({"user": {
+        "name": "Alice", "age": 30, "score": 9, "id": 5000000000, "active": true,
+        "tags": ["a", "b"], "quota": {"cpu": 4},
+        "history": [{"city": "Paris", "zip": 75000}, {"zip": 10001, "city": "NYC"}],
+        "address": {"city": "Berlin", "zip": 10115}
+    }})");
+
+    binding::User user;
+    user.nickname = "keep";
+    ASSERT_TRUE(js.decode({"user"}, user));
+    EXPECT_EQ(user.name, "Alice");
+    EXPECT_EQ(user.age, 30);
+    EXPECT_DOUBLE_EQ(user.score, 9.0);
+    EXPECT_EQ(user.id, 5000000000LL);
+    EXPECT_TRUE(user.active);
+    EXPECT_EQ(user.tags, (std::vector<std::string>{"a", "b"}));
+    EXPECT_EQ(user.quota.at("cpu"), 4);
+    EXPECT_EQ(user.address.city, "Berlin");
+    ASSERT_EQ(user.history.size(), 2u);
+    EXPECT_EQ(user.history[1].city, "NYC");
+    EXPECT_EQ(user.history[1].zip, 10001);
+    // 缺失的字段保持原值
+    EXPECT_EQ(user.nickname, "keep");
+
+    binding::Address address;
+    EXPECT_FALSE(cpputil::json::JsonParam(R"({"city": 1, "zip": 2})")
+                     .decode(cpputil::json::JsonPathView::root(), address));
+    EXPECT_EQ(address.zip, 2);
+    EXPECT_FALSE(js.decode({"missing"}, address));
+    // 与 get 一样，root() 以外的空路径什么也不选
+    EXPECT_FALSE(js.decode({}, address));
+
+    // optional 类型不符时同样保持原值
+    user.nickname = "keep";
+    EXPECT_FALSE(cpputil::json::JsonParam(R"({"nickname": 5})").decode(cpputil::json::JsonPathView::root(), user));
+    EXPECT_EQ(user.nickname, "keep");
+
+    // 字段顺序与 JSON 不一致的大对象经成员索引查找
+    std::string wide = R"({"zip": 12345)";
+    for (int i = 0; i < 100; ++i) {
+        wide += ", \"pad" + std::to_string(i) + "\": " + std::to_string(i);
+    }
+    wide += R"(, "city": "Oslo"})";
+    cpputil::json::JsonParam indexed(wide);
+    indexed.enableMemberIndex(16);
+    binding::Address oslo;
+    ASSERT_TRUE(indexed.decode(cpputil::json::JsonPathView::root(), oslo));
+    EXPECT_EQ(oslo.city, "Oslo");
+    EXPECT_EQ(oslo.zip, 12345);
+}
+
+TEST(JsonParamTest, StructBindingEncode) {
+    binding::User user;
+    user.name = "Bob";
+    user.age = 41;
+    user.score = 1.5;
+    user.tags = {"x"};
+    user.quota = {{"mem", 8}};
+    user.address = {"Rome", 100};
+    EXPECT_EQ(cpputil::json::encode(user),
+              R"({"name":"Bob","age":41,"score":1.5,"id":0,"active":false,"tags":["x"],)"
+              R"("quota":{"mem":8},"address":{"city":"Rome","zip":100},"history":[]})");
+
+    user.nickname = "bobby";
+    binding::User decoded;
+    ASSERT_TRUE(cpputil::json::JsonParam(cpputil::json::encode(user)).decode(cpputil::json::JsonPathView::root(), decoded));
+    EXPECT_EQ(decoded.nickname, "bobby");
+    EXPECT_EQ(decoded.address.city, "Rome");
+    EXPECT_EQ(cpputil::json::encode(decoded), cpputil::json::encode(user));
+}
+
+TEST(JsonParamTest, PathPlanExtract) {
+    using cpputil::json::JsonPath;
+    // 第一个对象的 key 足够多，走成员扫描；重复 key 取第一次出现的值
+    cpputil::json::JsonParam js(R"({
+        "user": {"name": "Alice", "age": 30, "a": 1, "b": 2, "c": 3, "name": "dup"},
+        "scores": [90, 80, 70],
+        "meta": {"tags": ["x", "y"]}
+    })");
+    cpputil::json::JsonPathPlan plan({
+        {"user", "name"}, {"user", "age"}, {"user", "a"}, {"user", "b"}, {"user", "zzz"},
+        {"scores", size_t(2)}, {"scores", size_t(9)}, {"meta", "tags"}, {"scores"}, {},
+    });
+    ASSERT_EQ(plan.size(), 10u);
+
+    cpputil::json::JsonPathResults results = js.extract(plan);
+    ASSERT_EQ(results.size(), 10u);
+    EXPECT_EQ(results.get<std::string>(0), "Alice");
+    EXPECT_EQ(results.get<int>(1), 30);
+    EXPECT_EQ(results.get<int>(3), 2);
+    EXPECT_FALSE(results.has(4));
+    EXPECT_EQ(results.get<int>(4, -1), -1);
+    EXPECT_EQ(results.get<int>(5), 70);
+    EXPECT_FALSE(results.has(6));
+    EXPECT_EQ(results.get<std::vector<std::string>>(7), (std::vector<std::string>{"x", "y"}));
+    EXPECT_EQ(results.get<std::vector<int>>(8), (std::vector<int>{90, 80, 70}));
+    // 空路径与 has/get 一致，不选中根
+    EXPECT_FALSE(results.has(9));
+    EXPECT_EQ(results.has(9), js.has(JsonPath()));
+    EXPECT_EQ(results.get<int>(99, 7), 7);
+
+    // 结果与逐条 get 一致，包括启用成员索引时
+    js.enableMemberIndex(2);
+    std::string name;
+    int age = 0;
+    int a = 0;
+    int b = 0;
+    int missing = 42;
+    EXPECT_EQ(js.extractTo(plan, name, age, a, b, missing), 4u);
+    EXPECT_EQ(name, js.get({"user", "name"}, std::string()));
+    EXPECT_EQ(age, 30);
+    EXPECT_EQ(a + b, 3);
+    EXPECT_EQ(missing, 42);
+
+    EXPECT_EQ(cpputil::json::JsonParam().extract(plan).has(0), false);
+}
+
+// 测试 JSON Patch（RFC 6902）
+TEST(JsonParamTest, ApplyPatch) {
+    cpputil::json::JsonParam doc(R"({"a": {"b": "c"}, "list": [1, 2], "x~y": 1, "p/q": 2})");
+    
+    EXPECT_TRUE(doc.applyPatch(R"([
+        {"op": "add", "path": "/a/d", "value": [true]},
+        {"op": "add", "path": "/list/1", "value": 9},
+        {"op": "add", "path": "/list/-", "value": 3},
+        {"op": "replace", "path": "/x~0y", "value": "tilde"},
+        {"op": "remove", "path": "/p~1q"},
+        {"op": "test", "path": "/a/b", "value": "c"}
+    ])"));
+    EXPECT_EQ(doc.toString(), R"({"a":{"b":"c","d":[true]},"list":[1,9,2,3],"x~y":"tilde"})");
+    
+    EXPECT_TRUE(doc.applyPatch(R"([
+        {"op": "move", "from": "/a/d", "path": "/flags"},
+        {"op": "copy", "from": "/list", "path": "/a/list"},
+        {"op": "replace", "path": "/list/0", "value": 0},
+        {"op": "remove", "path": "/list/1"}
+    ])"));
+    EXPECT_EQ(doc.toString(), R"({"a":{"b":"c","list":[1,9,2,3]},"list":[0,2,3],"x~y":"tilde","flags":[true]})");
+    
+    // 任一操作失败时整个 patch 不生效
+    std::string before = doc.toString();
+    EXPECT_FALSE(doc.applyPatch(R"([
+        {"op": "add", "path": "/a/new", "value": 1},
+        {"op": "remove", "path": "/list/0"},
+        {"op": "test", "path": "/a/b", "value": "not c"}
+    ])"));
+    EXPECT_EQ(doc.toString(), before);
+    EXPECT_FALSE(doc.applyPatch(R"([{"op": "remove", "path": "/missing"}])"));
+    EXPECT_FALSE(doc.applyPatch(R"([{"op": "add", "path": "/list/9", "value": 1}])"));
+    EXPECT_FALSE(doc.applyPatch(R"([{"op": "move", "from": "/a", "path": "/a/b/c"}])"));
+    EXPECT_FALSE(doc.applyPatch(R"([{"op": "unknown", "path": ""}])"));
+    EXPECT_FALSE(doc.applyPatch(R"({"op": "remove", "path": "/a"})"));
+    EXPECT_EQ(doc.toString(), before);
+    
+    // 替换根节点
+    EXPECT_TRUE(doc.applyPatch(R"([{"op": "replace", "path": "", "value": {"root": 1}}])"));
+    EXPECT_EQ(doc.toString(), R"({"root":1})");
+
+    // 文本格式错误只返回 false，不输出解析错误
+    ::testing::internal::CaptureStderr();
+    EXPECT_FALSE(doc.applyPatch("[{"));
+    EXPECT_FALSE(doc.applyMergePatch("{"));
+    EXPECT_EQ(::testing::internal::GetCapturedStderr(), "");
+
+    // 目标无效时不接管右值 patch
+    cpputil::json::JsonParam invalid;
+    cpputil::json::JsonParam patch(R"([{"op": "add", "path": "/a", "value": 1}])");
+    EXPECT_FALSE(invalid.applyPatch(std::move(patch)));
+    EXPECT_TRUE(patch.isValid());
+    EXPECT_TRUE(doc.applyPatch(std::move(patch)));
+    EXPECT_EQ(doc.toString(), R"({"root":1,"a":1})");
+
+    // 失败的右值 patch 不被接管，仍然有效且内容不变
+    size_t anchors = doc.memoryUsage().anchors;
+    const std::string failing_text = R"([
+        {"op": "add", "path": "/nested", "value": {"list": ["a string long enough to live outside the value", 2]}},
+        {"op": "remove", "path": "/nested/list/0"},
+        {"op": "add", "path": "/nested/list/-", "value": "appended"},
+        {"op": "test", "path": "/root", "value": 2}
+    ])";
+    cpputil::json::JsonParam failing(failing_text);
+    const std::string failing_before = failing.toString();
+    EXPECT_FALSE(doc.applyPatch(std::move(failing)));
+    EXPECT_TRUE(failing.isValid());
+    EXPECT_EQ(failing.toString(), failing_before);
+    EXPECT_EQ(doc.toString(), R"({"root":1,"a":1})");
+    EXPECT_EQ(doc.memoryUsage().anchors, anchors);
+}
+
+// 测试 patch 不影响共享子树的克隆，右值版本移入值而不复制
+TEST(JsonParamTest, ApplyPatchSharedAndMoved) {
+    cpputil::json::JsonParam doc(R"({"config": {"limits": [1, 2, 3]}, "name": "base"})");
+    auto snapshot = doc.clone();
+    
+    cpputil::json::JsonParam patch(R"([{"op": "add", "path": "/config/owner", "value": "a string long enough to live outside the value"}])");
+    const char* moved_data = patch.get({size_t(0), "value"}, std::string_view()).data();
+    EXPECT_TRUE(doc.applyPatch(std::move(patch)));
+    EXPECT_FALSE(patch.isValid());
+    EXPECT_EQ(doc.get({"config", "owner"}, std::string_view()).data(), moved_data);
+    
+    EXPECT_TRUE(doc.applyPatch(R"([{"op": "remove", "path": "/config/limits/0"}])"));
+    EXPECT_EQ(doc.get({"config", "limits"}, std::vector<int>()), (std::vector<int>{2, 3}));
+    EXPECT_EQ(snapshot->toString(), R"({"config":{"limits":[1,2,3]},"name":"base"})");
+}
+
+// 测试 patch 原地修改，失败时按撤销记录恢复
+TEST(JsonParamTest, ApplyPatchRollback) {
+    std::string wide = "{";
+    for (int i = 0; i < 1000; ++i) {
+        wide += (i ? ", \"k" : "\"k") + std::to_string(i) + "\": " + std::to_string(i);
+    }
+    wide += R"(, "list": [0, 1, 2, 3], "nested": {"x": {"y": 1}}})";
+    cpputil::json::JsonParam doc(wide);
+    doc.enableMemberIndex(16);
+    const std::string before = doc.toString();
+
+    // 插入、删除、移动、替换根之后失败，逐步撤销回原样
+    EXPECT_FALSE(doc.applyPatch(R"([
+        {"op": "add", "path": "/list/1", "value": "inserted"},
+        {"op": "remove", "path": "/k10"},
+        {"op": "remove", "path": "/list/0"},
+        {"op": "move", "from": "/nested/x", "path": "/k500"},
+        {"op": "add", "path": "/extra", "value": {"z": 1}},
+        {"op": "replace", "path": "/k999", "value": [1, 2]},
+        {"op": "copy", "from": "/list", "path": "/nested/list"},
+        {"op": "replace", "path": "", "value": {"root": true}},
+        {"op": "test", "path": "/root", "value": false}
+    ])"));
+    EXPECT_EQ(doc.toString(), before);
+    EXPECT_EQ(doc.get({"k10"}, -1), 10);
+    EXPECT_EQ(doc.get({"k500"}, -1), 500);
+    EXPECT_FALSE(doc.has({"extra"}));
+    EXPECT_EQ(doc.get({"list"}, std::vector<int>()), (std::vector<int>{0, 1, 2, 3}));
+
+    // 与克隆共享时沿路径复制，回滚后克隆与文档都不受影响
+    auto snapshot = doc.clone();
+    EXPECT_FALSE(doc.applyPatch(R"([
+        {"op": "replace", "path": "/nested/x/y", "value": 2},
+        {"op": "add", "path": "/nested/x/w", "value": 3},
+        {"op": "remove", "path": "/k0"},
+        {"op": "remove", "path": "/missing"}
+    ])"));
+    EXPECT_EQ(doc.toString(), before);
+    EXPECT_EQ(snapshot->toString(), before);
+    EXPECT_TRUE(doc.applyPatch(R"([{"op": "replace", "path": "/nested/x/y", "value": 2}])"));
+    EXPECT_EQ(doc.get({"nested", "x", "y"}, -1), 2);
+    EXPECT_EQ(snapshot->get({"nested", "x", "y"}, -1), 1);
+
+    // 不再共享时修改不复制容器，宽对象上的 patch 不随成员数占用内存
+    cpputil::json::JsonParam wide_doc(wide);
+    size_t used = wide_doc.memoryUsage().used;
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(wide_doc.applyPatch(R"([{"op": "replace", "path": "/k1", "value": true}])"));
+        EXPECT_FALSE(wide_doc.applyPatch(R"([{"op": "remove", "path": "/k2"}, {"op": "remove", "path": "/k2"}])"));
+    }
+    EXPECT_LT(wide_doc.memoryUsage().used - used, 1000 * sizeof(rapidjson::Value));
+    EXPECT_EQ(wide_doc.get({"k2"}, -1), 2);
+}
+
+// 测试删空对象后索引不会残留：之后追加的成员复用同一块存储
+TEST(JsonParamTest, ApplyPatchRemoveLastIndexedMember) {
+    cpputil::json::JsonParam doc(R"({"obj": {"only": 1}, "merged": {"only": 1}})");
+    doc.enableMemberIndex(1);
+    EXPECT_TRUE(doc.applyPatch(R"([{"op": "remove", "path": "/obj/only"}])"));
+    EXPECT_TRUE(doc.set({"obj", "next"}, 2));
+    EXPECT_EQ(doc.get({"obj", "next"}, -1), 2);
+    EXPECT_TRUE(doc.set({"obj", "next"}, 3));
+    EXPECT_EQ(doc.toString({"obj"}), R"({"next":3})");
+
+    EXPECT_TRUE(doc.applyMergePatch(R"({"merged": {"only": null}})"));
+    EXPECT_TRUE(doc.set({"merged", "next"}, 2));
+    EXPECT_TRUE(doc.set({"merged", "next"}, 3));
+    EXPECT_EQ(doc.get({"merged", "next"}, -1), 3);
+    EXPECT_EQ(doc.get({"merged"}, std::map<std::string, int>{}).size(), 1u);
+}
+
+// 测试 JSON Merge Patch（RFC 7396）
+TEST(JsonParamTest, ApplyMergePatch) {
+    cpputil::json::JsonParam doc(R"({
+        "title": "Goodbye!",
+        "author": {"givenName": "John", "familyName": "Doe"},
+        "tags": ["example", "sample"],
+        "content": "This will be unchanged"
+    })");
+    cpputil::json::JsonParam patch(R"({
+        "title": "Hello!",
+        "phoneNumber": "+01-123-456-7890",
+        "author": {"familyName": null},
+        "tags": ["example"],
+        "extra": {"keep": 1, "drop": null}
+    })");
+    
+    EXPECT_TRUE(doc.applyMergePatch(patch));
+    EXPECT_EQ(doc.toString(),
+              R"({"title":"Hello!","author":{"givenName":"John"},"tags":["example"],)"
+              R"("content":"This will be unchanged","phoneNumber":"+01-123-456-7890","extra":{"keep":1}})");
+    EXPECT_TRUE(patch.isValid());
+    
+    // 非对象的 patch 整体替换
+    EXPECT_TRUE(doc.applyMergePatch(R"(["replaced"])"));
+    EXPECT_EQ(doc.toString(), R"(["replaced"])");
+    EXPECT_TRUE(doc.applyMergePatch(cpputil::json::JsonParam(R"({"a": {"b": null, "c": 1}})")));
+    EXPECT_EQ(doc.toString(), R"({"a":{"c":1}})");
+    
+    cpputil::json::JsonParam empty;
+    EXPECT_TRUE(empty.applyMergePatch(R"({"k": "v"})"));
+    EXPECT_EQ(empty.toString(), R"({"k":"v"})");
+    EXPECT_FALSE(empty.applyMergePatch("{"));
+}
+
+// 测试右值 update 移入节点而不复制，合并语义与 const 版本一致
+TEST(JsonParamTest, UpdateMovesNodes) {
+    std::string base = R"({"user": {"name": "Alice", "tags": ["a"]}, "version": 1})";
+    std::string overlay = R"({"user": {"tags": ["b"], "bio": "a string long enough to live outside the value"}, "version": 2})";
+    
+    cpputil::json::JsonParam expected(base);
+    expected.update(static_cast<const cpputil::json::JsonParam&>(cpputil::json::JsonParam(overlay)));
+    
+    cpputil::json::JsonParam doc(base);
+    auto snapshot = doc.clone();
+    cpputil::json::JsonParam other(overlay);
+    const char* bio = other.get({"user", "bio"}, std::string_view()).data();
+    EXPECT_TRUE(doc.update(std::move(other)));
+    EXPECT_FALSE(other.isValid());
+    EXPECT_EQ(doc.toString(), expected.toString());
+    EXPECT_EQ(doc.get({"user", "bio"}, std::string_view()).data(), bio);
+    EXPECT_EQ(snapshot->toString(), cpputil::json::JsonParam(base).toString());
+    
+    // 移入的节点之后可以照常修改
+    EXPECT_TRUE(doc.set({"user", "tags", size_t(2)}, std::string("c")));
+    EXPECT_EQ(doc.get({"user", "tags"}, std::vector<std::string>()), (std::vector<std::string>{"a", "b", "c"}));
+    
+    cpputil::json::JsonParam empty;
+    EXPECT_TRUE(empty.update(cpputil::json::JsonParam(overlay)));
+    EXPECT_EQ(empty.get({"version"}, 0), 2);
+    EXPECT_FALSE(empty.update(cpputil::json::JsonParam()));
+}
+
+// 测试 mergeAll 与逐个 update 的结果一致
+TEST(JsonParamTest, MergeAllMatchesSequentialUpdate) {
+    std::vector<std::string> overlays = {
+        R"({"a": {"x": 1, "list": [1]}, "b": "scalar", "c": {"deep": {"k": 1}}})",
+        R"({"a": {"y": 2, "list": [2, 3]}, "b": {"now": "object"}, "d": [1]})",
+        R"({"a": "replaced", "b": {"more": true}, "c": {"deep": {"k": 2, "j": 3}}, "e": null})",
+        R"({"a": {"z": 3}, "d": {"not": "array"}, "c": {"deep": [1, 2]}})",
+        R"({"c": {"deep": [3]}, "f": {"g": {"h": "new"}}})",
+    };
+    std::string base = R"({"a": {"w": 0}, "keep": {"big": [1, 2, 3]}, "c": {"deep": {"k": 0}, "other": 1}})";
+    
+    std::vector<cpputil::json::JsonParam> layers;
+    for (const auto& overlay : overlays) {
+        layers.emplace_back(overlay);
+    }
+    std::vector<const cpputil::json::JsonParam*> sources;
+    for (const auto& layer : layers) {
+        sources.push_back(&layer);
+    }
+    
+    cpputil::json::JsonParam expected(base);
+    for (const auto& layer : layers) {
+        expected.update(layer);
+    }
+    
+    for (size_t threads : {size_t(1), size_t(4)}) {
+        cpputil::json::JsonParam doc(base);
+        auto snapshot = doc.clone();
+        EXPECT_TRUE(doc.mergeAll(sources, threads));
+        EXPECT_EQ(doc.toString(), expected.toString()) << "threads = " << threads;
+        EXPECT_EQ(snapshot->toString(), cpputil::json::JsonParam(base).toString());
+        // 合并结果之后可以照常修改
+        EXPECT_TRUE(doc.set({"c", "deep", size_t(3)}, 4));
+        EXPECT_EQ(doc.get({"c", "deep"}, std::vector<int>()), (std::vector<int>{1, 2, 3, 4}));
+    }
+    
+    // 线程的分配器在反复并行合并间复用，anchors_ 不随调用次数增长；
+    // 快照与复用的分配器共享存储，之后的合并不影响它
+    cpputil::json::JsonParam repeated(base);
+    size_t anchors = repeated.memoryUsage().anchors;
+    EXPECT_TRUE(repeated.mergeAll(sources, 4));
+    size_t after_first = repeated.memoryUsage().anchors;
+    EXPECT_LE(after_first, anchors + 4);
+    auto merged_once = repeated.clone();
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(repeated.mergeAll(sources, 4));
+    }
+    EXPECT_EQ(repeated.memoryUsage().anchors, after_first);
+    EXPECT_EQ(repeated.get({"f", "g", "h"}, std::string()), "new");
+    EXPECT_EQ(merged_once->toString(), expected.toString());
+    
+    // 无效文档从空开始，无效来源被跳过
+    cpputil::json::JsonParam invalid_source("{");
+    cpputil::json::JsonParam empty;
+    EXPECT_FALSE(empty.mergeAll({&layers[0], nullptr, &invalid_source, &layers[1]}));
+    cpputil::json::JsonParam partial(layers[0]);
+    partial.update(layers[1]);
+    EXPECT_EQ(empty.toString(), partial.toString());
+    
+    // 自身作为来源时按合并前的内容参与
+    cpputil::json::JsonParam self(R"({"list": [1]})");
+    EXPECT_TRUE(self.mergeAll({&self, &self}));
+    EXPECT_EQ(self.toString(), R"({"list":[1,1,1]})");
+}
+
+// 测试 AtomicJsonParam 的发布与读取
+TEST(AtomicJsonParamTest, StoreAndRead) {
+    cpputil::json::AtomicJsonParam holder;
+    EXPECT_EQ(holder.get(), nullptr);
+    EXPECT_EQ(holder.load(), nullptr);
+    
+    uint64_t version = holder.version();
+    holder.store(cpputil::json::JsonParam(R"({"version": 1})"));
+    EXPECT_GT(holder.version(), version);
+    ASSERT_NE(holder.get(), nullptr);
+    EXPECT_EQ(holder.get()->get({"version"}, 0), 1);
+    
+    // 长期持有的快照不受后续发布影响
+    cpputil::json::JsonSnapshot first = holder.load();
+    holder.store(std::make_shared<const cpputil::json::JsonParam>(R"({"version": 2})"));
+    EXPECT_EQ(holder.get()->get({"version"}, 0), 2);
+    EXPECT_EQ(first->get({"version"}, 0), 1);
+    
+    // 同一线程读多个持有者时各自缓存
+    cpputil::json::AtomicJsonParam other(std::make_shared<const cpputil::json::JsonParam>(R"({"name": "other"})"));
+    EXPECT_EQ(other.get()->get({"name"}, std::string()), "other");
+    EXPECT_EQ(holder.get()->get({"version"}, 0), 2);
+}
+
+// 测试线程缓存持有的旧版本可以主动放下
+TEST(AtomicJsonParamTest, ReleaseThreadCache) {
+    auto first = std::make_shared<const cpputil::json::JsonParam>(R"({"version": 1})");
+    std::weak_ptr<const cpputil::json::JsonParam> watch = first;
+    cpputil::json::AtomicJsonParam holder(std::move(first));
+    EXPECT_EQ(holder.get()->get({"version"}, 0), 1);
+
+    // 发布后本线程在下一次读取前仍持有旧版本
+    holder.store(cpputil::json::JsonParam(R"({"version": 2})"));
+    EXPECT_FALSE(watch.expired());
+    holder.release();
+    EXPECT_TRUE(watch.expired());
+    EXPECT_EQ(holder.get()->get({"version"}, 0), 2);
+
+    watch = holder.load();
+    holder.store(cpputil::json::JsonParam(R"({"version": 3})"));
+    cpputil::json::AtomicJsonParam::releaseThreadCache();
+    EXPECT_TRUE(watch.expired());
+    EXPECT_EQ(holder.get()->get({"version"}, 0), 3);
+
+    // 已析构的持有者的版本在下一次未命中时释放
+    auto temporary = std::make_unique<cpputil::json::AtomicJsonParam>(
+        std::make_shared<const cpputil::json::JsonParam>(R"({"temporary": true})"));
+    EXPECT_TRUE(temporary->get()->get({"temporary"}, false));
+    watch = temporary->load();
+    temporary.reset();
+    EXPECT_FALSE(watch.expired());
+    holder.store(cpputil::json::JsonParam(R"({"version": 4})"));
+    EXPECT_EQ(holder.get()->get({"version"}, 0), 4);
+    EXPECT_TRUE(watch.expired());
+}
+
+// 测试读者并发读取时写者发布新版本
+TEST(AtomicJsonParamTest, ConcurrentReaders) {
+    cpputil::json::AtomicJsonParam holder(std::make_shared<const cpputil::json::JsonParam>(R"({"v": 0, "w": 0})"));
+    std::atomic<bool> done(false);
+    std::atomic<bool> consistent(true);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&]() {
+            int last = 0;
+            while (!done.load()) {
+                const cpputil::json::JsonParam* current = holder.get();
+                int v = current->get({"v"}, -1);
+                // 每个版本内部一致，且版本不会倒退
+                if (v != current->get({"w"}, -2) || v < last) {
+                    consistent = false;
+                }
+                last = v;
+            }
+        });
+    }
+    for (int v = 1; v <= 200; ++v) {
+        cpputil::json::JsonParam next("{}");
+        next.set({"v"}, v);
+        next.set({"w"}, v);
+        holder.store(std::move(next));
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_TRUE(consistent.load());
+    EXPECT_EQ(holder.get()->get({"v"}, 0), 200);
+}
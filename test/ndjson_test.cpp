@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include "lib/ndjson.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <limits>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace cpputil {
+namespace json {
+namespace {
+
+// 生成 count 行 {"id": i, "name": "n<i>"}
+std::string makeLines(size_t count) {
+    std::string text;
+    for (size_t i = 0; i < count; ++i) {
+        text += "{\"id\": " + std::to_string(i) + ", \"name\": \"n" + std::to_string(i) + "\"}\n";
+    }
+    return text;
+}
+
+TEST(NdjsonReaderTest, ParsesInOrderAcrossThreads) {
+    std::string text = makeLines(2000);
+    NdjsonReader reader(4);
+    std::vector<JsonParam> records = reader.parse(text);
+    ASSERT_EQ(records.size(), 2000u);
+    for (size_t i = 0; i < records.size(); ++i) {
+        EXPECT_EQ(records[i].get({"id"}, -1), static_cast<int>(i));
+    }
+}
+
+TEST(NdjsonReaderTest, SkipsEmptyLinesAndHandlesCrlf) {
+    NdjsonReader reader(2);
+    std::vector<JsonParam> records = reader.parse("{\"a\": 1}\r\n\n\r\n[2]\n{bad}\n\"last\"");
+    ASSERT_EQ(records.size(), 4u);
+    EXPECT_EQ(records[0].get({"a"}, 0), 1);
+    EXPECT_EQ(records[1].toString(), "[2]");
+    EXPECT_FALSE(records[2].isValid());
+    EXPECT_EQ(records[3].toString(), "\"last\"");
+    EXPECT_TRUE(reader.parse("").empty());
+}
+
+TEST(NdjsonReaderTest, CallbackDeliversInOrder) {
+    std::string text = makeLines(20000);
+    NdjsonReader reader(3);
+    int expected = 0;
+    reader.parse(text, [&](JsonParam&& record) {
+        EXPECT_EQ(record.get({"id"}, -1), expected);
+        ++expected;
+    });
+    EXPECT_EQ(expected, 20000);
+}
+
+TEST(NdjsonReaderTest, ReusedFromSeveralThreads) {
+    std::string text = makeLines(3000);
+    NdjsonReader reader(4);
+    NdjsonReader copy = reader;
+    std::vector<std::thread> threads;
+    std::vector<size_t> good(4, 0);
+    for (size_t t = 0; t < good.size(); ++t) {
+        threads.emplace_back([&, t] {
+            const NdjsonReader& r = t % 2 ? copy : reader;
+            for (int round = 0; round < 5; ++round) {
+                std::vector<JsonParam> records = r.parse(text);
+                for (size_t i = 0; i < records.size(); ++i) {
+                    good[t] += records[i].get({"id"}, -1) == static_cast<int>(i) ? 1 : 0;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (size_t count : good) {
+        EXPECT_EQ(count, 5u * 3000u);
+    }
+}
+
+TEST(NdjsonWriterTest, RoundTripThroughFile) {
+    std::string path = ::testing::TempDir() + "ndjson_round_trip.ndjson";
+    NdjsonReader reader(4);
+    std::vector<JsonParam> records = reader.parse(makeLines(1000));
+    {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        ASSERT_GE(fd, 0);
+        NdjsonWriter writer(fd, 4);
+        EXPECT_TRUE(writer.write(JsonParam(R"({"head": true})")));
+        EXPECT_TRUE(writer.write(records));
+        EXPECT_FALSE(writer.write(JsonParam("{bad")));
+        EXPECT_TRUE(writer.flush());
+        ::close(fd);
+    }
+
+    std::vector<JsonParam> loaded;
+    ASSERT_TRUE(reader.parseFile(path, loaded));
+    ASSERT_EQ(loaded.size(), 1001u);
+    EXPECT_TRUE(loaded[0].get({"head"}, false));
+    for (size_t i = 0; i < records.size(); ++i) {
+        EXPECT_EQ(loaded[i + 1].toString(), records[i].toString());
+    }
+
+    ::testing::internal::CaptureStderr();
+    EXPECT_FALSE(reader.parseFile(path + ".missing", loaded));
+    EXPECT_EQ(errno, ENOENT);
+    EXPECT_EQ(::testing::internal::GetCapturedStderr(), "");
+}
+
+TEST(NdjsonWriterTest, SerializeMatchesToString) {
+    std::vector<JsonParam> records;
+    records.emplace_back(R"({"a": [1, 2]})");
+    records.emplace_back("null");
+    EXPECT_EQ(NdjsonWriter::serialize(records), "{\"a\":[1,2]}\nnull\n");
+    EXPECT_EQ(NdjsonWriter::serialize({}), "");
+
+    // 无法序列化的记录整条跳过，不留下半行
+    JsonParam nan(R"({"x": 1})");
+    ASSERT_TRUE(nan.set({"x"}, std::numeric_limits<double>::quiet_NaN()));
+    records.push_back(std::move(nan));
+    EXPECT_EQ(NdjsonWriter::serialize(records), "{\"a\":[1,2]}\nnull\n");
+}
+
+} // namespace
+} // namespace json
+} // namespace cpputil